@@ -1,10 +1,12 @@
 #include <string.h>         // Para funções de manipulação de strings como strlen, strncmp
+#include <strings.h>        // strncasecmp (nomes de cabeçalhos HTTP não diferenciam maiúsculas)
 #include "pico/stdlib.h"     // Funções padrão do SDK do Pico (timers, stdio se usado, etc.)
 #include "pico/cyw43_arch.h" // Para controle do chip Wi-Fi CYW43 (conexão Wi-Fi, LEDs da placa)
 #include "hardware/gpio.h"   // Para controle direto dos pinos GPIO
 #include "pico/time.h"       // Para funções de temporização (busy_wait_us, time_us_32)
 #include <stdio.h>          // Necessário para sprintf/snprintf (formatação de strings)
 #include "lwip/tcp.h"        // Para a pilha TCP/IP LwIP (funções do servidor TCP)
+#include "assets_web.h"      // Dashboard comprimido em gzip, gerado no build por gerar_assets.py
 
 // --- Configurações Globais do Projeto ---
 #define WIFI_SSID "copelli4"                // nome da sua rede Wi-Fi
@@ -13,6 +15,11 @@
 #define PINO_LED_OK 12                      // Pino GPIO para o LED de indicação de status OK
 #define PORTA_TCP 8081                      // Porta TCP onde o servidor web escutará por conexões
 #define TIMEOUT_CONEXAO_WIFI_MS 30000       // Tempo máximo (em milissegundos) para tentar conectar ao Wi-Fi
+#define CACHE_CONTROL_ASSETS "no-cache"     // O navegador guarda o dashboard, mas revalida a ETag a cada carga (resposta 304)
+#define MAX_CONEXOES_HTTP 6                 // Conexões atendidas ao mesmo tempo (os navegadores abrem até 6 por servidor)
+#define INTERVALO_POLL_HTTP 4               // server_poll_cb a cada 4 x 500ms
+#define MAX_VOLTAS_SEM_PROGRESSO 5          // Conexão parada por ~10s é abortada (libera a posição)
+#define INTERVALO_LEITURA_DHT11_MS 2000     // O DHT11 precisa de 1-2s entre leituras; /dados e /status servem a última
 
 // --- Configurações dos Pinos GPIO para Sensores ---
 #define PINO_BOTAO 5                        // Pino GPIO conectado ao botão
@@ -54,9 +61,27 @@ static const char *g_template_html =
     "<p><span class=\"label\">Umidade:</span>%.1f %%</p>"                          // Placeholder para umidade
     "</body></html>";
 
-// --- Estado Global do Servidor TCP ---
-static struct tcp_pcb *g_pcb_cliente = NULL; // Ponteiro para o Bloco de Controle de Protocolo (PCB) da conexão do cliente atual
+// --- Estado do Servidor TCP ---
+// O navegador busca index.html, o CSS e os scripts do dashboard em paralelo, e ainda
+// /dados a cada segundo, cada um em sua própria conexão ("Connection: close"). Cada
+// conexão tem seu estado em g_conexoes, ligado ao PCB por tcp_arg.
+typedef struct {
+    struct tcp_pcb *pcb;                 // NULL = posição livre
+    const uint8_t *corpo_pendente;       // Parte do asset (na flash) ainda não entregue ao LwIP
+    uint32_t bytes_pendentes;            // Quantos bytes do asset ainda faltam entregar
+    uint8_t voltas_sem_progresso;        // Chamadas de server_poll_cb sem nada recebido ou confirmado
+} conexao_http_t;
+
+static conexao_http_t g_conexoes[MAX_CONEXOES_HTTP];
 static struct tcp_pcb *g_pcb_escuta = NULL;  // Ponteiro para o PCB do servidor que está escutando por novas conexões
+static char g_requisicao_http[1024];         // Cópia da requisição recebida (os callbacks nunca rodam ao mesmo tempo)
+static char g_cabecalho_http[320];           // Cabeçalhos das respostas curtas (copiados pelo LwIP no tcp_write)
+
+// --- Última Leitura dos Sensores ---
+// O DHT11 é lido no loop principal a cada INTERVALO_LEITURA_DHT11_MS (a leitura ocupa a CPU
+// por ~25ms); os callbacks do servidor só copiam o resultado guardado aqui.
+static leitura_dht11_t g_ultima_leitura_dht;
+static bool g_ultima_leitura_dht_ok = false;
 
 // --- Funções Auxiliares ---
 /**
@@ -166,11 +191,15 @@ bool ler_dht11(leitura_dht11_t *resultado) {
 
 // --- Funções do Servidor TCP ---
 /**
- * Fecha de forma segura a conexão TCP com um cliente.
- * Limpa os callbacks e fecha o PCB.
- * pcb_a_fechar O PCB da conexão do cliente a ser fechada.
+ * Fecha de forma segura a conexão TCP com um cliente e libera sua posição em g_conexoes.
+ * Limpa os callbacks e fecha o PCB; se o fechamento normal falhar (falta de memória), aborta.
+ * conexao A conexão a ser fechada.
+ * err_t ERR_OK se fechou, ERR_ABRT se precisou abortar. Um callback do LwIP que chamou
+ * esta função deve retornar esse valor (depois de tcp_abort o PCB não existe mais).
  */
-static void fechar_conexao_cliente(struct tcp_pcb *pcb_a_fechar) {
+static err_t fechar_conexao_cliente(conexao_http_t *conexao) {
+    struct tcp_pcb *pcb_a_fechar = conexao->pcb;
+    err_t resultado = ERR_OK;
     if (pcb_a_fechar) {
         // Remove todos os callbacks e argumentos associados ao PCB
         tcp_arg(pcb_a_fechar, NULL);
@@ -178,132 +207,338 @@ static void fechar_conexao_cliente(struct tcp_pcb *pcb_a_fechar) {
         tcp_recv(pcb_a_fechar, NULL);
         tcp_err(pcb_a_fechar, NULL);
         tcp_poll(pcb_a_fechar, NULL, 0);
-        
+
         // Tenta fechar a conexão
         if (tcp_close(pcb_a_fechar) != ERR_OK) {
             tcp_abort(pcb_a_fechar); // Se o fechamento normal falhar, aborta a conexão
+            resultado = ERR_ABRT;
         }
     }
-    // Se o PCB fechado era o cliente ativo global, zera a referência global
-    if (pcb_a_fechar == g_pcb_cliente) {
-        g_pcb_cliente = NULL;
-    }
+    conexao->pcb = NULL;               // Libera a posição
+    conexao->bytes_pendentes = 0;      // Descarta o que faltava enviar do asset
+    return resultado;
 }
 
 /**
  * Callback chamado pela pilha LwIP quando ocorre um erro na conexão TCP.
- * arg Argumento definido pelo usuário 
+ * arg A conexao_http_t da conexão.
  * Código do erro LwIP.
  */
 static void server_err_cb(void *arg, err_t err) {
-    if (g_pcb_cliente != NULL) { // Se havia um cliente ativo
-        g_pcb_cliente = NULL;    // Zera a referência, pois a conexão está com erro
+    conexao_http_t *conexao = (conexao_http_t *)arg;
+    if (conexao) {
+        conexao->pcb = NULL;           // O PCB já foi liberado pelo LwIP: apenas libera a posição
+        conexao->bytes_pendentes = 0;
     }
     pisca_led(PINO_LED_ERRO, 3, 150); // Sinaliza o erro de conexão piscando o LED
 }
 
+/**
+ * Entrega ao LwIP o máximo possível do corpo pendente (asset na flash), respeitando
+ * o espaço livre no buffer de envio. O restante é enviado em server_sent_cb, à medida
+ * que o cliente confirma (ACK) os segmentos anteriores.
+ * conexao A conexão.
+ */
+static void enviar_corpo_pendente(conexao_http_t *conexao) {
+    struct tcp_pcb *tpcb = conexao->pcb;
+    while (conexao->bytes_pendentes > 0) {
+        uint32_t tamanho_trecho = tcp_sndbuf(tpcb);
+        if (tamanho_trecho > conexao->bytes_pendentes) tamanho_trecho = conexao->bytes_pendentes;
+        if (tamanho_trecho > 0xFFFF) tamanho_trecho = 0xFFFF; // tcp_write aceita no máximo u16_t
+        if (tamanho_trecho == 0) break; // Buffer cheio: continua no próximo ACK
+
+        // Sem TCP_WRITE_FLAG_COPY: os dados estão na flash e permanecem válidos até o ACK
+        if (tcp_write(tpcb, conexao->corpo_pendente, (u16_t)tamanho_trecho, 0) != ERR_OK) break;
+        conexao->corpo_pendente += tamanho_trecho;
+        conexao->bytes_pendentes -= tamanho_trecho;
+    }
+    tcp_output(tpcb);
+}
+
 /**
  * Callback chamado pela pilha LwIP após os dados enviados via tcp_write()
  * serem confirmados (ACKed) pelo cliente.
- * arg Argumento definido pelo usuário.
+ * arg A conexao_http_t da conexão.
  * tpcb O PCB da conexão.
  * len O número de bytes confirmados como enviados.
  * err_t ERR_OK se tudo correu bem.
  */
 static err_t server_sent_cb(void *arg, struct tcp_pcb *tpcb, u16_t len) {
+    conexao_http_t *conexao = (conexao_http_t *)arg;
+    conexao->voltas_sem_progresso = 0;
+    if (conexao->bytes_pendentes > 0) { // Ainda há parte do asset para enviar
+        enviar_corpo_pendente(conexao);
+        return ERR_OK;
+    }
     pisca_led(PINO_LED_OK, 1, 20); // Pisca LED OK rapidamente para indicar sucesso no envio
-    fechar_conexao_cliente(tpcb);   // Fecha a conexão, pois a resposta foi enviada
+    return fechar_conexao_cliente(conexao); // A resposta foi enviada (o LwIP ainda entrega o que estiver na fila)
+}
+
+/**
+ * Callback periódico do LwIP (a cada INTERVALO_POLL_HTTP x 500ms). Retoma o envio de um
+ * asset se um tcp_write falhou por falta de memória e aborta conexões paradas (cliente que
+ * conectou e não mandou a requisição, ou que parou de confirmar), para que não ocupem
+ * uma posição de g_conexoes indefinidamente.
+ * arg A conexao_http_t da conexão.
+ * tpcb O PCB da conexão.
+ * err_t ERR_OK, ou ERR_ABRT se a conexão foi abortada.
+ */
+static err_t server_poll_cb(void *arg, struct tcp_pcb *tpcb) {
+    conexao_http_t *conexao = (conexao_http_t *)arg;
+    if (++conexao->voltas_sem_progresso >= MAX_VOLTAS_SEM_PROGRESSO) {
+        tcp_arg(tpcb, NULL);
+        tcp_err(tpcb, NULL);               // tcp_abort chamaria server_err_cb
+        tcp_abort(tpcb);                   // Conexão parada: libera o PCB na hora (RST)
+        conexao->pcb = NULL;               // ... e a posição
+        conexao->bytes_pendentes = 0;
+        return ERR_ABRT;
+    }
+    if (conexao->bytes_pendentes > 0) enviar_corpo_pendente(conexao);
     return ERR_OK;
 }
 
+/**
+ * Envia uma resposta curta, montada na RAM (cabeçalhos + corpo opcional), e agenda o fechamento.
+ * conexao A conexão.
+ * resposta Texto completo da resposta HTTP.
+ * tamanho Número de bytes de `resposta`.
+ * err_t ERR_OK, ou ERR_ABRT se a conexão teve de ser abortada.
+ */
+static err_t enviar_resposta(conexao_http_t *conexao, const char *resposta, int tamanho) {
+    err_t erro_ao_escrever = tcp_write(conexao->pcb, resposta, tamanho, TCP_WRITE_FLAG_COPY);
+    if (erro_ao_escrever != ERR_OK) {
+        pisca_led(PINO_LED_ERRO, 4, 100); // Erro ao tentar escrever para o socket TCP
+        return fechar_conexao_cliente(conexao);
+    }
+    tcp_output(conexao->pcb); // Tenta enviar os dados imediatamente
+    return ERR_OK;            // server_sent_cb fecha a conexão quando o envio for confirmado
+}
+
+/**
+ * Verifica se o cabeçalho `nome` da requisição contém o texto `valor` (ex.: a ETag em If-None-Match).
+ * O nome é comparado sem diferenciar maiúsculas (como manda o HTTP) e só no início de uma
+ * linha de cabeçalho; o valor é procurado apenas dentro dessa linha.
+ * requisicao Requisição HTTP terminada em '\0'.
+ * nome Nome do cabeçalho, com os dois-pontos (ex.: "If-None-Match:").
+ * true Se o cabeçalho existir e o valor aparecer na mesma linha.
+ */
+static bool cabecalho_contem(const char *requisicao, const char *nome, const char *valor) {
+    size_t tamanho_nome = strlen(nome);
+    size_t tamanho_valor = strlen(valor);
+    // A primeira linha é a da requisição ("GET / HTTP/1.1"); os cabeçalhos vêm depois de cada "\r\n"
+    for (const char *linha = strstr(requisicao, "\r\n"); linha; linha = strstr(linha, "\r\n")) {
+        linha += 2;
+        const char *fim_linha = strstr(linha, "\r\n");
+        if (!fim_linha) fim_linha = linha + strlen(linha); // Requisição truncada em g_requisicao_http
+        if (fim_linha == linha) return false;              // Linha vazia: fim dos cabeçalhos
+        if ((size_t)(fim_linha - linha) < tamanho_nome || strncasecmp(linha, nome, tamanho_nome) != 0) continue;
+        for (const char *p = linha + tamanho_nome; p + tamanho_valor <= fim_linha; ++p) {
+            if (memcmp(p, valor, tamanho_valor) == 0) return true;
+        }
+        return false;
+    }
+    return false;
+}
+
+/**
+ * Procura um arquivo do dashboard embutido na flash pelo caminho da requisição.
+ * "/" é tratado como "/index.html".
+ * asset_web_t* O asset encontrado, ou NULL.
+ */
+static const asset_web_t *buscar_asset(const char *caminho) {
+    if (strcmp(caminho, "/") == 0) caminho = "/index.html";
+    for (int i = 0; i < NUM_ASSETS_WEB; ++i) {
+        if (strcmp(caminho, g_assets_web[i].caminho) == 0) return &g_assets_web[i];
+    }
+    return NULL;
+}
+
+/**
+ * Envia um arquivo do dashboard, já comprimido em gzip na flash.
+ * Se o navegador enviou a mesma ETag em If-None-Match, responde apenas 304 (sem corpo).
+ * conexao A conexão.
+ * asset O arquivo a ser enviado.
+ * requisicao A requisição HTTP recebida (para ler If-None-Match).
+ * err_t ERR_OK, ou ERR_ABRT se a conexão teve de ser abortada.
+ */
+static err_t enviar_asset(conexao_http_t *conexao, const asset_web_t *asset, const char *requisicao) {
+    int tamanho_cabecalho;
+    if (cabecalho_contem(requisicao, "If-None-Match:", asset->etag)) {
+        tamanho_cabecalho = snprintf(g_cabecalho_http, sizeof(g_cabecalho_http),
+                                "HTTP/1.1 304 Not Modified\r\n"
+                                "ETag: %s\r\n"
+                                "Cache-Control: %s\r\n"
+                                "Connection: close\r\n\r\n",
+                                asset->etag, CACHE_CONTROL_ASSETS);
+        return enviar_resposta(conexao, g_cabecalho_http, tamanho_cabecalho);
+    }
+
+    // Todos os navegadores atuais aceitam gzip, então o conteúdo é enviado sempre comprimido
+    tamanho_cabecalho = snprintf(g_cabecalho_http, sizeof(g_cabecalho_http),
+                                "HTTP/1.1 200 OK\r\n"
+                                "Content-Type: %s\r\n"
+                                "Content-Encoding: gzip\r\n"
+                                "Content-Length: %lu\r\n"
+                                "ETag: %s\r\n"
+                                "Cache-Control: %s\r\n"
+                                "Vary: Accept-Encoding\r\n"
+                                "Connection: close\r\n\r\n",
+                                asset->tipo_conteudo, (unsigned long)asset->tamanho_gzip,
+                                asset->etag, CACHE_CONTROL_ASSETS);
+
+    if (tcp_write(conexao->pcb, g_cabecalho_http, tamanho_cabecalho, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE) != ERR_OK) {
+        pisca_led(PINO_LED_ERRO, 4, 100); // Erro ao tentar escrever para o socket TCP
+        return fechar_conexao_cliente(conexao);
+    }
+    conexao->corpo_pendente = asset->dados_gzip;
+    conexao->bytes_pendentes = asset->tamanho_gzip;
+    enviar_corpo_pendente(conexao);
+    return ERR_OK;
+}
+
+/**
+ * Responde GET /dados com o botão e a última leitura do DHT11 em JSON, no mesmo formato de
+ * chaves do servidor.py (A = botão da placa). TEMP/UMI são null se a última leitura falhou.
+ * conexao A conexão.
+ * err_t ERR_OK, ou ERR_ABRT se a conexão teve de ser abortada.
+ */
+static err_t enviar_dados_json(conexao_http_t *conexao) {
+    bool botao_esta_pressionado = !gpio_get(PINO_BOTAO); // Pull-up: pressionado = nível baixo (0)
+    leitura_dht11_t leitura_dht_corrente = g_ultima_leitura_dht;
+    bool leitura_dht_foi_ok = g_ultima_leitura_dht_ok;
+
+    char corpo_json[96];
+    if (leitura_dht_foi_ok) {
+        snprintf(corpo_json, sizeof(corpo_json), "{\"A\":%d,\"TEMP\":%.1f,\"UMI\":%.1f}",
+                 botao_esta_pressionado, leitura_dht_corrente.temperatura, leitura_dht_corrente.umidade);
+    } else {
+        snprintf(corpo_json, sizeof(corpo_json), "{\"A\":%d,\"TEMP\":null,\"UMI\":null}", botao_esta_pressionado);
+    }
+
+    int tamanho_resposta = snprintf(g_cabecalho_http, sizeof(g_cabecalho_http),
+                                "HTTP/1.1 200 OK\r\n"
+                                "Content-Type: application/json\r\n"
+                                "Content-Length: %d\r\n"
+                                "Cache-Control: no-store\r\n"
+                                "Connection: close\r\n\r\n"
+                                "%s",
+                                (int)strlen(corpo_json), corpo_json);
+    return enviar_resposta(conexao, g_cabecalho_http, tamanho_resposta);
+}
+
+/**
+ * Responde GET /status com a página simples original (template HTML com os dados atuais).
+ * conexao A conexão.
+ * err_t ERR_OK, ou ERR_ABRT se a conexão teve de ser abortada.
+ */
+static err_t enviar_pagina_status(conexao_http_t *conexao) {
+    // Lê o estado atual do botão
+    bool botao_esta_pressionado = !gpio_get(PINO_BOTAO); // Pull-up: pressionado = nível baixo (0)
+
+    // Última leitura do sensor DHT11 (feita no loop principal)
+    leitura_dht11_t leitura_dht_corrente = g_ultima_leitura_dht;
+    bool leitura_dht_foi_ok = g_ultima_leitura_dht_ok;
+
+    // Prepara strings para os valores e classes CSS dinâmicas
+    char str_valor_botao[15]; char str_classe_botao[30];
+    sprintf(str_valor_botao, botao_esta_pressionado ? "PRESSIONADO" : "SOLTO");
+    sprintf(str_classe_botao, botao_esta_pressionado ? "value-pressed" : "value-ok");
+
+    char str_status_dht[30]; char str_classe_dht[30];
+    sprintf(str_status_dht, leitura_dht_foi_ok ? "OK" : "Falha na leitura");
+    sprintf(str_classe_dht, leitura_dht_foi_ok ? "value-ok" : "value-fail");
+
+    // Monta o corpo do HTML dinamicamente usando o template e os dados atuais
+    char corpo_html_dinamico[1200]; // Buffer para o corpo HTML
+    int tamanho_necessario_corpo = snprintf(corpo_html_dinamico, sizeof(corpo_html_dinamico), g_template_html,
+             PINO_BOTAO, str_classe_botao, str_valor_botao,
+             PINO_DHT11, str_classe_dht, str_status_dht,
+             leitura_dht_foi_ok ? leitura_dht_corrente.temperatura : -99.0f, // Usa -99 se falha
+             leitura_dht_foi_ok ? leitura_dht_corrente.umidade : -99.0f);   // Usa -99 se falha
+
+    // Verifica se o buffer do corpo HTML foi suficiente
+    if (tamanho_necessario_corpo >= sizeof(corpo_html_dinamico)) {
+         // AVISO: HTML BODY TRUNCADO! O buffer é pequeno demais.
+         pisca_led(PINO_LED_ERRO, 5, 100); // Pisca LED de erro
+    }
+
+    // Monta a resposta HTTP completa (cabeçalhos HTTP + corpo HTML)
+    char resposta_http_completa[1400]; // Buffer para a resposta HTTP completa
+    int tamanho_corpo_html = strlen(corpo_html_dinamico);
+    int tamanho_resposta_http = snprintf(resposta_http_completa, sizeof(resposta_http_completa),
+                            "HTTP/1.1 200 OK\r\n"
+                            "Content-Type: text/html; charset=utf-8\r\n" // Define tipo e codificação
+                            "Content-Length: %d\r\n"                     // Tamanho do corpo HTML
+                            "Connection: close\r\n\r\n"                  // Informa que a conexão será fechada após esta resposta
+                            "%s",                                        // O corpo HTML dinâmico
+                            tamanho_corpo_html, corpo_html_dinamico);
+
+    // Envia a resposta HTTP ao cliente
+    if (tamanho_resposta_http > 0 && tamanho_resposta_http < sizeof(resposta_http_completa)) {
+        return enviar_resposta(conexao, resposta_http_completa, tamanho_resposta_http);
+    }
+    pisca_led(PINO_LED_ERRO, 5, 100); // Erro ao formatar a resposta HTTP completa ou buffer pequeno
+    return fechar_conexao_cliente(conexao);
+}
+
 /**
  * Callback chamado pela pilha LwIP quando dados são recebidos do cliente.
- * É aqui que a requisição HTTP GET é processada e a página HTML é gerada e enviada.
- * arg Argumento definido pelo usuário.
+ * É aqui que a requisição HTTP GET é processada e encaminhada para o dashboard
+ * embutido, para o JSON de dados ou para a página de status.
+ * arg A conexao_http_t da conexão.
  * tpcb O PCB da conexão.
  * p O buffer (pbuf) contendo os dados recebidos; NULL se o cliente fechou a conexão.
  * err Código de erro LwIP.
- * err_t ERR_OK se tudo correu bem.
+ * err_t ERR_OK se tudo correu bem, ERR_ABRT se a conexão foi abortada.
  */
 static err_t server_recv_cb(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
+    conexao_http_t *conexao = (conexao_http_t *)arg;
+
     // Trata erros na recepção ou se o cliente abortou
     if (err != ERR_OK && err != ERR_ABRT) {
         if (p) pbuf_free(p); // Libera o buffer se existir
-        fechar_conexao_cliente(tpcb);
-        return err;
+        return fechar_conexao_cliente(conexao);
     }
 
     // Se p é NULL, o cliente fechou a conexão remotamente
     if (!p) {
-        fechar_conexao_cliente(tpcb);
-        return ERR_OK; 
+        return fechar_conexao_cliente(conexao);
     }
 
     // Informa à pilha LwIP que os dados do pbuf foram processados
     tcp_recved(tpcb, p->tot_len);
+    conexao->voltas_sem_progresso = 0;
+
+    // Copia a requisição (que pode vir em vários pbufs encadeados) para um texto terminado em '\0'
+    u16_t tamanho_requisicao = pbuf_copy_partial(p, g_requisicao_http, sizeof(g_requisicao_http) - 1, 0);
+    g_requisicao_http[tamanho_requisicao] = '\0';
+    pbuf_free(p); // Libera o buffer da requisição recebida
 
     // Verifica se é uma requisição HTTP GET (verificação básica)
-    if (p->tot_len >= 3 && strncmp((char *)p->payload, "GET", 3) == 0) {
-        // Lê o estado atual do botão
-        bool botao_esta_pressionado = !gpio_get(PINO_BOTAO); // Pull-up: pressionado = nível baixo (0)
-        
-        // Lê os dados atuais do sensor DHT11
-        leitura_dht11_t leitura_dht_corrente;
-        bool leitura_dht_foi_ok = ler_dht11(&leitura_dht_corrente);
-
-        // Prepara strings para os valores e classes CSS dinâmicas
-        char str_valor_botao[15]; char str_classe_botao[30]; 
-        sprintf(str_valor_botao, botao_esta_pressionado ? "PRESSIONADO" : "SOLTO");
-        sprintf(str_classe_botao, botao_esta_pressionado ? "value-pressed" : "value-ok");
-
-        char str_status_dht[30]; char str_classe_dht[30]; 
-        sprintf(str_status_dht, leitura_dht_foi_ok ? "OK" : "Falha na leitura");
-        sprintf(str_classe_dht, leitura_dht_foi_ok ? "value-ok" : "value-fail");
-
-        // Monta o corpo do HTML dinamicamente usando o template e os dados atuais
-        char corpo_html_dinamico[1200]; // Buffer para o corpo HTML
-        int tamanho_necessario_corpo = snprintf(corpo_html_dinamico, sizeof(corpo_html_dinamico), g_template_html,
-                 PINO_BOTAO, str_classe_botao, str_valor_botao,
-                 PINO_DHT11, str_classe_dht, str_status_dht,
-                 leitura_dht_foi_ok ? leitura_dht_corrente.temperatura : -99.0f, // Usa -99 se falha
-                 leitura_dht_foi_ok ? leitura_dht_corrente.umidade : -99.0f);   // Usa -99 se falha
-        
-        // Verifica se o buffer do corpo HTML foi suficiente
-        if (tamanho_necessario_corpo >= sizeof(corpo_html_dinamico)) {
-             // AVISO: HTML BODY TRUNCADO! O buffer é pequeno demais.
-             pisca_led(PINO_LED_ERRO, 5, 100); // Pisca LED de erro
-        }
+    if (tamanho_requisicao < 5 || strncmp(g_requisicao_http, "GET ", 4) != 0) {
+        return fechar_conexao_cliente(conexao);
+    }
 
-        // Monta a resposta HTTP completa (cabeçalhos HTTP + corpo HTML)
-        char resposta_http_completa[1400]; // Buffer para a resposta HTTP completa
-        int tamanho_corpo_html = strlen(corpo_html_dinamico);
-        int tamanho_resposta_http = snprintf(resposta_http_completa, sizeof(resposta_http_completa),
-                                "HTTP/1.1 200 OK\r\n"
-                                "Content-Type: text/html; charset=utf-8\r\n" // Define tipo e codificação
-                                "Content-Length: %d\r\n"                     // Tamanho do corpo HTML
-                                "Connection: close\r\n\r\n"                  // Informa que a conexão será fechada após esta resposta
-                                "%s",                                        // O corpo HTML dinâmico
-                                tamanho_corpo_html, corpo_html_dinamico);
-
-        // Envia a resposta HTTP ao cliente
-        if (tamanho_resposta_http > 0 && tamanho_resposta_http < sizeof(resposta_http_completa)) {
-            err_t erro_ao_escrever = tcp_write(tpcb, resposta_http_completa, tamanho_resposta_http, TCP_WRITE_FLAG_COPY);
-            if (erro_ao_escrever == ERR_OK) {
-                tcp_output(tpcb); // Tenta enviar os dados imediatamente
-                tcp_sent(tpcb, server_sent_cb); // Define callback para quando o envio for confirmado
-            } else { 
-                pisca_led(PINO_LED_ERRO, 4, 100); // Erro ao tentar escrever para o socket TCP
-                fechar_conexao_cliente(tpcb); 
-            }
-        } else { 
-            pisca_led(PINO_LED_ERRO, 5, 100); // Erro ao formatar a resposta HTTP completa ou buffer pequeno
-            fechar_conexao_cliente(tpcb); 
-        }
-    } else { // Se a requisição não for um GET
-        fechar_conexao_cliente(tpcb); 
+    // Extrai o caminho ("GET /caminho?consulta HTTP/1.1")
+    char caminho[48];
+    size_t tamanho_caminho = strcspn(g_requisicao_http + 4, " ?\r\n");
+    if (tamanho_caminho >= sizeof(caminho)) tamanho_caminho = sizeof(caminho) - 1;
+    memcpy(caminho, g_requisicao_http + 4, tamanho_caminho);
+    caminho[tamanho_caminho] = '\0';
+
+    const asset_web_t *asset = buscar_asset(caminho);
+    if (asset) {
+        return enviar_asset(conexao, asset, g_requisicao_http);
+    } else if (strcmp(caminho, "/dados") == 0) {
+        return enviar_dados_json(conexao);
+    } else if (strcmp(caminho, "/status") == 0) {
+        return enviar_pagina_status(conexao);
     }
-    pbuf_free(p); // Libera o buffer da requisição recebida
-    return ERR_OK;
+    int tamanho_resposta = snprintf(g_cabecalho_http, sizeof(g_cabecalho_http),
+                            "HTTP/1.1 404 Not Found\r\n"
+                            "Content-Length: 0\r\n"
+                            "Connection: close\r\n\r\n");
+    return enviar_resposta(conexao, g_cabecalho_http, tamanho_resposta);
 }
 
 /**
@@ -312,29 +547,40 @@ static err_t server_recv_cb(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err
  * arg Argumento definido pelo usuário.
  * novo_pcb_cliente O PCB da nova conexão estabelecida.
  * err Código de erro LwIP.
- * err_t ERR_OK se a conexão for aceita, ou um erro LwIP caso contrário.
+ * err_t ERR_OK se a conexão for aceita; ERR_ABRT se ela foi abortada aqui.
  */
 static err_t server_accept_cb(void *arg, struct tcp_pcb *novo_pcb_cliente, err_t err) {
     // Verifica se houve erro ao aceitar ou se o novo PCB é nulo
-    if (err != ERR_OK || novo_pcb_cliente == NULL) { 
-        if (novo_pcb_cliente) fechar_conexao_cliente(novo_pcb_cliente); // Fecha o novo PCB se ele foi criado
-        return ERR_VAL; // Retorna erro de valor inválido
+    if (err != ERR_OK || novo_pcb_cliente == NULL) {
+        return ERR_VAL; // Retorna erro de valor inválido (o LwIP libera o PCB, se houver)
     }
 
-    // Este servidor simples lida com apenas um cliente por vez.
-    // Se já houver um cliente conectado (g_pcb_cliente não é NULL), recusa a nova conexão.
-    if (g_pcb_cliente != NULL) { 
-        fechar_conexao_cliente(novo_pcb_cliente); // Fecha a nova conexão
-        return ERR_ABRT; // Indica ao LwIP para abortar esta conexão
+    // Procura uma posição livre para a nova conexão
+    conexao_http_t *conexao = NULL;
+    for (int i = 0; i < MAX_CONEXOES_HTTP; ++i) {
+        if (g_conexoes[i].pcb == NULL) {
+            conexao = &g_conexoes[i];
+            break;
+        }
+    }
+    if (conexao == NULL) {
+        // Todas as posições ocupadas: aborta (o navegador recebe RST e tenta de novo).
+        // Depois de tcp_abort, o LwIP exige ERR_ABRT como retorno.
+        tcp_abort(novo_pcb_cliente);
+        return ERR_ABRT;
     }
 
-    g_pcb_cliente = novo_pcb_cliente; // Armazena o PCB do novo cliente conectado
+    conexao->pcb = novo_pcb_cliente;   // Ocupa a posição
+    conexao->bytes_pendentes = 0;
+    conexao->voltas_sem_progresso = 0;
 
     // Configura os callbacks para a nova conexão do cliente
-    tcp_setprio(g_pcb_cliente, TCP_PRIO_NORMAL); // Define a prioridade da conexão
-    tcp_arg(g_pcb_cliente, NULL); // Define um argumento para ser passado aos callbacks (não usado aqui)
-    tcp_recv(g_pcb_cliente, server_recv_cb);   // Define o callback para quando dados são recebidos
-    tcp_err(g_pcb_cliente, server_err_cb);     // Define o callback para quando erros ocorrem
+    tcp_setprio(novo_pcb_cliente, TCP_PRIO_NORMAL); // Define a prioridade da conexão
+    tcp_arg(novo_pcb_cliente, conexao);             // Estado desta conexão, passado a todos os callbacks
+    tcp_recv(novo_pcb_cliente, server_recv_cb);     // Define o callback para quando dados são recebidos
+    tcp_sent(novo_pcb_cliente, server_sent_cb);     // Define o callback para quando o envio for confirmado
+    tcp_err(novo_pcb_cliente, server_err_cb);       // Define o callback para quando erros ocorrem
+    tcp_poll(novo_pcb_cliente, server_poll_cb, INTERVALO_POLL_HTTP); // Retomada do envio e limpeza de conexões paradas
     return ERR_OK; // Conexão aceita com sucesso
 }
 
@@ -347,25 +593,25 @@ static err_t server_accept_cb(void *arg, struct tcp_pcb *novo_pcb_cliente, err_t
 bool init_servidor_tcp(void) {
     // Cria um novo PCB (Protocol Control Block) para escutar por conexões TCP
     g_pcb_escuta = tcp_new_ip_type(IPADDR_TYPE_ANY); // IPADDR_TYPE_ANY para escutar em qualquer interface de rede
-    if (!g_pcb_escuta) { 
+    if (!g_pcb_escuta) {
         pisca_led(PINO_LED_ERRO, 5, 200); // 5 piscadas = erro ao criar PCB
-        return false; 
+        return false;
     }
 
     // Associa (bind) o PCB a qualquer endereço IP local e à porta TCP definida
     err_t erro_bind = tcp_bind(g_pcb_escuta, IP_ANY_TYPE, PORTA_TCP);
     if (erro_bind != ERR_OK) {
-        fechar_conexao_cliente(g_pcb_escuta); g_pcb_escuta = NULL; // Limpa o PCB de escuta
+        tcp_close(g_pcb_escuta); g_pcb_escuta = NULL; // Limpa o PCB de escuta
         pisca_led(PINO_LED_ERRO, 6, 200); // 6 piscadas = erro no bind
         return false;
     }
 
-    // Coloca o PCB no estado de escuta (LISTEN), pronto para aceitar conexões
-    // O backlog de 1 significa que apenas 1 conexão pode ficar na fila se o servidor estiver ocupado.
-    struct tcp_pcb *pcb_temporario_escuta = tcp_listen_with_backlog(g_pcb_escuta, 1);
-    if (!pcb_temporario_escuta) { // Se tcp_listen falhar, o PCB original é liberado por LwIP
-        if (g_pcb_escuta) fechar_conexao_cliente(g_pcb_escuta); // Segurança extra
-        g_pcb_escuta = NULL; 
+    // Coloca o PCB no estado de escuta (LISTEN), pronto para aceitar conexões.
+    // O backlog limita as conexões ainda não aceitas (TCP_LISTEN_BACKLOG em lwipopts.h).
+    struct tcp_pcb *pcb_temporario_escuta = tcp_listen_with_backlog(g_pcb_escuta, MAX_CONEXOES_HTTP);
+    if (!pcb_temporario_escuta) { // Se tcp_listen falhar, o PCB original continua alocado
+        tcp_close(g_pcb_escuta);
+        g_pcb_escuta = NULL;
         pisca_led(PINO_LED_ERRO, 7, 200); // 7 piscadas = erro ao escutar
         return false;
     }
@@ -377,6 +623,25 @@ bool init_servidor_tcp(void) {
 }
 
 
+/**
+ * Lê o DHT11 se já passou INTERVALO_LEITURA_DHT11_MS desde a última leitura e guarda o
+ * resultado para os callbacks do servidor. A leitura é feita com a trava do lwIP: a
+ * temporização do DHT11 não é interrompida pela pilha de rede, e os callbacks nunca
+ * veem a leitura pela metade.
+ */
+static void atualizar_leitura_dht11(void) {
+    static absolute_time_t proxima_leitura; // Zero: a primeira chamada já lê
+    if (absolute_time_diff_us(get_absolute_time(), proxima_leitura) > 0) return;
+    proxima_leitura = make_timeout_time_ms(INTERVALO_LEITURA_DHT11_MS);
+
+    leitura_dht11_t leitura;
+    cyw43_arch_lwip_begin();
+    bool leitura_ok = ler_dht11(&leitura);
+    g_ultima_leitura_dht = leitura;
+    g_ultima_leitura_dht_ok = leitura_ok;
+    cyw43_arch_lwip_end();
+}
+
 // --- Função Principal ---
 int main() {
 
@@ -421,6 +686,7 @@ int main() {
     // Loop principal do programa
     while (true) {
         cyw43_arch_poll(); // ESSENCIAL: Processa todos os eventos pendentes da rede Wi-Fi e da pilha TCP/IP LwIP
+        atualizar_leitura_dht11(); // No ritmo do sensor, não no dos navegadores
         sleep_ms(10);      // Pequena pausa para não sobrecarregar a CPU, mas mantém a responsividade
     }
     return 0; // Esta linha nunca é alcançada em um sistema embarcado típico
@@ -0,0 +1,99 @@
+"""
+Gera o cabeçalho C com os arquivos do dashboard (pasta web/) pré-comprimidos em gzip.
+
+Cada arquivo vira um vetor 'static const uint8_t', que no RP2040 fica na flash (XIP),
+junto com o tipo de conteúdo e uma ETag derivada do conteúdo comprimido. O servidor
+TCP do aplicacoesIoT.c envia esses bytes como estão, com 'Content-Encoding: gzip'.
+
+Uso (chamado pelo CMakeLists.txt a cada build em que algum arquivo de web/ mudar):
+    python gerar_assets.py <saida.h> <arquivo1> [<arquivo2> ...]
+"""
+import gzip
+import hashlib
+import os
+import sys
+
+TIPOS_CONTEUDO = {
+    ".html": "text/html; charset=utf-8",
+    ".css": "text/css; charset=utf-8",
+    ".js": "application/javascript; charset=utf-8",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+}
+
+BYTES_POR_LINHA = 16
+
+
+def comprimir(dados):
+    """ Comprime com mtime=0 para que o mesmo arquivo gere sempre os mesmos bytes (e a mesma ETag). """
+    return gzip.compress(dados, compresslevel=9, mtime=0)
+
+
+def gerar_vetor_c(nome, dados):
+    linhas = []
+    for i in range(0, len(dados), BYTES_POR_LINHA):
+        trecho = dados[i:i + BYTES_POR_LINHA]
+        linhas.append("    " + ", ".join(f"0x{b:02x}" for b in trecho) + ",")
+    return f"static const uint8_t {nome}[] = {{\n" + "\n".join(linhas) + "\n};\n"
+
+
+def main():
+    if len(sys.argv) < 3:
+        print(__doc__)
+        sys.exit(1)
+
+    caminho_saida = sys.argv[1]
+    arquivos = sys.argv[2:]
+
+    vetores = []
+    entradas = []
+    total_original = 0
+    total_gzip = 0
+
+    for indice, arquivo in enumerate(arquivos):
+        nome_arquivo = os.path.basename(arquivo)
+        extensao = os.path.splitext(nome_arquivo)[1].lower()
+        if extensao not in TIPOS_CONTEUDO:
+            print(f"!! Tipo de arquivo não suportado: {arquivo}")
+            sys.exit(1)
+
+        with open(arquivo, "rb") as f:
+            original = f.read()
+        comprimido = comprimir(original)
+        etag = '"' + hashlib.sha1(comprimido).hexdigest()[:16] + '"'
+
+        nome_vetor = f"g_asset_web_{indice}"
+        vetores.append(gerar_vetor_c(nome_vetor, comprimido))
+        etag_c = etag.replace('"', '\\"')
+        entradas.append(
+            f'    {{ "/{nome_arquivo}", "{TIPOS_CONTEUDO[extensao]}", "{etag_c}", '
+            f"{nome_vetor}, sizeof({nome_vetor}), {len(original)} }},"
+        )
+
+        total_original += len(original)
+        total_gzip += len(comprimido)
+        print(f"[assets] {nome_arquivo:<16} {len(original):>7} B -> {len(comprimido):>6} B gzip "
+              f"({100.0 * len(comprimido) / max(len(original), 1):.0f}%)  ETag {etag}")
+
+    print(f"[assets] total            {total_original:>7} B -> {total_gzip:>6} B gzip "
+          f"({100.0 * total_gzip / max(total_original, 1):.0f}%); recarga com ETag válida: 304 sem corpo")
+
+    with open(caminho_saida, "w", newline="\n") as f:
+        f.write("// Arquivo gerado por gerar_assets.py a partir da pasta web/. Não editar.\n")
+        f.write("#ifndef ASSETS_WEB_H\n#define ASSETS_WEB_H\n\n#include <stdint.h>\n\n")
+        f.write("typedef struct {\n"
+                "    const char *caminho;        // Caminho HTTP (ex.: \"/index.html\")\n"
+                "    const char *tipo_conteudo;  // Valor do cabeçalho Content-Type\n"
+                "    const char *etag;           // ETag (já entre aspas) do conteúdo comprimido\n"
+                "    const uint8_t *dados_gzip;  // Conteúdo comprimido, guardado na flash\n"
+                "    uint32_t tamanho_gzip;\n"
+                "    uint32_t tamanho_original;\n"
+                "} asset_web_t;\n\n")
+        for vetor in vetores:
+            f.write(vetor + "\n")
+        f.write("static const asset_web_t g_assets_web[] = {\n" + "\n".join(entradas) + "\n};\n\n")
+        f.write(f"#define NUM_ASSETS_WEB {len(entradas)}\n\n#endif // ASSETS_WEB_H\n")
+
+
+if __name__ == "__main__":
+    main()
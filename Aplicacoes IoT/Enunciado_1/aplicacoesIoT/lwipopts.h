@@ -12,6 +12,11 @@
 #define LWIP_DHCP                   1
 #define LWIP_IPV4                   1
 #define LWIP_TCP                    1
+#define TCP_MSS                     1460
+#define TCP_SND_BUF                 (4 * TCP_MSS)   // Permite enviar os assets do dashboard em poucos ACKs
+#define TCP_SND_QUEUELEN            ((4 * (TCP_SND_BUF) + (TCP_MSS - 1)) / (TCP_MSS))
+#define MEMP_NUM_TCP_PCB            10      // MAX_CONEXOES_HTTP do aplicacoesIoT.c, mais as em TIME_WAIT
+#define TCP_LISTEN_BACKLOG          1       // Respeita o backlog de tcp_listen_with_backlog
 #define LWIP_UDP                    1
 #define LWIP_DNS                    1
 #define LWIP_NETIF_HOSTNAME         1
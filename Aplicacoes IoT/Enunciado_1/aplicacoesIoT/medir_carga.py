@@ -0,0 +1,165 @@
+"""
+Bytes, conexões e idas e voltas (RTT) por carga de página do servidor do aplicacoesIoT.c,
+comparando a página original (template HTML com <meta refresh> a cada 1s) com o dashboard
+servido da flash em gzip, na primeira visita e na recarga com ETag válida (304).
+
+Não há build do firmware para o host nesta pasta: as respostas são montadas aqui com os
+mesmos cabeçalhos de enviar_asset, enviar_dados_json e do template de aplicacoesIoT.c, e os
+corpos vêm de web/ comprimidos por gerar_assets.py (os mesmos bytes da flash). As idas e
+voltas seguem um modelo simples do TCP da placa (lwipopts.h):
+  - cada resposta usa uma conexão nova ("Connection: close"): 1 RTT do handshake, mais
+    1 RTT por rajada enviada;
+  - a primeira rajada é a janela inicial do lwIP, min(4 MSS, max(2 MSS, 4380 bytes));
+    a janela cresce 1 MSS por ACK, com o navegador confirmando a cada 2 segmentos, e
+    nunca passa de TCP_SND_BUF;
+  - o navegador pede o CSS e os dois scripts em paralelo, depois de receber o index.html.
+Só os bytes de resposta da placa são contados (as requisições do navegador não).
+
+Uso: python medir_carga.py [--rtt-ms 10] [--kbytes-s 500] [--minutos 1]
+"""
+import argparse
+import hashlib
+import math
+import os
+import re
+
+from gerar_assets import TIPOS_CONTEUDO, comprimir
+
+DIRETORIO = os.path.dirname(os.path.abspath(__file__))
+TCP_MSS = 1460                      # lwipopts.h
+TCP_SND_BUF = 4 * TCP_MSS
+JANELA_INICIAL = min(4 * TCP_MSS, max(2 * TCP_MSS, 4380))
+CACHE_CONTROL_ASSETS = "no-cache"
+ARQUIVOS_WEB = ["index.html", "dashboard.css", "rosa.js", "dashboard.js"]   # Ordem do CMakeLists.txt
+INTERVALO_ATUALIZACAO_S = 1         # <meta refresh> da página original e INTERVALO_CONSULTA_MS do dashboard.js
+
+
+def rajadas(tamanho):
+    """ Quantas rajadas (RTTs depois do pedido) o servidor leva para enviar `tamanho` bytes. """
+    segmentos = max(1, math.ceil(tamanho / TCP_MSS))
+    janela = JANELA_INICIAL // TCP_MSS
+    enviados, contagem = 0, 0
+    while enviados < segmentos:
+        rajada = min(janela, segmentos - enviados)
+        enviados += rajada
+        contagem += 1
+        janela = min(TCP_SND_BUF // TCP_MSS, janela + math.ceil(rajada / 2))
+    return contagem
+
+
+def rtts_conexao(tamanho):
+    return 1 + rajadas(tamanho)
+
+
+def template_html():
+    """ g_template_html de aplicacoesIoT.c, com os literais concatenados. """
+    with open(os.path.join(DIRETORIO, "aplicacoesIoT.c"), encoding="utf-8") as f:
+        fonte = f.read()
+    trecho = fonte[fonte.index("g_template_html ="):]
+    trecho = trecho[:trecho.index("\";") + 1]     # O CSS do template também tem ";"
+    literais = re.findall(r'"((?:[^"\\]|\\.)*)"', trecho)
+    return "".join(literais).encode().decode("unicode_escape")
+
+
+def resposta_status():
+    """ Página original (hoje em /status): cabeçalhos + template com uma leitura válida. """
+    corpo = template_html() % (5, "value-ok", "SOLTO", 8, "value-ok", "OK", 25.0, 60.0)
+    return len(("HTTP/1.1 200 OK\r\n"
+                "Content-Type: text/html; charset=utf-8\r\n"
+                f"Content-Length: {len(corpo)}\r\n"
+                "Connection: close\r\n\r\n").encode()) + len(corpo.encode())
+
+
+def resposta_dados():
+    corpo = '{"A":0,"TEMP":25.0,"UMI":60.0}'
+    return len(("HTTP/1.1 200 OK\r\n"
+                "Content-Type: application/json\r\n"
+                f"Content-Length: {len(corpo)}\r\n"
+                "Cache-Control: no-store\r\n"
+                "Connection: close\r\n\r\n").encode()) + len(corpo)
+
+
+def respostas_assets():
+    """ (nome, bytes sem gzip, bytes com gzip, bytes do 304) de cada arquivo de web/. """
+    respostas = []
+    for nome in ARQUIVOS_WEB:
+        with open(os.path.join(DIRETORIO, "web", nome), "rb") as f:
+            original = f.read()
+        comprimido = comprimir(original)
+        etag = '"' + hashlib.sha1(comprimido).hexdigest()[:16] + '"'
+        tipo = TIPOS_CONTEUDO[os.path.splitext(nome)[1]]
+
+        def cabecalho_200(tamanho, gzip):
+            """ Com gzip: os cabeçalhos de enviar_asset; sem: só os da página original. """
+            if not gzip:
+                return len((f"HTTP/1.1 200 OK\r\nContent-Type: {tipo}\r\n"
+                            f"Content-Length: {tamanho}\r\nConnection: close\r\n\r\n").encode())
+            return len(("HTTP/1.1 200 OK\r\n"
+                        f"Content-Type: {tipo}\r\n"
+                        "Content-Encoding: gzip\r\n"
+                        f"Content-Length: {tamanho}\r\n"
+                        f"ETag: {etag}\r\n"
+                        f"Cache-Control: {CACHE_CONTROL_ASSETS}\r\n"
+                        "Vary: Accept-Encoding\r\n"
+                        "Connection: close\r\n\r\n").encode())
+
+        nao_modificado = len(("HTTP/1.1 304 Not Modified\r\n"
+                              f"ETag: {etag}\r\n"
+                              f"Cache-Control: {CACHE_CONTROL_ASSETS}\r\n"
+                              "Connection: close\r\n\r\n").encode())
+        respostas.append((nome,
+                          cabecalho_200(len(original), False) + len(original),
+                          cabecalho_200(len(comprimido), True) + len(comprimido),
+                          nao_modificado))
+    return respostas
+
+
+def carga_dashboard(tamanhos):
+    """ (bytes, conexões, RTTs) de uma carga: index.html, depois os outros em paralelo. """
+    index, *resto = tamanhos
+    return (sum(tamanhos), len(tamanhos),
+            rtts_conexao(index) + max((rtts_conexao(t) for t in resto), default=0))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--rtt-ms", type=float, default=10.0, help="ida e volta no Wi-Fi (padrão 10ms)")
+    parser.add_argument("--kbytes-s", type=float, default=500.0, help="vazão TCP da placa (padrão 500 KB/s)")
+    parser.add_argument("--minutos", type=float, default=1.0, help="tempo com a página aberta")
+    argumentos = parser.parse_args()
+
+    def tempo_ms(bytes_, rtts):
+        return rtts * argumentos.rtt_ms + bytes_ / argumentos.kbytes_s
+
+    assets = respostas_assets()
+    print(f"[carga] MSS {TCP_MSS} B, janela inicial {JANELA_INICIAL} B, TCP_SND_BUF {TCP_SND_BUF} B; "
+          f"RTT {argumentos.rtt_ms:g} ms, {argumentos.kbytes_s:g} KB/s")
+    for nome, sem_gzip, com_gzip, nao_modificado in assets:
+        print(f"[carga] {nome:<14} 200 sem gzip {sem_gzip:>6} B ({rtts_conexao(sem_gzip)} RTT)  "
+              f"200 gzip {com_gzip:>5} B ({rtts_conexao(com_gzip)} RTT)  304 {nao_modificado:>4} B")
+
+    status = resposta_status()
+    dados = resposta_dados()
+    cenarios = [
+        ("pagina original (/status)", (status, 1, rtts_conexao(status))),
+        ("dashboard sem gzip nem ETag", carga_dashboard([a[1] for a in assets])),
+        ("dashboard gzip, 1a visita", carga_dashboard([a[2] for a in assets])),
+        ("dashboard gzip, recarga 304", carga_dashboard([a[3] for a in assets])),
+    ]
+    print(f"\n{'carga de pagina':<30} {'bytes':>7} {'conexoes':>9} {'RTTs':>5} {'tempo':>9}")
+    for nome, (bytes_, conexoes, rtts) in cenarios:
+        print(f"{nome:<30} {bytes_:>7} {conexoes:>9} {rtts:>5} {tempo_ms(bytes_, rtts):>7.1f}ms")
+
+    # Com a página aberta: a original recarrega tudo a cada segundo (<meta refresh>); o
+    # dashboard carrega uma vez e depois só consulta /dados
+    atualizacoes = int(argumentos.minutos * 60 / INTERVALO_ATUALIZACAO_S)
+    original = status * atualizacoes
+    dashboard = cenarios[2][1][0] + dados * atualizacoes
+    print(f"\n{argumentos.minutos:g} min com a pagina aberta ({atualizacoes} atualizacoes): "
+          f"original {original} B em {atualizacoes} conexoes; dashboard {dashboard} B em "
+          f"{len(assets) + atualizacoes} conexoes ({dados} B por consulta a /dados, "
+          f"{rtts_conexao(dados)} RTT)")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,112 @@
+// Dashboard servido pela própria placa (sem servidor na nuvem).
+// Os dados vêm de GET /dados, no mesmo formato de chaves usado pelo servidor.py do Enunciado 3.
+// A renderização segue o dashboard da nuvem: o estado mais recente é guardado em memória e o
+// DOM só é escrito uma vez por requestAnimationFrame, quando o valor exibido muda.
+
+// --- ELEMENTOS DA INTERFACE ---
+const arrow = document.getElementById('arrow');
+const angleDisplay = document.getElementById('angle-display');
+const intensityDisplay = document.getElementById('intensity-display');
+const buttonStatus = document.getElementById('button-status');
+const buttonA = document.getElementById('button-a');
+const buttonB = document.getElementById('button-b');
+const tempDisplay = document.getElementById('temp-display');
+const humiDisplay = document.getElementById('humi-display');
+const h1 = document.querySelector('h1');
+
+const INTERVALO_CONSULTA_MS = 1000; // Mesmo período do antigo <meta refresh>
+
+const estadoAtual = { vrx: 2048, vry: 2048, btn: false, a: false, b: false, temp: NaN, umi: NaN };
+const estadoRenderizado = {};
+let frameAgendado = false;
+
+function escreverSeMudou(chave, valor, escrever) {
+    if (estadoRenderizado[chave] === valor) return;
+    estadoRenderizado[chave] = valor;
+    escrever(valor);
+}
+
+// --- FUNÇÕES DE ATUALIZAÇÃO DA UI ---
+function updateArrowPosition(angle, intensity) {
+    const degrees = ((angle * 180 / Math.PI) % 360).toFixed(1);
+    const percent = (intensity * 100).toFixed(0);
+    escreverSeMudou('arrowTransform', `translateX(-50%) rotate(${angle.toFixed(3)}rad)`, v => { arrow.style.transform = v; });
+    escreverSeMudou('arrowHeight', `${(80 + (intensity * 70)).toFixed(0)}px`, v => { arrow.style.height = v; });
+    escreverSeMudou('angle', `${degrees}°`, v => { angleDisplay.textContent = v; });
+    escreverSeMudou('intensity', `${percent}%`, v => { intensityDisplay.textContent = v; });
+    escreverSeMudou('pulse', intensity > 0.1, v => { arrow.classList.toggle('pulse', v); });
+}
+
+function updateButtonStatus(element, isPressed, textPrefix) {
+    escreverSeMudou(element.id, isPressed, v => {
+        element.textContent = `${textPrefix}: ${v ? 'PRESSIONADO' : 'SOLTO'}`;
+        element.classList.toggle('button-pressed', v);
+        element.classList.toggle('button-released', !v);
+    });
+}
+
+function updateExtraButtonStatus(element, isPressed) {
+    escreverSeMudou(element.id, isPressed, v => { element.classList.toggle('pressed', v); });
+}
+
+function processJoystickData(vrx, vry) {
+    const ADC_CENTER = 2048;
+    const ADC_MAX_DEV = 2048;
+    const x_norm = (vrx - ADC_CENTER) / ADC_MAX_DEV;
+    const y_norm = -((vry - ADC_CENTER) / ADC_MAX_DEV);
+    const angle = Math.atan2(y_norm, x_norm) + Math.PI / 2;
+    const intensity = Math.min(Math.sqrt(x_norm * x_norm + y_norm * y_norm), 1.0);
+    return { angle, intensity };
+}
+
+function renderizarFrame() {
+    frameAgendado = false;
+    const { angle, intensity } = processJoystickData(estadoAtual.vrx, estadoAtual.vry);
+    updateArrowPosition(angle, intensity);
+
+    updateButtonStatus(buttonStatus, estadoAtual.btn, 'JOYSTICK');
+    updateExtraButtonStatus(buttonA, estadoAtual.a);
+    updateExtraButtonStatus(buttonB, estadoAtual.b);
+
+    escreverSeMudou('temp', isNaN(estadoAtual.temp) ? '-- °C' : `${estadoAtual.temp.toFixed(1)} °C`,
+                    v => { tempDisplay.textContent = v; });
+    escreverSeMudou('umi', isNaN(estadoAtual.umi) ? '-- %' : `${estadoAtual.umi.toFixed(1)} %`,
+                    v => { humiDisplay.textContent = v; });
+}
+
+function agendarRenderizacao() {
+    if (!frameAgendado) {
+        frameAgendado = true;
+        requestAnimationFrame(renderizarFrame);
+    }
+}
+
+// --- CONSULTA AOS DADOS DA PLACA ---
+// Formato: {"VRX": 2048, "VRY": 2048, "BTN": 0, "A": 1, "B": 0, "TEMP": 25.0, "UMI": 60.0}
+// Chaves ausentes mantêm o valor anterior; TEMP/UMI nulos indicam falha na leitura do DHT11.
+function aplicarDados(data) {
+    if (data.VRX !== undefined) estadoAtual.vrx = Number(data.VRX);
+    if (data.VRY !== undefined) estadoAtual.vry = Number(data.VRY);
+    if (data.BTN !== undefined) estadoAtual.btn = Number(data.BTN) === 1;
+    if (data.A !== undefined) estadoAtual.a = Number(data.A) === 1;
+    if (data.B !== undefined) estadoAtual.b = Number(data.B) === 1;
+    if (data.TEMP !== undefined) estadoAtual.temp = data.TEMP === null ? NaN : Number(data.TEMP);
+    if (data.UMI !== undefined) estadoAtual.umi = data.UMI === null ? NaN : Number(data.UMI);
+    agendarRenderizacao();
+}
+
+async function consultarDados() {
+    try {
+        const resposta = await fetch('/dados', { cache: 'no-store' });
+        aplicarDados(await resposta.json());
+        h1.textContent = "Dashboard BitDogLab";
+    } catch (error) {
+        h1.textContent = "Conexão Perdida...";
+    }
+    setTimeout(consultarDados, INTERVALO_CONSULTA_MS);
+}
+
+// Inicia o desenho da rosa dos ventos, o estado inicial da UI e a consulta periódica
+desenharRosaDosVentos(document.getElementById('compass'));
+renderizarFrame();
+consultarDados();
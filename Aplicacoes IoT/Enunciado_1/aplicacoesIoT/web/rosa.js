@@ -0,0 +1,36 @@
+// Desenho da rosa dos ventos em <canvas>.
+// Substitui o Chart.js (CDN) do dashboard da nuvem: só o gráfico de rosca com 8 setores
+// era usado, então este script cabe em poucas centenas de bytes na flash do Pico W.
+function desenharRosaDosVentos(canvas) {
+    const CORES_BORDA = ['#e74c3c', '#e67e22', '#3498db', '#1abc9c', '#e74c3c', '#9b59b6', '#3498db', '#f1c40f'];
+    const CORTE_INTERNO = 0.75;      // Mesmo 'cutout: 75%' do Chart.js
+    const ROTACAO = -Math.PI / 4;    // Mesmo 'rotation: -45' do Chart.js
+
+    const escala = window.devicePixelRatio || 1;
+    const largura = canvas.clientWidth;
+    const altura = canvas.clientHeight;
+    canvas.width = largura * escala;
+    canvas.height = altura * escala;
+
+    const ctx = canvas.getContext('2d');
+    ctx.scale(escala, escala);
+    const cx = largura / 2;
+    const cy = altura / 2;
+    const raioExterno = Math.min(cx, cy) - 1;
+    const raioInterno = raioExterno * CORTE_INTERNO;
+    const passo = (2 * Math.PI) / CORES_BORDA.length;
+
+    CORES_BORDA.forEach((cor, i) => {
+        // Ângulo 0 do canvas aponta para leste; subtrai 90° para começar no norte
+        const inicio = ROTACAO - Math.PI / 2 + i * passo;
+        ctx.beginPath();
+        ctx.arc(cx, cy, raioExterno, inicio, inicio + passo);
+        ctx.arc(cx, cy, raioInterno, inicio + passo, inicio, true);
+        ctx.closePath();
+        ctx.fillStyle = cor + '20';
+        ctx.fill();
+        ctx.strokeStyle = cor;
+        ctx.lineWidth = 1;
+        ctx.stroke();
+    });
+}
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 #include "pico/stdlib.h"
 #include "pico/cyw43_arch.h"
 #include "hardware/adc.h"
@@ -13,6 +14,11 @@
 #define NOTEBOOK_IP "192.168.0.228" // IP do notebook
 #define UDP_PORT 8081
 
+// ==== ENVIO POR MUDANÇA ====
+#define PERIODO_LEITURA_MS 100          // Leitura do joystick
+#define LIMIAR_MUDANCA_ADC 64           // Variação mínima (contagens do ADC) para enviar uma nova posição
+#define INTERVALO_MAXIMO_ENVIO_MS 1000  // Mesmo parado, envia a posição a cada 1s (sinal de vida)
+
 // ==== LEDS ====
 #define LED_WIFI_OK 11
 #define LED_WIFI_ERR 12
@@ -89,6 +95,9 @@ bool setup_udp() {
         return false;
     }
 
+    // Só transmitimos datagramas: o rádio pode dormir entre os envios
+    cyw43_wifi_pm(&cyw43_state, CYW43_AGGRESSIVE_PM);
+
     printf("Configurado para enviar para %s:%d\n", ip4addr_ntoa(&notebook_addr), UDP_PORT);
     return true;
 }
@@ -122,6 +131,10 @@ int main() {
         while (1) sleep_ms(1000);  // Loop de erro
     }
 
+    uint16_t last_x = 0, last_y = 0;
+    uint32_t last_send_ms = 0;
+    bool sent_once = false;
+
     while (true) {
         
         bool joystick = !gpio_get(JOY_SW);
@@ -129,13 +142,23 @@ int main() {
         uint16_t x = read_adc(1);
         uint16_t y = read_adc(0);
 
-        char msg[128];
-        snprintf(msg, sizeof(msg),
-            "VRX=%u VRY=%u",
-            x, y
-        );
-        send_udp_message(msg);
+        // Só envia se o joystick se moveu além do limiar ou se passou o intervalo máximo
+        uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+        bool moved = abs((int)x - (int)last_x) >= LIMIAR_MUDANCA_ADC ||
+                     abs((int)y - (int)last_y) >= LIMIAR_MUDANCA_ADC;
+        if (!sent_once || moved || now_ms - last_send_ms >= INTERVALO_MAXIMO_ENVIO_MS) {
+            char msg[128];
+            snprintf(msg, sizeof(msg),
+                "VRX=%u VRY=%u",
+                x, y
+            );
+            send_udp_message(msg);
+            last_x = x;
+            last_y = y;
+            last_send_ms = now_ms;
+            sent_once = true;
+        }
         //step++;
-        sleep_ms(100);
+        sleep_ms(PERIODO_LEITURA_MS);
     }
 }
\ No newline at end of file
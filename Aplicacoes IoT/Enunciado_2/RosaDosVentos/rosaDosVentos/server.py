@@ -1,4 +1,6 @@
+import os
 import socket
+import sys
 import numpy as np
 import matplotlib.pyplot as plt
 import matplotlib.image as mpimg
@@ -12,6 +14,14 @@ sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
 sock.bind((IP_UDP, PORTA_UDP))  # Vincula socket ao IP e porta
 sock.setblocking(False)          # Configura socket para modo não bloqueante
 
+# Interpretador de telemetria do Enunciado 3 (em C, se a libtelemetria.so estiver compilada;
+# ver Enunciado_3/telemetria/CMakeLists.txt). Sem ele, usa a interpretação local abaixo.
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', '..', 'Enunciado_3'))
+try:
+    from telemetria import interpretar_bloco
+except ImportError:
+    interpretar_bloco = None
+
 def vrx_vry_para_direcao(vrx, vry):
     """
     Converte valores brutos VRX e VRY do joystick em direção da rosa dos ventos.
@@ -93,6 +103,25 @@ def interpretar_mensagem(mensagem):
     except:
         return None, None
 
+def interpretar_datagramas(datagramas):
+    """
+    Interpreta de uma vez todos os datagramas que chegaram desde a última atualização.
+
+    Parâmetros:
+        datagramas (list[bytes]): conteúdo dos datagramas, cada um 'VRX=xxxx VRY=xxxx'
+
+    Retorna:
+        list[(int, int)]: valores (VRX, VRY) de cada datagrama válido, na ordem de chegada
+    """
+    if interpretar_bloco is None:
+        valores = [interpretar_mensagem(dados.decode(errors='replace')) for dados in datagramas]
+        return [(vrx, vry) for vrx, vry in valores if vrx is not None and vry is not None]
+    # Um datagrama por linha, interpretados em uma única chamada
+    bloco = b"".join(dados.replace(b"\n", b" ") + b"\n" for dados in datagramas)
+    registros, _ = interpretar_bloco(bloco)
+    return [(campos['VRX'], campos['VRY']) for campos, erro, _ in registros
+            if campos is not None and isinstance(campos.get('VRX'), int) and isinstance(campos.get('VRY'), int)]
+
 def atualizar_seta(angulo):
     """
     Atualiza a posição da seta no gráfico polar conforme o ângulo recebido.
@@ -113,14 +142,23 @@ def loop_principal():
     """
     while True:
         try:
-            # Tenta receber dados do socket UDP
-            dados, endereco = sock.recvfrom(1024)
-            mensagem = dados.decode()
-            vrx, vry = interpretar_mensagem(mensagem)
+            # Recebe tudo o que chegou desde a última atualização do gráfico (que leva
+            # ~10ms); só a posição mais recente do joystick é desenhada
+            datagramas = []
+            try:
+                while True:
+                    dados, endereco = sock.recvfrom(1024)
+                    datagramas.append(dados)
+            except BlockingIOError:
+                if not datagramas:
+                    raise
+            valores = interpretar_datagramas(datagramas)
 
             # Ignora se não conseguiu interpretar dados
-            if vrx is None or vry is None:
+            if not valores:
+                plt.pause(0.01)
                 continue
+            vrx, vry = valores[-1]
 
             # Normaliza os valores VRX e VRY para intervalo [-1, 1]
             x = (vrx - 2048) / 2048.0
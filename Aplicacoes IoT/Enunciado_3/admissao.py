@@ -0,0 +1,85 @@
+"""
+Admissão de conexões novas do servidor.py (placas e dashboards) por baldes de fichas.
+
+Quando o Wi-Fi de um local oscila, todas as placas reconectam juntas e os dashboards
+abertos também. Cada conexão nova precisa de uma ficha; as fichas voltam a uma taxa fixa,
+até a capacidade do balde (a rajada aceita de uma vez). Prioridades:
+  1. placas já conhecidas (voltando de uma queda): têm um balde só delas e, com ele
+     vazio, ainda podem usar o balde comum; uma tempestade de placas novas não as atrasa;
+  2. placas novas: precisam de uma ficha do balde comum;
+  3. dashboards: precisam de uma ficha do balde comum além das reservadas às placas.
+Quem é recusado recebe quando tentar de novo ("RETRY=<ms>\\n" para a placa, HTTP 503 com
+Retry-After para o dashboard). A espera sugerida é a fila virtual de recusados do balde
+dele dividida pela taxa, para que voltem espalhados em vez de todos no mesmo instante.
+"""
+import time
+
+
+class BaldeDeFichas:
+    def __init__(self, taxa, capacidade, relogio=time.monotonic):
+        self.taxa = taxa
+        self.capacidade = capacidade
+        self.relogio = relogio
+        self.fichas = capacidade
+        self.fila_virtual = 0.0          # Recusados que ainda devem voltar, estimados
+        self.atualizado_em = relogio()
+
+    def _repor(self):
+        agora = self.relogio()
+        reposicao = (agora - self.atualizado_em) * self.taxa
+        self.atualizado_em = agora
+        self.fichas = min(self.capacidade, self.fichas + reposicao)
+        self.fila_virtual = max(0.0, self.fila_virtual - reposicao)
+
+    def retirar(self, reserva=0):
+        """ Retira uma ficha se sobrarem mais de 'reserva'. """
+        self._repor()
+        if self.fichas - 1 >= reserva:
+            self.fichas -= 1
+            return True
+        return False
+
+    def recusar(self):
+        self.fila_virtual += 1
+
+    def espera_sugerida_s(self, maxima_s):
+        self._repor()
+        return min(maxima_s, 1.0 + self.fila_virtual / self.taxa)
+
+
+class Admissao:
+    """ As três prioridades acima sobre dois baldes: o comum e o das placas conhecidas. """
+
+    def __init__(self, taxa, rajada, taxa_conhecidas, rajada_conhecidas, reserva_placas, espera_maxima_s,
+                 relogio=time.monotonic):
+        self.comum = BaldeDeFichas(taxa, rajada, relogio)
+        self.conhecidas = BaldeDeFichas(taxa_conhecidas, rajada_conhecidas, relogio)
+        self.reserva_placas = reserva_placas
+        self.espera_maxima_s = espera_maxima_s
+        self.aceitas = 0
+        self.aceitas_conhecidas = 0
+        self.recusadas = 0
+
+    def admitir_placa(self, conhecida):
+        if conhecida and (self.conhecidas.retirar() or self.comum.retirar()):
+            self.aceitas += 1
+            self.aceitas_conhecidas += 1
+            return True
+        if not conhecida and self.comum.retirar():
+            self.aceitas += 1
+            return True
+        self.recusadas += 1
+        (self.conhecidas if conhecida else self.comum).recusar()
+        return False
+
+    def admitir_dashboard(self):
+        if self.comum.retirar(reserva=self.reserva_placas):
+            self.aceitas += 1
+            return True
+        self.recusadas += 1
+        self.comum.recusar()
+        return False
+
+    def espera_sugerida_s(self, conhecida=False):
+        balde = self.conhecidas if conhecida else self.comum
+        return balde.espera_sugerida_s(self.espera_maxima_s)
@@ -0,0 +1,140 @@
+// bancada_dashboard.js
+// Custo de renderização do dashboard.html no Chrome headless, com o fluxo do WebSocket
+// a 0 (referência), 10, 100 e 1000 mensagens/s.
+//
+// Uso (precisa do puppeteer: "npm install puppeteer" ou NODE_PATH=$(npm root -g)):
+//     node bancada_dashboard.js [caminho/dashboard.html] [--binario] [--segundos N]
+//
+// O WebSocket da página é trocado, antes de qualquer script dela, por um falso que
+// entrega mensagens já prontas (JSON como o servidor.py envia ou, com --binario, quadros
+// de 9 bytes) no ritmo pedido; o Chart.js da CDN é trocado por um stub, já que o gráfico
+// é desenhado uma única vez e não faz parte do custo por mensagem. O custo vem das
+// métricas do DevTools (Performance.getMetrics): tempo de tarefas na thread principal,
+// de script, de layout e de recálculo de estilo, por segundo de fluxo.
+// Para comparar com a versão anterior do dashboard:
+//     git show 2942df8:"Aplicacoes IoT/Enunciado_3/dashboard.html" > /tmp/dashboard_antes.html
+//     node bancada_dashboard.js /tmp/dashboard_antes.html
+const path = require('path');
+const puppeteer = require('puppeteer');
+
+const argumentos = process.argv.slice(2);
+const binario = argumentos.includes('--binario');
+const indiceSegundos = argumentos.indexOf('--segundos');
+const SEGUNDOS = indiceSegundos >= 0 ? Number(argumentos[indiceSegundos + 1]) : 5;
+const arquivo = path.resolve(argumentos.find((a, i) => !a.startsWith('--') && argumentos[i - 1] !== '--segundos')
+                             || path.join(__dirname, '..', 'dashboard.html'));
+const TAXAS = [0, 10, 100, 1000];
+
+// Executado na página antes dos scripts dela
+function instalarWebSocketFalso(binario) {
+    const sockets = [];
+    class WebSocketFalso {
+        constructor(url) {
+            this.url = url;
+            this.readyState = 0;
+            this.binaryType = 'blob';
+            sockets.push(this);
+            setTimeout(() => { this.readyState = 1; if (this.onopen) this.onopen({}); }, 0);
+        }
+        send() {}
+        close() {}
+    }
+    window.WebSocket = WebSocketFalso;
+
+    // Mensagens pré-geradas: o custo de montá-las não entra na medição
+    const N = 4096;
+    const mensagens = [];
+    for (let i = 0; i < N; i++) {
+        const angulo = i * 2 * Math.PI / 360;
+        const vrx = Math.round(2048 + 1800 * Math.cos(angulo));
+        const vry = Math.round(2048 + 1800 * Math.sin(angulo));
+        const btn = (i >> 6) & 1, a = (i >> 7) & 1, b = (i >> 8) & 1;
+        const temp = 25 + (i % 50) / 10, umi = 60 + (i % 30) / 10;
+        if (binario) {
+            const buffer = new ArrayBuffer(9);
+            const view = new DataView(buffer);
+            view.setUint16(0, vrx, true);
+            view.setUint16(2, vry, true);
+            view.setUint8(4, btn | (a << 1) | (b << 2));
+            view.setInt16(5, Math.round(temp * 10), true);
+            view.setUint16(7, Math.round(umi * 10), true);
+            mensagens.push(buffer);
+        } else {
+            mensagens.push(JSON.stringify({VRX: vrx, VRY: vry, BTN: btn, A: a, B: b,
+                                           TEMP: temp, UMI: umi, DISPOSITIVO: '10.0.0.2'}));
+        }
+    }
+
+    let temporizador = null;
+    window.__bancada = {
+        iniciar(taxa) {
+            clearInterval(temporizador);
+            if (taxa === 0) return;
+            const inicio = performance.now();
+            let enviadas = 0;
+            // Entrega as mensagens vencidas a cada volta (setInterval tem resolução de ~4ms)
+            temporizador = setInterval(() => {
+                const devidas = Math.floor((performance.now() - inicio) * taxa / 1000);
+                for (; enviadas < devidas; enviadas++) {
+                    for (const socket of sockets) {
+                        if (socket.readyState === 1 && socket.onmessage) {
+                            socket.onmessage({data: mensagens[enviadas % N]});
+                        }
+                    }
+                }
+            }, 1);
+        },
+        parar() { clearInterval(temporizador); },
+    };
+}
+
+function metricas(lista) {
+    const m = {};
+    for (const {name, value} of lista.metrics) m[name] = value;
+    return m;
+}
+
+(async () => {
+    const navegador = await puppeteer.launch({headless: 'shell', args: ['--no-sandbox']});
+    const pagina = await navegador.newPage();
+    await pagina.setViewport({width: 1280, height: 900});
+    await pagina.setRequestInterception(true);
+    pagina.on('request', requisicao => {
+        if (requisicao.url().includes('chart.js')) {
+            requisicao.respond({contentType: 'application/javascript',
+                                body: 'window.Chart = function () { return {}; };'});
+        } else {
+            requisicao.continue();
+        }
+    });
+    pagina.on('pageerror', erro => console.error('Erro na página:', erro.message));
+    await pagina.evaluateOnNewDocument(instalarWebSocketFalso, binario);
+    await pagina.goto('file://' + arquivo, {waitUntil: 'load'});
+
+    const cdp = await pagina.target().createCDPSession();
+    await cdp.send('Performance.enable');
+
+    console.log(`${path.basename(arquivo)} (${binario ? 'binário' : 'JSON'}), ${SEGUNDOS}s por taxa`);
+    console.log('msgs/s   tarefas ms/s   script ms/s   layout ms/s   estilo ms/s   layouts/s   estilos/s');
+    for (const taxa of TAXAS) {
+        await pagina.evaluate(t => window.__bancada.iniciar(t), taxa);
+        await new Promise(r => setTimeout(r, 1000)); // Aquecimento
+        const antes = metricas(await cdp.send('Performance.getMetrics'));
+        await new Promise(r => setTimeout(r, SEGUNDOS * 1000));
+        const depois = metricas(await cdp.send('Performance.getMetrics'));
+        await pagina.evaluate(() => window.__bancada.parar());
+
+        const segundos = depois.Timestamp - antes.Timestamp;
+        const porSegundo = chave => (depois[chave] - antes[chave]) / segundos;
+        console.log([
+            String(taxa).padStart(6),
+            (porSegundo('TaskDuration') * 1000).toFixed(2).padStart(14),
+            (porSegundo('ScriptDuration') * 1000).toFixed(2).padStart(13),
+            (porSegundo('LayoutDuration') * 1000).toFixed(2).padStart(13),
+            (porSegundo('RecalcStyleDuration') * 1000).toFixed(2).padStart(13),
+            porSegundo('LayoutCount').toFixed(1).padStart(11),
+            porSegundo('RecalcStyleCount').toFixed(1).padStart(11),
+        ].join(' '));
+    }
+    await navegador.close();
+})();
@@ -0,0 +1,234 @@
+"""
+bancada_ingestao.py
+Vazão e latência de ingestão do servidor.py com os dois protocolos das placas ao mesmo
+tempo: linhas TCP em lote (porta 8082, como o rosaDosVentosWEB.c) e datagramas UDP do
+joystick (porta 8084, com SEQ), só TCP, só UDP e misto, em algumas taxas oferecidas.
+
+Uso (o servidor precisa do websockets no PYTHONPATH):
+    python bancada_ingestao.py [--servidor caminho/servidor.py] [--segundos N] [--taxas 1000,5000]
+                               [--cenarios tcp,misto] [--shards 1,2,4,8]
+
+O servidor é iniciado em um diretório temporário (log e amostras.jsonl ficam lá) e um
+cliente WebSocket faz o papel do dashboard. Cada amostra leva no VRX o instante do envio
+(ms do relógio monotônico, que é o mesmo para todos os processos da máquina), de onde sai
+a latência envio -> dashboard. Cada placa simulada usa um IP de origem próprio
+(127.0.0.x), já que o servidor identifica a placa pelo IP.
+O gerador roda em outro processo, na mesma máquina: com poucos núcleos ele disputa a CPU
+com o servidor, o que aparece nas colunas "cpu gerador" e "cpu dashboard" (o cliente
+WebSocket desta bancada). "Faltando" são as amostras que não chegaram ao dashboard até
+ESPERA_ESVAZIAR_S depois do fim do envio: descartadas ou ainda na fila.
+Com --shards, o servidor é reiniciado para cada número de shards TCP e a coluna "cpu
+servidor" soma o processo principal e os shards (100% = um núcleo inteiro).
+Para comparar com a versão anterior do servidor:
+    git show c9e7cc9:"Aplicacoes IoT/Enunciado_3/servidor.py" > /tmp/servidor_antes.py
+    python bancada_ingestao.py --servidor /tmp/servidor_antes.py
+"""
+import argparse
+import asyncio
+import json
+import multiprocessing
+import os
+import signal
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+import websockets
+
+DIRETORIO_SERVIDOR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+PORTA_TCP = 8082
+PORTA_WEBSOCKET = 8083
+PORTA_UDP_JOYSTICK = 8084
+
+PLACAS_TCP = 16
+PLACAS_UDP = 16
+PERIODO_LOTE_TCP_S = 0.05      # A placa junta as linhas e envia um lote por vez
+TICK_GERADOR_S = 0.005
+MODULO_CARIMBO = 1_000_000     # O VRX leva o instante do envio em ms, módulo isto
+ESPERA_ESVAZIAR_S = 1.0
+
+CENARIOS = {
+    # nome: fração da taxa oferecida que vai por TCP
+    "tcp": 1.0,
+    "udp": 0.0,
+    "misto": 0.5,
+}
+
+
+def agora_ms():
+    return int(time.monotonic() * 1000)
+
+
+def tempo_cpu_s(pid):
+    """ utime + stime do processo e dos filhos vivos (os shards), de /proc/<pid>/stat. """
+    with open(f"/proc/{pid}/stat") as f:
+        campos = f.read().rsplit(")", 1)[1].split()
+    total = (int(campos[11]) + int(campos[12])) / os.sysconf("SC_CLK_TCK")
+    with open(f"/proc/{pid}/task/{pid}/children") as f:
+        filhos = [int(filho) for filho in f.read().split()]
+    return total + sum(tempo_cpu_s(filho) for filho in filhos)
+
+
+def gerar_carga(taxa, fracao_tcp, segundos, resultado):
+    """ Processo gerador: envia 'taxa' amostras/s por 'segundos', divididas entre as placas. """
+    taxa_tcp = taxa * fracao_tcp
+    taxa_udp = taxa - taxa_tcp
+    placas_tcp = []
+    if taxa_tcp:
+        for i in range(PLACAS_TCP):
+            s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+            s.bind((f"127.0.0.{10 + i}", 0))
+            s.connect(("127.0.0.1", PORTA_TCP))
+            placas_tcp.append(s)
+    placas_udp = []
+    if taxa_udp:
+        for i in range(PLACAS_UDP):
+            s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            s.bind((f"127.0.0.{100 + i}", 0))
+            placas_udp.append(s)
+    sequencias = [0] * len(placas_udp)
+
+    enviadas_tcp = enviadas_udp = 0
+    linhas_tcp = [[] for _ in placas_tcp]
+    proximo_lote = time.monotonic() + PERIODO_LOTE_TCP_S
+    inicio = time.monotonic()
+    while True:
+        agora = time.monotonic()
+        decorrido = agora - inicio
+        if decorrido >= segundos:
+            break
+        carimbo = agora_ms() % MODULO_CARIMBO
+        # Quantas amostras já deveriam ter saído até aqui, menos as que saíram
+        for _ in range(int(decorrido * taxa_tcp) - enviadas_tcp):
+            i = enviadas_tcp % len(placas_tcp)
+            linhas_tcp[i].append(f"VRX={carimbo} VRY=2048 BTN=0 A=0 B=0 TEMP=25.3 UMI=60.1\n")
+            enviadas_tcp += 1
+        for _ in range(int(decorrido * taxa_udp) - enviadas_udp):
+            i = enviadas_udp % len(placas_udp)
+            sequencias[i] += 1
+            placas_udp[i].sendto(f"SEQ={sequencias[i]} VRX={carimbo} VRY=2048".encode(),
+                                 ("127.0.0.1", PORTA_UDP_JOYSTICK))
+            enviadas_udp += 1
+        if agora >= proximo_lote:
+            for s, linhas in zip(placas_tcp, linhas_tcp):
+                if linhas:
+                    s.sendall("".join(linhas).encode())
+                    linhas.clear()
+            proximo_lote += PERIODO_LOTE_TCP_S
+        time.sleep(TICK_GERADOR_S)
+    for s, linhas in zip(placas_tcp, linhas_tcp):
+        if linhas:
+            s.sendall("".join(linhas).encode())
+    resultado.put((enviadas_tcp, enviadas_udp, time.process_time()))
+    time.sleep(ESPERA_ESVAZIAR_S)
+    for s in placas_tcp + placas_udp:
+        s.close()
+
+
+async def medir(taxa, fracao_tcp, segundos, pid_servidor):
+    latencias = []
+    recebidas_tcp = recebidas_udp = 0
+    async with websockets.connect(f"ws://127.0.0.1:{PORTA_WEBSOCKET}", max_queue=None) as ws:
+        # Descarta o snapshot com o estado das rodadas anteriores
+        try:
+            await asyncio.wait_for(ws.recv(), 0.5)
+        except asyncio.TimeoutError:
+            pass
+        resultado = multiprocessing.Queue()
+        gerador = multiprocessing.Process(target=gerar_carga, args=(taxa, fracao_tcp, segundos, resultado))
+        cpu_antes = tempo_cpu_s(pid_servidor)
+        cpu_dashboard_antes = time.process_time()
+        gerador.start()
+        limite = time.monotonic() + segundos + ESPERA_ESVAZIAR_S
+        while True:
+            restante = limite - time.monotonic()
+            if restante <= 0:
+                break
+            try:
+                mensagem = await asyncio.wait_for(ws.recv(), restante)
+            except asyncio.TimeoutError:
+                break
+            recebido = agora_ms() % MODULO_CARIMBO
+            campos = json.loads(mensagem)
+            if 'VRX' not in campos:
+                continue
+            if 'BTN' in campos:
+                recebidas_tcp += 1
+            else:
+                recebidas_udp += 1
+            latencias.append((recebido - campos['VRX']) % MODULO_CARIMBO)
+        cpu_servidor = tempo_cpu_s(pid_servidor) - cpu_antes
+        cpu_dashboard = time.process_time() - cpu_dashboard_antes
+        enviadas_tcp, enviadas_udp, cpu_gerador = resultado.get()
+        gerador.join()
+    latencias.sort()
+    enviadas = enviadas_tcp + enviadas_udp
+    recebidas = recebidas_tcp + recebidas_udp
+    percentil = lambda p: latencias[min(len(latencias) - 1, int(p * len(latencias)))] if latencias else float('nan')
+    return {
+        'enviadas': enviadas,
+        'entregues_por_s': recebidas / segundos,
+        'faltando_tcp': 1 - recebidas_tcp / enviadas_tcp if enviadas_tcp else 0.0,
+        'faltando_udp': 1 - recebidas_udp / enviadas_udp if enviadas_udp else 0.0,
+        'p50_ms': percentil(0.50),
+        'p99_ms': percentil(0.99),
+        'cpu_servidor': cpu_servidor / (segundos + ESPERA_ESVAZIAR_S),
+        'cpu_gerador': cpu_gerador / segundos,
+        'cpu_dashboard': cpu_dashboard / (segundos + ESPERA_ESVAZIAR_S),
+    }
+
+
+def esperar_porta(porta, limite_s=10):
+    fim = time.monotonic() + limite_s
+    while time.monotonic() < fim:
+        try:
+            socket.create_connection(("127.0.0.1", porta), 0.2).close()
+            return
+        except OSError:
+            time.sleep(0.1)
+    raise RuntimeError(f"servidor não abriu a porta {porta}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[2])
+    parser.add_argument("--servidor", default=os.path.join(DIRETORIO_SERVIDOR, "servidor.py"))
+    parser.add_argument("--segundos", type=float, default=5)
+    parser.add_argument("--taxas", default="1000,5000,20000", help="amostras/s oferecidas, separadas por vírgula")
+    parser.add_argument("--cenarios", default=",".join(CENARIOS), help="entre " + ", ".join(CENARIOS))
+    parser.add_argument("--shards", default="1", help="números de shards TCP do servidor, separados por vírgula")
+    argumentos = parser.parse_args()
+    taxas = [int(t) for t in argumentos.taxas.split(",")]
+    cenarios = argumentos.cenarios.split(",")
+    lista_shards = [int(n) for n in argumentos.shards.split(",")]
+
+    ambiente = dict(os.environ)
+    ambiente["PYTHONPATH"] = os.pathsep.join(filter(None, [DIRETORIO_SERVIDOR, ambiente.get("PYTHONPATH")]))
+    print(f"servidor: {argumentos.servidor} ({os.cpu_count()} CPU), {argumentos.segundos:g}s por rodada")
+    print(f"{'shards':>6} {'cenario':>8} {'oferecidas/s':>12} {'entregues/s':>11} {'faltando tcp':>12} "
+          f"{'faltando udp':>12} {'p50 ms':>7} {'p99 ms':>7} {'cpu servidor':>12} {'cpu gerador':>11} "
+          f"{'cpu dashboard':>13}")
+    for shards in lista_shards:
+        with tempfile.TemporaryDirectory() as diretorio:
+            # Sessão própria: o grupo inteiro (principal e shards) é encerrado no fim
+            servidor = subprocess.Popen([sys.executable, os.path.abspath(argumentos.servidor), str(shards)],
+                                        cwd=diretorio, env=ambiente, start_new_session=True,
+                                        stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+            try:
+                esperar_porta(PORTA_WEBSOCKET)
+                esperar_porta(PORTA_TCP)
+                for nome in cenarios:
+                    for taxa in taxas:
+                        r = asyncio.run(medir(taxa, CENARIOS[nome], argumentos.segundos, servidor.pid))
+                        print(f"{shards:>6} {nome:>8} {taxa:>12} {r['entregues_por_s']:>11.0f} "
+                              f"{r['faltando_tcp']:>12.1%} {r['faltando_udp']:>12.1%} {r['p50_ms']:>7} "
+                              f"{r['p99_ms']:>7} {r['cpu_servidor']:>12.0%} {r['cpu_gerador']:>11.0%} "
+                              f"{r['cpu_dashboard']:>13.0%}", flush=True)
+            finally:
+                os.killpg(servidor.pid, signal.SIGTERM)
+                servidor.wait()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,272 @@
+"""
+bancada_mqtt.py
+Placas simuladas (rosaDosVentosWEB/simulacao/sim_mqtt, o firmware com TRANSPORTE_MQTT = 1)
+publicando em um broker local: mensagens/s, RAM da placa e do broker e latência de ponta
+a ponta (leitura do sensor na placa -> assinante), com 1, 10 e 50 placas.
+
+Uso (compile antes a simulação: cmake -S rosaDosVentosWEB/simulacao -B rosaDosVentosWEB/simulacao/build
+&& cmake --build rosaDosVentosWEB/simulacao/build):
+    python bancada_mqtt.py [--placas 1,10,50] [--segundos 30] [--porta 18830] [--broker auto|mosquitto|python]
+
+O broker é o mosquitto, se estiver no PATH, ou o broker_mqtt.py desta pasta. Um assinante
+de rosadosventos/# mede a chegada de cada mensagem no relógio monotônico, o mesmo das
+placas simuladas (que andam em tempo real com um broker, ver plataforma.h). O cenário do
+sim_mqtt.c diz quando cada dado foi lido: o VRX de cada posição do joystick codifica o
+instante da leitura, e o botão A é pressionado uma vez a cada 2s e solto 200ms depois.
+Assim a latência inclui a espera no lote do joystick e a varredura dos botões, não só o
+broker. "Perdidas" compara o que as placas publicaram (QoS 0 e 1) com o que o assinante
+recebeu; o "offline" do last will de cada placa, no fim, não entra na conta.
+Todos os processos rodam na mesma máquina: com poucos núcleos, as placas, o broker e o
+assinante disputam a CPU (coluna "atraso relogio": quanto a placa mais atrasada ficou
+atrás do tempo real).
+"""
+import argparse
+import asyncio
+import os
+import shutil
+import signal
+import socket
+import struct
+import subprocess
+import sys
+import time
+
+DIRETORIO_BANCADA = os.path.dirname(os.path.abspath(__file__))
+DIRETORIO_ENUNCIADO = os.path.dirname(DIRETORIO_BANCADA)
+SIM_PADRAO = os.path.join(DIRETORIO_ENUNCIADO, "rosaDosVentosWEB", "simulacao", "build", "sim_mqtt")
+
+PERIODO_JOYSTICK_MS = 10      # Leitura do joystick no firmware; o VRX muda 64 a cada uma
+POSICOES_NO_CICLO = 64
+PERIODO_BOTAO_A_MS = 2000     # Cenário do sim_mqtt.c
+DURACAO_BOTAO_A_MS = 200
+PASSO_BOTAO_A_MS = 7
+VARREDURA_BOTOES_MS = 50
+ESPERA_ESVAZIAR_S = 0.5
+
+
+def percentil(valores, p):
+    if not valores:
+        return float("nan")
+    valores = sorted(valores)
+    return valores[min(len(valores) - 1, int(p * len(valores)))]
+
+
+def esperar_porta(porta, limite_s=10):
+    fim = time.monotonic() + limite_s
+    while time.monotonic() < fim:
+        try:
+            socket.create_connection(("127.0.0.1", porta), 0.2).close()
+            return
+        except OSError:
+            time.sleep(0.1)
+    raise RuntimeError(f"broker não abriu a porta {porta}")
+
+
+def iniciar_broker(tipo, porta):
+    if tipo == "auto":
+        tipo = "mosquitto" if shutil.which("mosquitto") else "python"
+    if tipo == "mosquitto":
+        comando = ["mosquitto", "-p", str(porta)]
+    else:
+        comando = [sys.executable, os.path.join(DIRETORIO_BANCADA, "broker_mqtt.py"), str(porta)]
+    processo = subprocess.Popen(comando, start_new_session=True,
+                                stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    esperar_porta(porta)
+    return tipo, processo
+
+
+def memoria_kb(pid):
+    with open(f"/proc/{pid}/status") as f:
+        for linha in f:
+            if linha.startswith("VmRSS:"):
+                return int(linha.split()[1])
+    return 0
+
+
+def tempo_cpu_s(pid):
+    with open(f"/proc/{pid}/stat") as f:
+        campos = f.read().rsplit(")", 1)[1].split()
+    return (int(campos[11]) + int(campos[12])) / os.sysconf("SC_CLK_TCK")
+
+
+# --- Assinante (MQTT 3.1.1 mínimo) ---
+
+def pacote(tipo_e_flags, corpo):
+    tamanho = len(corpo)
+    cabecalho = bytearray([tipo_e_flags])
+    while True:
+        byte, tamanho = tamanho % 128, tamanho // 128
+        cabecalho.append(byte | (0x80 if tamanho else 0))
+        if not tamanho:
+            return bytes(cabecalho) + corpo
+
+
+def texto(dados):
+    return struct.pack("!H", len(dados)) + dados
+
+
+async def ler_pacote(leitor):
+    cabecalho = await leitor.readexactly(1)
+    tamanho, multiplicador = 0, 1
+    while True:
+        byte = (await leitor.readexactly(1))[0]
+        tamanho += (byte & 0x7F) * multiplicador
+        multiplicador *= 128
+        if not byte & 0x80:
+            break
+    return cabecalho[0], await leitor.readexactly(tamanho)
+
+
+async def assinar(porta, recebidas, pronto):
+    """ Guarda (instante de chegada, tópico, payload) de cada PUBLISH não retido. """
+    leitor, escritor = await asyncio.open_connection("127.0.0.1", porta)
+    escritor.write(pacote(0x10, texto(b"MQTT") + b"\x04\x02\x00\x00" + texto(b"bancada")))
+    escritor.write(pacote(0x82, b"\x00\x01" + texto(b"rosadosventos/#") + b"\x00"))
+    try:
+        while True:
+            tipo, corpo = await ler_pacote(leitor)
+            chegada = time.monotonic()
+            if tipo >> 4 == 9:        # SUBACK
+                pronto.set()
+            elif tipo >> 4 == 3 and not tipo & 1:
+                tamanho, = struct.unpack_from("!H", corpo)
+                recebidas.append((chegada, corpo[2:2 + tamanho].decode(), corpo[2 + tamanho:].decode()))
+    finally:
+        escritor.close()
+
+
+# --- Rodada ---
+
+def interpretar_saida(saida):
+    """ Linhas [SIM] do sim_mqtt: início do tempo virtual, contagens e memória. """
+    resultado = {}
+    for linha in saida.splitlines():
+        if linha.startswith("[SIM] memoria do publicador="):
+            resultado["memoria"] = linha[len("[SIM] "):]
+        for campo in linha.split():
+            chave, _, valor = campo.partition("=")
+            if chave in ("inicio", "placa", "qos0", "qos1", "pubacks", "conexoes"):
+                resultado[chave] = valor
+    return resultado
+
+
+def mudanca_botao_a(agora_ms, deslocamento_ms):
+    """ Último instante, até agora, em que o botão A foi pressionado (deslocamento 0) ou
+    solto (DURACAO_BOTAO_A_MS), como em botao_a_periodico() do sim_mqtt.c. """
+    k = (agora_ms - deslocamento_ms) // PERIODO_BOTAO_A_MS
+    while True:
+        instante = k * PERIODO_BOTAO_A_MS + k * PASSO_BOTAO_A_MS % VARREDURA_BOTOES_MS + deslocamento_ms
+        if instante <= agora_ms:
+            return instante
+        k -= 1
+
+
+def latencias(recebidas, inicios):
+    """ Leitura do sensor -> assinante, em ms, para as posições do joystick e o botão A. """
+    joystick, botoes = [], []
+    primeira_botoes = set()
+    for chegada, topico, payload in recebidas:
+        _, placa, sensor = topico.split("/")
+        if placa not in inicios:
+            continue
+        agora_ms = (chegada - inicios[placa]) * 1000
+        if sensor == "joystick":
+            for linha in payload.splitlines():
+                campos = dict(campo.split("=") for campo in linha.split())
+                posicao = int(campos["VRX"]) // 64
+                # Última leitura, até agora, que deu esta posição
+                ciclo = (agora_ms / PERIODO_JOYSTICK_MS - posicao) // POSICOES_NO_CICLO
+                leitura_ms = PERIODO_JOYSTICK_MS * (ciclo * POSICOES_NO_CICLO + posicao)
+                joystick.append(agora_ms - leitura_ms)
+        elif sensor == "botoes":
+            if placa not in primeira_botoes:
+                primeira_botoes.add(placa)   # Estado atual, republicado a cada conexão
+                continue
+            campos = dict(campo.split("=") for campo in payload.split())
+            botoes.append(agora_ms - mudanca_botao_a(agora_ms, 0 if campos["A"] == "1" else DURACAO_BOTAO_A_MS))
+    return joystick, botoes
+
+
+async def rodada(argumentos, placas, pid_broker):
+    recebidas = []
+    pronto = asyncio.Event()
+    assinante = asyncio.create_task(assinar(argumentos.porta, recebidas, pronto))
+    await asyncio.wait_for(pronto.wait(), 5)
+
+    cpu_antes = tempo_cpu_s(pid_broker)
+    sims = [await asyncio.create_subprocess_exec(
+                argumentos.sim, str(argumentos.porta), str(argumentos.segundos), f"SIM{i:013d}",
+                stdout=asyncio.subprocess.PIPE, stderr=asyncio.subprocess.PIPE)
+            for i in range(placas)]
+    saidas = await asyncio.gather(*(sim.communicate() for sim in sims))
+    await asyncio.sleep(ESPERA_ESVAZIAR_S)
+    cpu_broker = tempo_cpu_s(pid_broker) - cpu_antes
+    memoria_broker = memoria_kb(pid_broker)
+    assinante.cancel()
+
+    falhas = [erro.decode().strip() for sim, (_, erro) in zip(sims, saidas) if sim.returncode]
+    resultados = [interpretar_saida(saida.decode()) for saida, _ in saidas]
+    inicios = {r["placa"]: float(r["inicio"]) for r in resultados if "placa" in r}
+    atraso_relogio = max(float(linha.split("relogio=")[1].split()[0])
+                         for saida, _ in saidas for linha in saida.decode().splitlines() if "relogio=" in linha)
+    publicadas_qos0 = sum(int(r.get("qos0", 0)) for r in resultados)
+    publicadas_qos1 = sum(int(r.get("qos1", 0)) for r in resultados)
+    recebidas_qos0 = sum(1 for _, topico, _ in recebidas if topico.endswith("/joystick"))
+    recebidas_qos1 = sum(1 for _, topico, payload in recebidas
+                         if not topico.endswith("/joystick") and payload != "offline")
+    joystick, botoes = latencias(recebidas, inicios)
+    return {
+        "publicadas_por_s": (publicadas_qos0 + publicadas_qos1) / argumentos.segundos,
+        "entregues_por_s": len(recebidas) / argumentos.segundos,
+        "perdidas_qos0": publicadas_qos0 - recebidas_qos0,
+        "perdidas_qos1": publicadas_qos1 - recebidas_qos1,
+        "joystick_p50": percentil(joystick, 0.5), "joystick_p99": percentil(joystick, 0.99),
+        "botoes_p50": percentil(botoes, 0.5), "botoes_p99": percentil(botoes, 0.99),
+        "cpu_broker": cpu_broker / argumentos.segundos,
+        "memoria_broker_mb": memoria_broker / 1024,
+        "atraso_relogio_ms": atraso_relogio,
+        "memoria_placa": resultados[0].get("memoria", "?"),
+        "falhas": falhas,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[2])
+    parser.add_argument("--sim", default=SIM_PADRAO, help="executável sim_mqtt")
+    parser.add_argument("--placas", default="1,10,50", help="números de placas simuladas, separados por vírgula")
+    parser.add_argument("--segundos", type=int, default=30)
+    parser.add_argument("--porta", type=int, default=18830)
+    parser.add_argument("--broker", default="auto", choices=["auto", "mosquitto", "python"])
+    argumentos = parser.parse_args()
+    if not os.path.exists(argumentos.sim):
+        parser.error(f"{argumentos.sim} não existe (compile a simulação, ver acima)")
+
+    tipo, broker = iniciar_broker(argumentos.broker, argumentos.porta)
+    falhou = False
+    try:
+        print(f"broker: {tipo} ({os.cpu_count()} CPU), {argumentos.segundos}s por rodada")
+        memoria_placa_mostrada = False
+        print(f"{'placas':>6} {'publicadas/s':>12} {'entregues/s':>11} {'perdidas q0':>11} {'perdidas q1':>11} "
+              f"{'joy p50 ms':>10} {'joy p99 ms':>10} {'btn p50 ms':>10} {'btn p99 ms':>10} "
+              f"{'cpu broker':>10} {'RAM broker':>10} {'atraso relogio':>14}")
+        for placas in [int(n) for n in argumentos.placas.split(",")]:
+            r = asyncio.run(rodada(argumentos, placas, broker.pid))
+            if not memoria_placa_mostrada:
+                print(f"placa: {r['memoria_placa']}")
+                memoria_placa_mostrada = True
+            print(f"{placas:>6} {r['publicadas_por_s']:>12.1f} {r['entregues_por_s']:>11.1f} "
+                  f"{r['perdidas_qos0']:>11} {r['perdidas_qos1']:>11} "
+                  f"{r['joystick_p50']:>10.1f} {r['joystick_p99']:>10.1f} {r['botoes_p50']:>10.1f} "
+                  f"{r['botoes_p99']:>10.1f} {r['cpu_broker']:>10.1%} {r['memoria_broker_mb']:>8.1f}MB "
+                  f"{r['atraso_relogio_ms']:>11.1f} ms", flush=True)
+            for falha in r["falhas"]:
+                print(f"  sim_mqtt falhou: {falha}", file=sys.stderr)
+                falhou = True
+    finally:
+        os.killpg(broker.pid, signal.SIGTERM)
+        broker.wait()
+    return 1 if falhou else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,164 @@
+"""
+bancada_regras.py
+Custo do motor de regras do servidor.py (regras.py) por amostra, em função do número de
+placas e do número de regras. Roda o MotorRegras direto, sem o servidor, num relógio virtual.
+
+Uso:
+    python bancada_regras.py [--placas 1000,10000,20000] [--regras 10,100,200] [--segundos N]
+                             [--valores estaveis,sorteados]
+
+Cada combinação roda num processo próprio (o estado de uma não pesa na memória da outra).
+As regras são sorteadas sobre os campos numéricos das linhas da placa (VRX VRY BTN A B TEMP
+UMI): um terço com o campo puro, um terço com "por <N>s" e um terço com taxa(); os limites
+caem no meio da faixa de cada campo. Toda placa manda uma amostra por segundo virtual, com
+todos os campos, e vencer_prazos() roda a cada PERIODO_PRAZOS_REGRAS_S virtual, como no
+servidor.py. Os valores vêm de dois jeitos, que cercam um sensor real:
+  - estaveis: cada placa repete sempre a mesma amostra; nenhuma condição muda (só os
+    alertas com "por" da primeira passada ativam, uma vez, quando o prazo vence);
+  - sorteados: cada amostra é sorteada de novo; as condições mudam o tempo todo, o que põe
+    muito mais prazos no heap e eventos do que um sensor real (caso pessimista).
+A primeira passada por todas as placas cria os estados e não entra na medição.
+Colunas: "estados" é o número de EstadoRegra (placas x regras), "MB" o crescimento do RSS
+ao criá-los, "us/amostra" o tempo de avaliar() por amostra, "us prazos" o de
+vencer_prazos() dividido pelas amostras do período, e "amostras/s" o que um núcleo
+sustenta só com as regras.
+"""
+import argparse
+import multiprocessing
+import os
+import random
+import sys
+import time
+
+DIRETORIO_SERVIDOR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+sys.path.insert(0, DIRETORIO_SERVIDOR)
+
+from regras import MotorRegras, Regra  # noqa: E402
+
+PERIODO_PRAZOS_REGRAS_S = 0.5     # O mesmo do servidor.py
+PERIODO_AMOSTRA_S = 1.0           # Uma amostra por placa por segundo virtual
+AMOSTRAS_SORTEADAS = 4096         # As amostras saem de um conjunto sorteado antes da medição
+ESTADOS_MAXIMOS = 5_000_000       # Acima disso (~1 GB) a combinação é pulada
+
+# Campo -> (mínimo, máximo) sorteado nas amostras
+FAIXAS = {
+    'VRX': (0, 4095), 'VRY': (0, 4095),
+    'BTN': (0, 1), 'A': (0, 1), 'B': (0, 1),
+    'TEMP': (15.0, 40.0), 'UMI': (30.0, 90.0),
+}
+
+
+def sortear_regras(quantidade, sorteio):
+    regras = []
+    campos = sorted(FAIXAS)
+    for i in range(quantidade):
+        campo = campos[i % len(campos)]
+        minimo, maximo = FAIXAS[campo]
+        limite = round(sorteio.uniform(minimo, maximo), 1)
+        tipo = i // len(campos) % 3
+        if tipo == 0:
+            expressao = f"{campo} > {limite}"
+        elif tipo == 1:
+            expressao = f"{campo} > {limite} por {sorteio.choice((2, 10, 60))}s"
+        else:
+            expressao = f"taxa({campo}) > {round((maximo - minimo) / 4, 1)}"
+        regras.append(Regra(f"regra{i}", expressao))
+    return regras
+
+
+def sortear_amostras(sorteio):
+    amostras = []
+    for _ in range(AMOSTRAS_SORTEADAS):
+        amostra = {}
+        for campo, (minimo, maximo) in FAIXAS.items():
+            if isinstance(minimo, float):
+                amostra[campo] = round(sorteio.uniform(minimo, maximo), 2)
+            else:
+                amostra[campo] = sorteio.randint(minimo, maximo)
+        amostras.append(amostra)
+    return amostras
+
+
+def rss_mb():
+    with open("/proc/self/statm") as f:
+        return int(f.read().split()[1]) * os.sysconf("SC_PAGE_SIZE") / 2**20
+
+
+def medir(placas, quantidade_regras, sorteados, segundos, resultado):
+    """ Processo de uma combinação: devolve em 'resultado' as colunas da tabela. """
+    sorteio = random.Random(placas * 1000 + quantidade_regras)
+    motor = MotorRegras(sortear_regras(quantidade_regras, sorteio))
+    amostras = sortear_amostras(sorteio)
+    dispositivos = [f"127.{i >> 16 & 255}.{i >> 8 & 255}.{i & 255}" for i in range(placas)]
+    passo_t = PERIODO_AMOSTRA_S / placas
+    amostras_por_prazo = max(1, int(PERIODO_PRAZOS_REGRAS_S / passo_t))
+
+    # Primeira passada: cria o estado de todas as placas em todas as regras
+    rss_antes = rss_mb()
+    t = 0.0
+    for i, dispositivo in enumerate(dispositivos):
+        motor.avaliar(dispositivo, amostras[i % AMOSTRAS_SORTEADAS], t)
+        t += passo_t
+    motor.vencer_prazos(t)
+    memoria_mb = rss_mb() - rss_antes
+
+    tempo_avaliar = tempo_prazos = 0.0
+    enviadas = eventos = 0
+    i = 0
+    fim = time.perf_counter() + segundos
+    while time.perf_counter() < fim:
+        inicio = time.perf_counter()
+        for _ in range(amostras_por_prazo):
+            # Estáveis: a placa repete a amostra da primeira passada
+            amostra = amostras[(i if sorteados else i % placas) % AMOSTRAS_SORTEADAS]
+            eventos += len(motor.avaliar(dispositivos[i % placas], amostra, t))
+            t += passo_t
+            i += 1
+        meio = time.perf_counter()
+        eventos += len(motor.vencer_prazos(t))
+        tempo_avaliar += meio - inicio
+        tempo_prazos += time.perf_counter() - meio
+        enviadas += amostras_por_prazo
+
+    estados = sum(len(regra.estados) for regra in motor.regras)
+    resultado.update(estados=estados, memoria_mb=memoria_mb, enviadas=enviadas,
+                     us_avaliar=tempo_avaliar / enviadas * 1e6, us_prazos=tempo_prazos / enviadas * 1e6,
+                     eventos=eventos / enviadas, heap=len(motor.prazos))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--placas", default="1000,10000,20000")
+    parser.add_argument("--regras", default="10,100,200")
+    parser.add_argument("--valores", default="estaveis,sorteados")
+    parser.add_argument("--segundos", type=float, default=3.0, help="medição de cada combinação")
+    args = parser.parse_args()
+
+    print(f"{os.cpu_count()} CPU, {args.segundos:g}s por combinação, depois da passada que cria os estados")
+    print(f"{'valores':>9} {'placas':>7} {'regras':>6} {'estados':>9} {'MB':>6} {'us/amostra':>10} {'us prazos':>9} "
+          f"{'eventos/amostra':>15} {'heap':>7} {'amostras/s':>10}")
+    with multiprocessing.Manager() as gerente:
+        for valores in args.valores.split(","):
+            for placas in (int(p) for p in args.placas.split(",")):
+                for quantidade_regras in (int(r) for r in args.regras.split(",")):
+                    combinacao = f"{valores:>9} {placas:>7} {quantidade_regras:>6}"
+                    if placas * quantidade_regras > ESTADOS_MAXIMOS:
+                        print(f"{combinacao} pulado: mais de {ESTADOS_MAXIMOS} estados")
+                        continue
+                    resultado = gerente.dict()
+                    processo = multiprocessing.Process(
+                        target=medir, args=(placas, quantidade_regras, valores == "sorteados", args.segundos, resultado))
+                    processo.start()
+                    processo.join()
+                    if processo.exitcode != 0:
+                        print(f"{combinacao} falhou (código {processo.exitcode})")
+                        continue
+                    r = dict(resultado)
+                    us_total = r['us_avaliar'] + r['us_prazos']
+                    print(f"{combinacao} {r['estados']:>9} {r['memoria_mb']:>6.0f} "
+                          f"{r['us_avaliar']:>10.1f} {r['us_prazos']:>9.2f} {r['eventos']:>15.2f} "
+                          f"{r['heap']:>7} {1e6 / us_total:>10.0f}", flush=True)
+
+
+if __name__ == "__main__":
+    main()
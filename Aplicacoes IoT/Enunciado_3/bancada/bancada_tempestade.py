@@ -0,0 +1,254 @@
+"""
+bancada_tempestade.py
+Tempestade de reconexões no servidor.py: N placas caem juntas (queda do Wi-Fi do local,
+servidor reiniciado) e voltam ao mesmo tempo. Mede o tempo de cada placa, da queda até
+a primeira amostra aceita (a que chega ao dashboard), com e sem o sorteio da espera de
+reconexão do firmware e com e sem a admissão de conexões do servidor (admissao.py).
+
+Uso (o servidor precisa do websockets no PYTHONPATH):
+    python bancada_tempestade.py [--placas 10000] [--fracao-novas 0.2] [--limite-s 120]
+                                 [--processos 4] [--cenarios jitter+admissao,admissao,jitter,nenhum]
+
+Cada placa simulada usa um IP de origem próprio em 127.0.0.0/8 e segue o firmware
+(rosaDosVentosWEB.c): conecta, envia a primeira amostra e, se o servidor recusar com
+"RETRY=<ms>" ou a conexão falhar, espera e tenta de novo.
+  - com jitter: a espera é sorteada entre 50% e 150% do maior entre o intervalo de
+    reconexão e o RETRY pedido, inclusive a primeira depois da queda;
+  - sem jitter: todas tentam no instante da queda e depois esperam exatamente isso.
+Antes da queda, as placas conhecidas já mandaram uma amostra (um datagrama UDP do
+joystick, que não passa pela admissão); as outras (--fracao-novas) o servidor nunca viu.
+Sem admissão, o servidor roda com taxas e rajadas tão grandes que aceita tudo; o que
+segura a tempestade é só a fila do listen() (FILA_HANDSHAKES) e o SYN reenviado pelo
+kernel do cliente.
+O servidor é reiniciado a cada cenário, em um diretório temporário. As placas rodam em
+--processos processos e o dashboard (cliente WebSocket) em outro, na mesma máquina: com
+poucos núcleos eles disputam a CPU com o servidor, o que aparece nas colunas de CPU.
+"Sem amostra" são as placas que não tiveram nenhuma amostra aceita até --limite-s.
+"""
+import argparse
+import asyncio
+import json
+import multiprocessing
+import os
+import random
+import resource
+import signal
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+import websockets
+
+from bancada_ingestao import DIRETORIO_SERVIDOR, PORTA_TCP, PORTA_UDP_JOYSTICK, PORTA_WEBSOCKET, \
+    esperar_porta, tempo_cpu_s
+
+INTERVALO_RECONEXAO_S = 3.0        # INTERVALO_RECONEXAO_TCP_MS do firmware
+ESPERA_MAXIMA_SERVIDOR_S = 60.0    # ESPERA_MAXIMA_SERVIDOR_MS do firmware
+LINHA_PLACA = b"BTN=0 A=0 B=0 TEMP=25.0 UMI=60.0\n"
+ATRASO_QUEDA_S = 1.0               # Da partida dos geradores até a queda (todos prontos)
+LOTE_AQUECIMENTO = 200             # Datagramas por vez no aquecimento (a fila UDP é limitada)
+LIMITE_AQUECIMENTO_S = 60
+PERIODO_PARADA_S = 0.2             # Os geradores conferem se a bancada já viu todas as placas
+
+CENARIOS = {
+    # nome: (sorteio da espera no firmware, admissão no servidor)
+    "jitter+admissao": (True, True),
+    "admissao": (False, True),
+    "jitter": (True, False),
+    "nenhum": (False, False),
+}
+
+# Servidor com ou sem admissão: as taxas do servidor.py trocadas antes de criar os baldes
+INICIAR_SERVIDOR = """
+import asyncio, sys
+import servidor
+if sys.argv[1] == "0":
+    servidor.TAXA_ADMISSAO_POR_S = servidor.TAXA_ADMISSAO_CONHECIDAS_POR_S = 1e9
+    servidor.RAJADA_ADMISSAO = servidor.RAJADA_ADMISSAO_CONHECIDAS = 10**9
+    servidor.admissao_conexoes = servidor.criar_admissao()
+asyncio.run(servidor.main(1))
+"""
+
+
+def ip_da_placa(indice):
+    return f"127.{1 + indice // 62500}.{indice // 250 % 250 + 1}.{indice % 250 + 1}"
+
+
+def espera_reconexao_s(pedida_s, jitter):
+    """ sortear_espera_reconexao do firmware (ou a espera fixa, sem jitter). """
+    base = max(INTERVALO_RECONEXAO_S, min(pedida_s, ESPERA_MAXIMA_SERVIDOR_S))
+    return random.uniform(base / 2, base * 3 / 2) if jitter else base
+
+
+async def placa(ip, queda, jitter, contagem):
+    """ Uma placa a partir da queda, até a bancada cancelar: tenta, e espera se recusada. """
+    proxima = queda + (espera_reconexao_s(0, jitter) if jitter else 0)
+    while True:
+        await asyncio.sleep(max(0.0, proxima - time.monotonic()))
+        contagem['tentativas'] += 1
+        pedida_s = 0
+        try:
+            reader, writer = await asyncio.wait_for(
+                asyncio.open_connection("127.0.0.1", PORTA_TCP, local_addr=(ip, 0)), INTERVALO_RECONEXAO_S)
+        except (OSError, asyncio.TimeoutError):
+            contagem['falhas'] += 1
+        else:
+            try:
+                writer.write(LINHA_PLACA)
+                # Aceita, a conexão fica aberta (o servidor não escreve); recusada, chega o RETRY
+                resposta = await reader.read(64)
+                if resposta.startswith(b"RETRY="):
+                    contagem['recusas'] += 1
+                    pedida_s = int(resposta[6:].split(b"\n")[0] or 0) / 1000
+            except OSError:
+                pass
+            writer.close()
+        proxima = time.monotonic() + espera_reconexao_s(pedida_s, jitter)
+
+
+def gerar_tempestade(ips, queda, jitter, limite_s, parar, resultado):
+    """ Processo gerador: as placas de 'ips', da queda até o limite (ou até 'parar'). """
+    async def executar():
+        contagem = {'tentativas': 0, 'recusas': 0, 'falhas': 0}
+        tarefas = [asyncio.ensure_future(placa(ip, queda, jitter, contagem)) for ip in ips]
+        while time.monotonic() < queda + limite_s and not parar.is_set():
+            await asyncio.sleep(PERIODO_PARADA_S)
+        for tarefa in tarefas:
+            tarefa.cancel()
+        await asyncio.gather(*tarefas, return_exceptions=True)
+        return contagem
+
+    random.seed(os.getpid())
+    resultado.put(asyncio.run(executar()))
+
+
+async def aquecer(ws, ips):
+    """ As placas conhecidas mandam uma amostra UDP; espera o dashboard ver todas. """
+    vistas = set()
+    for inicio in range(0, len(ips), LOTE_AQUECIMENTO):
+        for ip in ips[inicio:inicio + LOTE_AQUECIMENTO]:
+            # O servidor identifica a placa pelo IP de origem
+            with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as origem:
+                origem.bind((ip, 0))
+                origem.sendto(b"SEQ=1 VRX=2048 VRY=2048", ("127.0.0.1", PORTA_UDP_JOYSTICK))
+        await consumir_ate(ws, vistas, lambda: len(vistas) >= min(len(ips), inicio + LOTE_AQUECIMENTO), 5)
+    await consumir_ate(ws, vistas, lambda: len(vistas) >= len(ips), LIMITE_AQUECIMENTO_S)
+    return len(vistas)
+
+
+async def consumir_ate(ws, vistas, pronto, limite_s):
+    fim = time.monotonic() + limite_s
+    while not pronto() and time.monotonic() < fim:
+        try:
+            mensagem = await asyncio.wait_for(ws.recv(), fim - time.monotonic())
+        except asyncio.TimeoutError:
+            return
+        campos = json.loads(mensagem)
+        if 'DISPOSITIVO' in campos:
+            vistas.add(campos['DISPOSITIVO'])
+
+
+async def medir(jitter, placas, fracao_novas, limite_s, processos, pid_servidor):
+    ips = [ip_da_placa(i) for i in range(placas)]
+    conhecidas = set(ips[int(placas * fracao_novas):])
+    async with websockets.connect(f"ws://127.0.0.1:{PORTA_WEBSOCKET}", max_queue=None) as ws:
+        aquecidas = await aquecer(ws, sorted(conhecidas))
+        if aquecidas < len(conhecidas):
+            raise RuntimeError(f"só {aquecidas} de {len(conhecidas)} placas conhecidas no aquecimento")
+
+        resultado = multiprocessing.Queue()
+        parar = multiprocessing.Event()
+        queda = time.monotonic() + ATRASO_QUEDA_S
+        geradores = [multiprocessing.Process(target=gerar_tempestade,
+                                             args=(ips[i::processos], queda, jitter, limite_s, parar, resultado))
+                     for i in range(processos)]
+        for gerador in geradores:
+            gerador.start()
+        cpu_antes = tempo_cpu_s(pid_servidor)
+
+        primeira_amostra = {}
+        fim = queda + limite_s
+        while len(primeira_amostra) < placas:
+            restante = fim - time.monotonic()
+            if restante <= 0:
+                break
+            try:
+                mensagem = await asyncio.wait_for(ws.recv(), restante)
+            except asyncio.TimeoutError:
+                break
+            campos = json.loads(mensagem)
+            # Só as linhas TCP têm BTN (o aquecimento foi por UDP)
+            if 'BTN' in campos and campos['DISPOSITIVO'] not in primeira_amostra:
+                primeira_amostra[campos['DISPOSITIVO']] = time.monotonic() - queda
+        duracao = max(time.monotonic(), queda) - queda
+        cpu_servidor = (tempo_cpu_s(pid_servidor) - cpu_antes) / max(duracao, 1e-9)
+        parar.set()
+        contagens = [resultado.get() for _ in geradores]
+        for gerador in geradores:
+            gerador.join()
+
+    def percentis(grupo):
+        tempos = sorted(primeira_amostra[ip] for ip in grupo if ip in primeira_amostra)
+        if not tempos:
+            return float('nan'), float('nan'), len(grupo)
+        return (tempos[len(tempos) // 2], tempos[min(len(tempos) - 1, int(0.99 * len(tempos)))],
+                len(grupo) - len(tempos))
+
+    novas = set(ips) - conhecidas
+    return {
+        'conhecidas': percentis(conhecidas),
+        'novas': percentis(novas) if novas else None,
+        'todas': percentis(ips),
+        'tentativas': sum(c['tentativas'] for c in contagens),
+        'recusas': sum(c['recusas'] for c in contagens),
+        'falhas': sum(c['falhas'] for c in contagens),
+        'cpu_servidor': cpu_servidor,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[2])
+    parser.add_argument("--placas", type=int, default=10000)
+    parser.add_argument("--fracao-novas", type=float, default=0.2, help="placas que o servidor nunca viu")
+    parser.add_argument("--limite-s", type=float, default=120, help="tempo máximo depois da queda")
+    parser.add_argument("--processos", type=int, default=4, help="processos geradores das placas")
+    parser.add_argument("--cenarios", default=",".join(CENARIOS), help="entre " + ", ".join(CENARIOS))
+    argumentos = parser.parse_args()
+
+    # Uma conexão por placa no gerador e no servidor
+    _, maximo = resource.getrlimit(resource.RLIMIT_NOFILE)
+    resource.setrlimit(resource.RLIMIT_NOFILE, (maximo, maximo))
+    necessario = argumentos.placas + 100
+    if maximo < necessario:
+        print(f"aviso: limite de arquivos abertos {maximo} < {necessario}: conexões vão falhar", file=sys.stderr)
+
+    ambiente = dict(os.environ)
+    ambiente["PYTHONPATH"] = os.pathsep.join(filter(None, [DIRETORIO_SERVIDOR, ambiente.get("PYTHONPATH")]))
+    print(f"{argumentos.placas} placas ({argumentos.fracao_novas:.0%} novas), {os.cpu_count()} CPU, "
+          f"limite {argumentos.limite_s:g}s; tempos da queda até a primeira amostra aceita, em s")
+    print(f"{'cenario':>16} {'p50':>6} {'p99':>6} {'conhecidas p50':>14} {'p99':>6} {'novas p50':>9} "
+          f"{'p99':>6} {'sem amostra':>11} {'tentativas':>10} {'RETRY':>7} {'falhas':>7} {'cpu servidor':>12}")
+    for nome in argumentos.cenarios.split(","):
+        jitter, admissao = CENARIOS[nome]
+        with tempfile.TemporaryDirectory() as diretorio:
+            servidor = subprocess.Popen([sys.executable, "-c", INICIAR_SERVIDOR, "1" if admissao else "0"],
+                                        cwd=diretorio, env=ambiente, start_new_session=True,
+                                        stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+            try:
+                esperar_porta(PORTA_WEBSOCKET)
+                esperar_porta(PORTA_TCP)
+                r = asyncio.run(medir(jitter, argumentos.placas, argumentos.fracao_novas, argumentos.limite_s,
+                                      argumentos.processos, servidor.pid))
+            finally:
+                os.killpg(servidor.pid, signal.SIGTERM)
+                servidor.wait()
+        novas = r['novas'] or (float('nan'), float('nan'), 0)
+        print(f"{nome:>16} {r['todas'][0]:>6.1f} {r['todas'][1]:>6.1f} {r['conhecidas'][0]:>14.1f} "
+              f"{r['conhecidas'][1]:>6.1f} {novas[0]:>9.1f} {novas[1]:>6.1f} {r['todas'][2]:>11} "
+              f"{r['tentativas']:>10} {r['recusas']:>7} {r['falhas']:>7} {r['cpu_servidor']:>12.0%}", flush=True)
+
+
+if __name__ == "__main__":
+    main()
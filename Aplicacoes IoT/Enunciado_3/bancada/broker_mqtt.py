@@ -0,0 +1,196 @@
+"""
+broker_mqtt.py
+Broker MQTT 3.1.1 mínimo, só para a bancada_mqtt.py quando o mosquitto não está
+instalado: CONNECT (com last will), PUBLISH QoS 0 e 1 (PUBACK), mensagens retidas,
+SUBSCRIBE/UNSUBSCRIBE com os curingas + e #, PINGREQ e DISCONNECT.
+Simplificações: tudo é entregue aos assinantes em QoS 0, sem sessões persistentes e sem
+derrubar quem passa do keep alive. Um assinante que não dá conta (buffer de saída acima
+de LIMITE_BUFFER_ASSINANTE) perde mensagens, que contam em "descartadas".
+
+Uso: python broker_mqtt.py [porta]
+"""
+import asyncio
+import struct
+import sys
+
+PORTA_PADRAO = 1883
+LIMITE_BUFFER_ASSINANTE = 1 << 20
+
+CONNECT, CONNACK, PUBLISH, PUBACK = 1, 2, 3, 4
+SUBSCRIBE, SUBACK, UNSUBSCRIBE, UNSUBACK = 8, 9, 10, 11
+PINGREQ, PINGRESP, DISCONNECT = 12, 13, 14
+
+
+def pacote(tipo_e_flags, corpo=b""):
+    tamanho = len(corpo)
+    cabecalho = bytearray([tipo_e_flags])
+    while True:
+        byte, tamanho = tamanho % 128, tamanho // 128
+        cabecalho.append(byte | (0x80 if tamanho else 0))
+        if not tamanho:
+            return bytes(cabecalho) + corpo
+
+
+def texto(dados):
+    return struct.pack("!H", len(dados)) + dados
+
+
+def ler_texto(corpo, posicao):
+    tamanho, = struct.unpack_from("!H", corpo, posicao)
+    return corpo[posicao + 2:posicao + 2 + tamanho], posicao + 2 + tamanho
+
+
+def casa(filtro, topico):
+    """ Filtro de assinatura (com + e #) contra um tópico. """
+    partes_filtro = filtro.split(b"/")
+    partes_topico = topico.split(b"/")
+    for i, parte in enumerate(partes_filtro):
+        if parte == b"#":
+            return True
+        if i >= len(partes_topico) or (parte != b"+" and parte != partes_topico[i]):
+            return False
+    return len(partes_filtro) == len(partes_topico)
+
+
+class Broker:
+    def __init__(self):
+        self.clientes = {}        # id do cliente -> Cliente
+        self.retidas = {}         # tópico -> payload
+        self.publicacoes = 0
+        self.entregas = 0
+        self.descartadas = 0
+
+    def publicar(self, topico, payload, reter):
+        self.publicacoes += 1
+        if reter:
+            if payload:
+                self.retidas[topico] = payload
+            else:
+                self.retidas.pop(topico, None)
+        mensagem = None
+        for cliente in self.clientes.values():
+            if any(casa(filtro, topico) for filtro in cliente.assinaturas):
+                mensagem = mensagem or pacote(PUBLISH << 4, texto(topico) + payload)
+                cliente.enviar(mensagem, descartavel=True)
+
+
+class Cliente:
+    def __init__(self, broker, leitor, escritor):
+        self.broker = broker
+        self.leitor = leitor
+        self.escritor = escritor
+        self.id = None
+        self.assinaturas = set()
+        self.testamento = None    # (tópico, payload, reter)
+
+    def enviar(self, dados, descartavel=False):
+        if descartavel:
+            if self.escritor.transport.get_write_buffer_size() > LIMITE_BUFFER_ASSINANTE:
+                self.broker.descartadas += 1
+                return
+            self.broker.entregas += 1
+        self.escritor.write(dados)
+
+    async def ler_pacote(self):
+        cabecalho = await self.leitor.readexactly(1)
+        tamanho, multiplicador = 0, 1
+        while True:
+            byte = (await self.leitor.readexactly(1))[0]
+            tamanho += (byte & 0x7F) * multiplicador
+            multiplicador *= 128
+            if not byte & 0x80:
+                break
+        return cabecalho[0], await self.leitor.readexactly(tamanho)
+
+    def tratar_connect(self, corpo):
+        _, posicao = ler_texto(corpo, 0)         # "MQTT"
+        flags = corpo[posicao + 1]
+        posicao += 4                              # nível, flags, keep alive
+        self.id, posicao = ler_texto(corpo, posicao)
+        if flags & 0x04:
+            topico, posicao = ler_texto(corpo, posicao)
+            payload, posicao = ler_texto(corpo, posicao)
+            self.testamento = (topico, payload, bool(flags & 0x20))
+        anterior = self.broker.clientes.get(self.id)
+        if anterior is not None:
+            anterior.escritor.close()             # Mesmo id: a conexão antiga cai
+        self.broker.clientes[self.id] = self
+        self.enviar(pacote(CONNACK << 4, b"\x00\x00"))
+
+    def tratar_publish(self, flags, corpo):
+        topico, posicao = ler_texto(corpo, 0)
+        qos = (flags >> 1) & 3
+        if qos:
+            identificador = corpo[posicao:posicao + 2]
+            posicao += 2
+            self.enviar(pacote(PUBACK << 4, identificador))
+        self.broker.publicar(topico, corpo[posicao:], bool(flags & 1))
+
+    def tratar_subscribe(self, corpo):
+        identificador, posicao = corpo[:2], 2
+        concedidos = bytearray()
+        novos = []
+        while posicao < len(corpo):
+            filtro, posicao = ler_texto(corpo, posicao)
+            posicao += 1                          # QoS pedido: entregamos em 0
+            self.assinaturas.add(filtro)
+            novos.append(filtro)
+            concedidos.append(0)
+        self.enviar(pacote(SUBACK << 4, identificador + bytes(concedidos)))
+        for topico, payload in self.broker.retidas.items():
+            if any(casa(filtro, topico) for filtro in novos):
+                self.enviar(pacote(PUBLISH << 4 | 1, texto(topico) + payload))
+
+    def tratar_unsubscribe(self, corpo):
+        identificador, posicao = corpo[:2], 2
+        while posicao < len(corpo):
+            filtro, posicao = ler_texto(corpo, posicao)
+            self.assinaturas.discard(filtro)
+        self.enviar(pacote(UNSUBACK << 4, identificador))
+
+    async def atender(self):
+        encerrou_limpo = False
+        try:
+            tipo, corpo = await self.ler_pacote()
+            if tipo >> 4 != CONNECT:
+                return
+            self.tratar_connect(corpo)
+            while True:
+                tipo, corpo = await self.ler_pacote()
+                if tipo >> 4 == PUBLISH:
+                    self.tratar_publish(tipo & 0x0F, corpo)
+                elif tipo >> 4 == SUBSCRIBE:
+                    self.tratar_subscribe(corpo)
+                elif tipo >> 4 == UNSUBSCRIBE:
+                    self.tratar_unsubscribe(corpo)
+                elif tipo >> 4 == PINGREQ:
+                    self.enviar(pacote(PINGRESP << 4))
+                elif tipo >> 4 == DISCONNECT:
+                    encerrou_limpo = True
+                    return
+                if self.escritor.transport.get_write_buffer_size() > LIMITE_BUFFER_ASSINANTE:
+                    await self.escritor.drain()
+        except (asyncio.IncompleteReadError, ConnectionError, struct.error, IndexError):
+            pass
+        finally:
+            if self.id is not None and self.broker.clientes.get(self.id) is self:
+                del self.broker.clientes[self.id]
+                if self.testamento and not encerrou_limpo:
+                    self.broker.publicar(*self.testamento)
+            self.escritor.close()
+
+
+async def main(porta):
+    broker = Broker()
+    servidor = await asyncio.start_server(
+        lambda leitor, escritor: Cliente(broker, leitor, escritor).atender(), "127.0.0.1", porta)
+    print(f"broker MQTT na porta {porta}", flush=True)
+    async with servidor:
+        await servidor.serve_forever()
+
+
+if __name__ == "__main__":
+    try:
+        asyncio.run(main(int(sys.argv[1]) if len(sys.argv) > 1 else PORTA_PADRAO))
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,182 @@
+"""
+Motor de regras sobre o fluxo de amostras do servidor.py (alertas e sinais derivados).
+
+Cada regra é uma linha "nome: expressão" do arquivo de regras (regras.txt), no formato
+    <operando> <comparação> <número> [por <N>s]
+onde <operando> é um campo das amostras (TEMP, UMI, BTN, VRX, ...) ou taxa(<campo>), a
+variação por segundo entre duas amostras seguidas do campo na mesma placa. Exemplos:
+    temperatura_alta: TEMP > 30 por 60s
+    umidade_subindo:  taxa(UMI) > 0.5
+    botao_segurado:   BTN == 1 por 2s
+
+A expressão é compilada uma vez em um operador incremental: cada regra guarda, por placa,
+um estado de tamanho fixo (EstadoRegra), nunca uma janela de amostras, e cada amostra só
+passa pelas regras dos campos que ela traz. As regras disparam na borda: "ativado" quando
+a condição passa a valer (e continua valendo pelo tempo pedido em "por") e "normalizado"
+quando deixa de valer. Os prazos de "por" ficam em um heap e são conferidos por
+vencer_prazos(), chamada periodicamente, de modo que o alerta sai na hora certa mesmo
+que a placa só envie a próxima amostra bem depois. Quando a placa sai (esquecer()), o
+estado dela é descartado e os alertas ativos são normalizados.
+
+Só campos numéricos (CAMPOS_INTEIROS e CAMPOS_REAIS do telemetria.py, menos o SEQ) valem;
+um campo desconhecido chega como texto e é recusado ao carregar as regras.
+"""
+import heapq
+import itertools
+import operator
+import re
+
+from telemetria import CAMPOS_INTEIROS, CAMPOS_REAIS
+
+# O SEQ do joystick é consumido pelo servidor antes das regras
+CAMPOS_NUMERICOS = (CAMPOS_INTEIROS | CAMPOS_REAIS) - {'SEQ'}
+
+COMPARACOES = {
+    '>': operator.gt, '>=': operator.ge,
+    '<': operator.lt, '<=': operator.le,
+    '==': operator.eq, '!=': operator.ne,
+}
+
+_EXPRESSAO = re.compile(
+    r"^\s*(?:taxa\(\s*(?P<campo_taxa>\w+)\s*\)|(?P<campo>\w+))"
+    r"\s*(?P<comparacao>>=|<=|==|!=|>|<)"
+    r"\s*(?P<limite>[-+]?\d+(?:\.\d+)?)"
+    r"(?:\s+por\s+(?P<duracao>\d+(?:\.\d+)?)\s*s)?\s*$")
+
+
+class EstadoRegra:
+    """ Estado de uma regra para uma placa. """
+    __slots__ = ('desde', 'ativa', 'ultimo_operando', 'valor_anterior', 't_anterior', 'geracao')
+
+    def __init__(self):
+        self.desde = None              # Instante em que a condição passou a valer
+        self.ativa = False             # "ativado" já emitido
+        self.ultimo_operando = None
+        self.valor_anterior = None     # Só para taxa()
+        self.t_anterior = None
+        self.geracao = 0               # Muda quando a condição cai: invalida o prazo pendente
+
+
+class Regra:
+    def __init__(self, nome, expressao):
+        m = _EXPRESSAO.match(expressao)
+        if not m:
+            raise ValueError(f"expressão inválida: {expressao!r}")
+        self.nome = nome
+        self.expressao = " ".join(expressao.split())
+        self.taxa = m['campo_taxa'] is not None
+        self.campo = m['campo_taxa'] or m['campo']
+        if self.campo not in CAMPOS_NUMERICOS:
+            raise ValueError(f"campo {self.campo!r} não é numérico "
+                             f"(use um de {', '.join(sorted(CAMPOS_NUMERICOS))})")
+        self.comparar = COMPARACOES[m['comparacao']]
+        self.limite = float(m['limite'])
+        self.duracao = float(m['duracao'] or 0)
+        self.estados = {}              # Placa -> EstadoRegra
+
+    def operando(self, estado, valor, t):
+        """ Valor comparado com o limite; None enquanto não há como calculá-lo. """
+        if not self.taxa:
+            return valor
+        anterior, t_anterior = estado.valor_anterior, estado.t_anterior
+        estado.valor_anterior, estado.t_anterior = valor, t
+        if anterior is None or t <= t_anterior:
+            return None
+        return (valor - anterior) / (t - t_anterior)
+
+    def evento(self, dispositivo, situacao, valor, t, motivo=None):
+        evento = {'evento': 'regra', 'regra': self.nome, 'expressao': self.expressao,
+                  'DISPOSITIVO': dispositivo, 'estado': situacao,
+                  'valor': round(valor, 3), 't': round(t, 3)}
+        if motivo:
+            evento['motivo'] = motivo
+        return evento
+
+
+class MotorRegras:
+    def __init__(self, regras):
+        self.regras = regras
+        self.regras_por_campo = {}
+        for regra in regras:
+            self.regras_por_campo.setdefault(regra.campo, []).append(regra)
+        self.prazos = []               # Heap de (instante, desempate, regra, placa, estado, geração)
+        self._desempate = itertools.count()
+
+    def avaliar(self, dispositivo, campos, t):
+        """ Passa uma amostra pelas regras dos seus campos; retorna os eventos gerados. """
+        eventos = []
+        for campo, valor in campos.items():
+            for regra in self.regras_por_campo.get(campo, ()):
+                self._avaliar_regra(regra, dispositivo, valor, t, eventos)
+        return eventos
+
+    def _avaliar_regra(self, regra, dispositivo, valor, t, eventos):
+        estado = regra.estados.get(dispositivo)
+        if estado is None:
+            estado = regra.estados[dispositivo] = EstadoRegra()
+        operando = regra.operando(estado, valor, t)
+        if operando is None:
+            return
+        estado.ultimo_operando = operando
+
+        if regra.comparar(operando, regra.limite):
+            if estado.desde is not None:
+                return                 # Continua valendo: nada muda
+            estado.desde = t
+            if regra.duracao == 0:
+                estado.ativa = True
+                eventos.append(regra.evento(dispositivo, 'ativado', operando, t))
+            else:
+                heapq.heappush(self.prazos, (t + regra.duracao, next(self._desempate),
+                                             regra, dispositivo, estado, estado.geracao))
+        elif estado.desde is not None:
+            estado.desde = None
+            estado.geracao += 1
+            if estado.ativa:
+                estado.ativa = False
+                eventos.append(regra.evento(dispositivo, 'normalizado', operando, t))
+
+    def vencer_prazos(self, t):
+        """ Ativa as regras com "por" cuja condição valeu até 't' sem interrupção. """
+        eventos = []
+        while self.prazos and self.prazos[0][0] <= t:
+            instante, _, regra, dispositivo, estado, geracao = heapq.heappop(self.prazos)
+            if regra.estados.get(dispositivo) is not estado or estado.geracao != geracao or estado.ativa:
+                continue               # A condição caiu (ou a placa saiu) nesse meio-tempo
+            estado.ativa = True
+            eventos.append(regra.evento(dispositivo, 'ativado', estado.ultimo_operando, instante))
+        return eventos
+
+    def esquecer(self, dispositivo, t):
+        """ Descarta o estado da placa em todas as regras (ela desconectou); os alertas que
+        estavam ativos saem como "normalizado". Os prazos pendentes dela ficam sem efeito. """
+        eventos = []
+        for regra in self.regras:
+            estado = regra.estados.pop(dispositivo, None)
+            if estado is not None and estado.ativa:
+                eventos.append(regra.evento(dispositivo, 'normalizado', estado.ultimo_operando, t,
+                                            motivo='placa desconectada'))
+        return eventos
+
+
+def carregar_regras(caminho):
+    """ Lê o arquivo de regras ("nome: expressão" por linha, '#' para comentários).
+    Arquivo inexistente = nenhuma regra. """
+    regras = []
+    try:
+        with open(caminho, encoding='utf-8') as f:
+            linhas = f.readlines()
+    except FileNotFoundError:
+        return regras
+    for numero, linha in enumerate(linhas, 1):
+        linha = linha.split('#', 1)[0].strip()
+        if not linha:
+            continue
+        nome, separador, expressao = linha.partition(':')
+        if not separador:
+            raise ValueError(f"{caminho}:{numero}: falta 'nome:' antes da expressão")
+        try:
+            regras.append(Regra(nome.strip(), expressao))
+        except ValueError as e:
+            raise ValueError(f"{caminho}:{numero}: {e}") from None
+    return regras
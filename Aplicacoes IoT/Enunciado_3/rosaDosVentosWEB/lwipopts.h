@@ -16,6 +16,13 @@
 #define LWIP_DNS                    1
 #define LWIP_NETIF_HOSTNAME         1
 #define LWIP_NETIF_STATUS_CALLBACK  1
+#define LWIP_NETIF_LINK_CALLBACK    1
+
+// Cliente MQTT (TRANSPORTE_MQTT): temporizador próprio e buffer para o lote do joystick
+// mais as publicações QoS 1 em andamento
+#define MEMP_NUM_SYS_TIMEOUT        (LWIP_NUM_SYS_TIMEOUT_INTERNAL + 1)
+#define MQTT_OUTPUT_RINGBUF_SIZE    512
+#define MQTT_REQ_MAX_IN_FLIGHT      4
 #define LWIP_DEBUG                  1
 #define TCP_DEBUG                   LWIP_DBG_OFF
 #define ETHARP_DEBUG                LWIP_DBG_OFF
@@ -1,16 +1,25 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
 
 #include "pico/stdlib.h"
 #include "pico/cyw43_arch.h"
 #include "hardware/adc.h"
 #include "hardware/gpio.h"
 #include "pico/time.h"
+#include "pico/flash.h"
+#include "pico/rand.h"
+#include "pico/unique_id.h"
+#include "hardware/flash.h"
 
 #include "lwip/pbuf.h"
 #include "lwip/tcp.h"
+#include "lwip/udp.h"
 #include "lwip/ip_addr.h"
+#include "lwip/netif.h"
+#include "lwip/apps/mqtt.h"
 
 // =================================================================================
 // ==== CONFIGURAÇÕES GERAIS ====
@@ -20,6 +29,57 @@
 #define IP_SERVIDOR "34.127.94.4" // IP do seu servidor na nuvem
 #define PORTA_TCP 8082
 
+// Transporte do joystick: 1 = UDP com número de sequência (o valor mais recente vence,
+// sem bloqueio por retransmissão); 0 = tudo na mesma conexão TCP, como antes.
+#ifndef TRANSPORTE_JOYSTICK_UDP
+#define TRANSPORTE_JOYSTICK_UDP 1
+#endif
+#define PORTA_UDP_JOYSTICK 8084
+#define INTERVALO_MINIMO_JOYSTICK_MS 100  // Intervalo mínimo entre datagramas do joystick
+#define LIMIAR_MUDANCA_ADC 64             // Variação mínima (contagens do ADC) para enviar nova posição
+#define INTERVALO_MAXIMO_JOYSTICK_MS 1000 // Mesmo parado, reenvia a posição a cada 1s
+
+// Transporte MQTT: 1 = publica em um broker MQTT (cliente MQTT do lwIP) em vez de usar a
+// conexão TCP e o UDP do servidor.py; 0 = protocolos próprios, como antes.
+#ifndef TRANSPORTE_MQTT
+#define TRANSPORTE_MQTT 0
+#endif
+#define IP_BROKER_MQTT "192.168.0.10"           // Broker na rede local (ex.: mosquitto)
+#define PORTA_BROKER_MQTT 1883
+#define PREFIXO_TOPICOS_MQTT "rosadosventos"    // Tópicos: <prefixo>/<id da placa>/<sensor>
+#define KEEP_ALIVE_MQTT_S 30
+#define JANELA_QOS1_MQTT 2                      // Publicações QoS 1 aguardando PUBACK ao mesmo tempo
+#define INTERVALO_POSICAO_JOYSTICK_MQTT_MS 20   // Uma posição do joystick no lote a cada 20ms, no máximo
+#define LOTE_JOYSTICK_MQTT 5                    // Posições por publicação do joystick
+
+// Conexão Wi-Fi
+#define TIMEOUT_RECONEXAO_RAPIDA_MS 3000  // Associação direta ao BSSID guardado na flash
+#define TIMEOUT_CONEXAO_WIFI_MS 20000     // Conexão completa (varredura + associação)
+#define PRAZO_DHCP_MS 2000                // Depois disso, aplica o IP guardado da última concessão
+#define INTERVALO_RECONEXAO_TCP_MS 3000   // Espera média entre tentativas de conexão com o servidor
+#define ATRASO_MAXIMO_PRIMEIRA_TCP_MS 2000 // Primeira tentativa após o Wi-Fi subir: atraso sorteado até isto
+#define ESPERA_MAXIMA_SERVIDOR_MS 60000    // Teto para o RETRY= pedido pelo servidor
+#define OFFSET_CACHE_REDE (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE) // Último setor da flash
+#define MAGICO_CACHE_REDE 0x57494649u     // "WIFI"
+
+// Agendador de transmissão: as amostras são acumuladas e enviadas em rajadas,
+// e o rádio fica em modo de economia (CYW43_AGGRESSIVE_PM) entre uma rajada e outra.
+// A política (latência e tamanho do lote) pode ser trocada na compilação; o ciclo de
+// trabalho do rádio de cada uma é comparado em simulacao/ (sim_radio).
+#ifndef LATENCIA_MAXIMA_MS
+#define LATENCIA_MAXIMA_MS 10000     // Tempo máximo que uma amostra pode esperar no lote
+#endif
+#ifndef TAMANHO_LOTE
+#define TAMANHO_LOTE 1024            // Bytes acumulados antes de forçar o envio
+#endif
+#define PERIODO_ESTATISTICAS_MS 60000 // Intervalo entre os relatórios de uso do rádio e dos sensores
+
+// Períodos de amostragem de cada sensor (ver REGISTRO DE SENSORES)
+#define PERIODO_JOYSTICK_MS 10       // 100 Hz
+#define PERIODO_BOTOES_MS 50         // Verificação dos botões (uma mudança gera envio imediato)
+#define PERIODO_AMOSTRAGEM_MS 2000   // O DHT11 não deve ser lido mais de uma vez a cada 2s
+#define ESPERA_MAXIMA_LOOP_MS 10     // O loop principal nunca dorme mais que isso
+
 // =================================================================================
 // ==== DEFINIÇÃO DE PINOS ====
 // =================================================================================
@@ -27,6 +87,7 @@
 #define LED_WIFI_CONECTADO 11
 #define LED_WIFI_ERRO 12
 #define LED_ESTADO 13
+#define DURACAO_PISCA_LED_MS 50   // LED_ESTADO aceso a cada confirmação de envio
 
 // Periféricos de entrada
 #define PINO_JOY_VRX 27      // Eixo X do Joystick (ADC 1)
@@ -41,6 +102,7 @@
 // =================================================================================
 
 #define TIMEOUT_DHT 200
+#define DHT_DURACAO_SINAL_INICIO_MS 20 // Nível baixo do sinal de início (mínimo de 18ms)
 
 // Estrutura para guardar os resultados da leitura do DHT
 typedef struct {
@@ -64,15 +126,20 @@ static void dht_inicializar(uint pino_gpio) {
     gpio_init(pino_gpio);
 }
 
-// Função para ler os dados do sensor (bloqueante)
-static resultado_dht_t dht_ler_bloqueante(uint pino_gpio) {
-    uint8_t dados[5] = {0, 0, 0, 0, 0};
-    resultado_dht_t resultado = {0.0f, 0.0f, false};
+// A leitura é feita em duas etapas para não parar o programa durante o sinal de início:
+// dht_iniciar_sinal() só coloca a linha em nível baixo; dht_concluir_leitura(), chamada
+// DHT_DURACAO_SINAL_INICIO_MS depois, encerra o sinal e lê os 40 bits (~5ms, bloqueante).
 
-    // 1. Sinal de início enviado pelo Pico
+// 1. Sinal de início enviado pelo Pico
+static void dht_iniciar_sinal(uint pino_gpio) {
     gpio_set_dir(pino_gpio, GPIO_OUT);
     gpio_put(pino_gpio, 0);
-    sleep_ms(20); // Espera pelo menos 18ms
+}
+
+static resultado_dht_t dht_concluir_leitura(uint pino_gpio) {
+    uint8_t dados[5] = {0, 0, 0, 0, 0};
+    resultado_dht_t resultado = {0.0f, 0.0f, false};
+
     gpio_put(pino_gpio, 1);
     sleep_us(40);
     gpio_set_dir(pino_gpio, GPIO_IN);
@@ -115,45 +182,69 @@ typedef struct CLIENTE_TCP_T_ {
     struct tcp_pcb *pcb_tcp;
     ip_addr_t endereco_remoto;
     bool conectado;
+    volatile uint32_t bytes_aguardando_ack; // Bytes escritos que o servidor ainda não confirmou
+    uint32_t espera_pedida_ms;              // "RETRY=<ms>" do servidor ao recusar a conexão (0 = nenhum)
+    volatile bool led_aceso;                // LED_ESTADO aceso pelo callback de envio...
+    volatile uint32_t led_aceso_em_ms;      // ... neste instante; o loop principal o apaga
 } cliente_tcp_t;
 
 // Protótipos das funções de callback TCP
 err_t callback_cliente_tcp_conectado(void *arg, struct tcp_pcb *tpcb, err_t erro);
 void callback_cliente_tcp_erro(void *arg, err_t erro);
 err_t callback_cliente_tcp_enviado(void *arg, struct tcp_pcb *tpcb, u16_t tamanho);
+err_t callback_cliente_tcp_recebido(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t erro);
 void cliente_tcp_fechar_conexao(cliente_tcp_t *estado);
 
 
 // Função para enviar os dados via TCP
-void cliente_tcp_enviar_dados(cliente_tcp_t *estado, const char *mensagem) {
+bool cliente_tcp_enviar_dados(cliente_tcp_t *estado, const char *mensagem) {
+    size_t tamanho = strlen(mensagem);
+    err_t erro_envio = ERR_OK;
+
+    // O callback de erro pode liberar o PCB a qualquer momento: verifica e escreve com a trava
+    cyw43_arch_lwip_begin();
     if (!estado->conectado || estado->pcb_tcp == NULL) {
+        cyw43_arch_lwip_end();
         printf("Não conectado. Impossível enviar dados.\n");
-        return;
+        return false;
     }
-    
-    printf("Enviando: %s", mensagem); // a mensagem já tem \n
-    err_t erro = tcp_write(estado->pcb_tcp, mensagem, strlen(mensagem), TCP_WRITE_FLAG_COPY);
+    err_t erro_escrita = tcp_write(estado->pcb_tcp, mensagem, tamanho, TCP_WRITE_FLAG_COPY);
+    if (erro_escrita == ERR_OK) {
+        estado->bytes_aguardando_ack += tamanho;
+        erro_envio = tcp_output(estado->pcb_tcp);
+    }
+    cyw43_arch_lwip_end();
 
-    if (erro != ERR_OK) {
-        printf("Erro ao escrever para o buffer TCP: %d\n", erro);
-        return;
+    if (erro_escrita != ERR_OK) {
+        printf("Erro ao escrever para o buffer TCP: %d\n", erro_escrita);
+        return false;
     }
-    
-    erro = tcp_output(estado->pcb_tcp);
-    if (erro != ERR_OK) {
-        printf("Erro ao enviar dados TCP: %d\n", erro);
+    if (erro_envio != ERR_OK) {
+        printf("Erro ao enviar dados TCP: %d\n", erro_envio);
     }
+    return true;
 }
 
-// Função para fechar a conexão TCP
+// Função para fechar a conexão TCP.
+// As funções do cliente TCP são chamadas do loop principal e também dos callbacks do
+// lwIP (que rodam em interrupção no modo threadsafe_background): por isso tomam a trava
+// do lwIP com cyw43_arch_lwip_begin/end, que pode ser tomada de novo dentro de um callback.
 void cliente_tcp_fechar_conexao(cliente_tcp_t *estado) {
-    if (estado->pcb_tcp != NULL) {
+    cyw43_arch_lwip_begin();
+    bool havia_conexao = estado->pcb_tcp != NULL;
+    if (havia_conexao) {
         tcp_arg(estado->pcb_tcp, NULL);
         tcp_sent(estado->pcb_tcp, NULL);
+        tcp_recv(estado->pcb_tcp, NULL);
         tcp_err(estado->pcb_tcp, NULL);
         tcp_close(estado->pcb_tcp);
         estado->pcb_tcp = NULL;
         estado->conectado = false;
+        estado->bytes_aguardando_ack = 0;
+    }
+    cyw43_arch_lwip_end();
+
+    if (havia_conexao) {
         gpio_put(LED_ESTADO, 0);
         printf("Conexão TCP fechada.\n");
     }
@@ -163,17 +254,72 @@ void cliente_tcp_fechar_conexao(cliente_tcp_t *estado) {
 void callback_cliente_tcp_erro(void *arg, err_t erro) {
     cliente_tcp_t *estado = (cliente_tcp_t*)arg;
     printf("Erro TCP: %d. Fechando conexão.\n", erro);
-    cliente_tcp_fechar_conexao(estado);
+    // O lwIP já liberou o PCB antes de chamar este callback: apenas esquece a referência
+    estado->pcb_tcp = NULL;
+    estado->conectado = false;
+    estado->bytes_aguardando_ack = 0;
+    gpio_put(LED_ESTADO, 0);
 }
 
 // Callback de dados enviados
 err_t callback_cliente_tcp_enviado(void *arg, struct tcp_pcb *pcb_tcp, u16_t tamanho) {
-    gpio_put(LED_ESTADO, 1); // Pisca o LED para indicar envio
-    sleep_ms(50);
-    gpio_put(LED_ESTADO, 0);
+    cliente_tcp_t *estado = (cliente_tcp_t*)arg;
+    estado->bytes_aguardando_ack = (tamanho >= estado->bytes_aguardando_ack) ? 0 : estado->bytes_aguardando_ack - tamanho;
+
+    // Acende o LED para indicar envio; quem apaga é o loop principal (cliente_tcp_apagar_led),
+    // já que este callback roda em interrupção e não pode esperar
+    gpio_put(LED_ESTADO, 1);
+    estado->led_aceso_em_ms = to_ms_since_boot(get_absolute_time());
+    estado->led_aceso = true;
     return ERR_OK;
 }
 
+// Chamada a cada volta do loop principal: apaga o LED de envio DURACAO_PISCA_LED_MS depois
+void cliente_tcp_apagar_led(cliente_tcp_t *estado) {
+    if (estado->led_aceso &&
+        to_ms_since_boot(get_absolute_time()) - estado->led_aceso_em_ms >= DURACAO_PISCA_LED_MS) {
+        estado->led_aceso = false;
+        gpio_put(LED_ESTADO, 0);
+    }
+}
+
+// Callback de dados recebidos. O servidor só escreve nesta conexão para recusá-la, em
+// momentos de muitas conexões simultâneas: "RETRY=<ms>\n" e, em seguida, fecha.
+err_t callback_cliente_tcp_recebido(void *arg, struct tcp_pcb *pcb_tcp, struct pbuf *p, err_t erro) {
+    cliente_tcp_t *estado = (cliente_tcp_t*)arg;
+    if (p == NULL) {
+        printf("Servidor fechou a conexão.\n");
+        cliente_tcp_fechar_conexao(estado);
+        return ERR_OK;
+    }
+
+    char texto[32];
+    uint16_t tamanho = pbuf_copy_partial(p, texto, sizeof(texto) - 1, 0);
+    texto[tamanho] = '\0';
+    if (strncmp(texto, "RETRY=", 6) == 0) {
+        uint32_t espera = strtoul(texto + 6, NULL, 10);
+        estado->espera_pedida_ms = espera > ESPERA_MAXIMA_SERVIDOR_MS ? ESPERA_MAXIMA_SERVIDOR_MS : espera;
+        printf("Servidor ocupado: nova tentativa em ~%lu ms\n", (unsigned long)estado->espera_pedida_ms);
+    }
+    tcp_recved(pcb_tcp, p->tot_len);
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+// Espera até a próxima tentativa de conexão (com o servidor ou com o broker MQTT): a
+// pedida pelo servidor em *espera_pedida_ms (se maior que o intervalo normal; consumida
+// aqui), sorteada entre 50% e 150% dela. Sem o sorteio, as placas de um mesmo local,
+// derrubadas juntas por uma queda do Wi-Fi ou pelo servidor que reiniciou, voltariam
+// todas no mesmo instante.
+static uint32_t sortear_espera_reconexao(uint32_t *espera_pedida_ms) {
+    uint32_t base = INTERVALO_RECONEXAO_TCP_MS;
+    if (espera_pedida_ms != NULL) {
+        if (*espera_pedida_ms > base) base = *espera_pedida_ms;
+        *espera_pedida_ms = 0;
+    }
+    return base / 2 + get_rand_32() % base;
+}
+
 // Callback de conexão estabelecida
 err_t callback_cliente_tcp_conectado(void *arg, struct tcp_pcb *pcb_tcp, err_t erro) {
     cliente_tcp_t *estado = (cliente_tcp_t*)arg;
@@ -187,6 +333,7 @@ err_t callback_cliente_tcp_conectado(void *arg, struct tcp_pcb *pcb_tcp, err_t e
     
     // Configura os outros callbacks
     tcp_sent(pcb_tcp, callback_cliente_tcp_enviado);
+    tcp_recv(pcb_tcp, callback_cliente_tcp_recebido);
     
     // Envia uma mensagem inicial
     cliente_tcp_enviar_dados(estado, "Olá do RP2040!\n");
@@ -197,8 +344,10 @@ err_t callback_cliente_tcp_conectado(void *arg, struct tcp_pcb *pcb_tcp, err_t e
 bool cliente_tcp_conectar(cliente_tcp_t *estado) {
     printf("Iniciando conexão com %s:%d\n", ip4addr_ntoa(&estado->endereco_remoto), PORTA_TCP);
     
+    cyw43_arch_lwip_begin();
     estado->pcb_tcp = tcp_new_ip_type(IP_GET_TYPE(&estado->endereco_remoto));
     if (estado->pcb_tcp == NULL) {
+        cyw43_arch_lwip_end();
         printf("Erro ao criar PCB.\n");
         return false;
     }
@@ -207,10 +356,131 @@ bool cliente_tcp_conectar(cliente_tcp_t *estado) {
     tcp_err(estado->pcb_tcp, callback_cliente_tcp_erro);
 
     err_t erro = tcp_connect(estado->pcb_tcp, &estado->endereco_remoto, PORTA_TCP, callback_cliente_tcp_conectado);
+    cyw43_arch_lwip_end();
     return erro == ERR_OK;
 }
 
 
+// =================================================================================
+// ==== AGENDADOR DE TRANSMISSÃO EM RAJADAS ====
+// =================================================================================
+// Em vez de um segmento TCP a cada leitura, as linhas são acumuladas em um lote e
+// enviadas juntas quando: (a) a amostra mais antiga atinge LATENCIA_MAXIMA_MS,
+// (b) o lote enche, ou (c) chega uma amostra urgente (mudança em algum botão).
+// Entre as rajadas o CYW43 fica em CYW43_AGGRESSIVE_PM; durante a rajada, até o
+// último ACK, fica em CYW43_PERFORMANCE_PM. O tempo em modo de desempenho é
+// contabilizado como "rádio ativo".
+
+typedef struct {
+    char dados[TAMANHO_LOTE];
+    size_t tamanho;
+    uint32_t amostras;               // Amostras no lote atual
+    uint32_t inicio_lote_ms;         // Momento em que a amostra mais antiga entrou no lote
+
+    // Estatísticas
+    bool radio_ativo;
+    uint32_t inicio_radio_ativo_ms;
+    uint64_t tempo_radio_ativo_ms;
+    uint32_t inicio_estatisticas_ms;
+    uint32_t ultimo_relatorio_ms;
+    uint32_t rajadas;
+    uint32_t amostras_enviadas;
+    uint32_t bytes_enviados;
+} agendador_tx_t;
+
+static uint32_t agora_ms() {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+static void radio_modo_rajada(agendador_tx_t *agendador) {
+    if (agendador->radio_ativo) return;
+    cyw43_wifi_pm(&cyw43_state, CYW43_PERFORMANCE_PM);
+    agendador->radio_ativo = true;
+    agendador->inicio_radio_ativo_ms = agora_ms();
+}
+
+static void radio_modo_economia(agendador_tx_t *agendador) {
+    if (!agendador->radio_ativo) return;
+    cyw43_wifi_pm(&cyw43_state, CYW43_AGGRESSIVE_PM);
+    agendador->radio_ativo = false;
+    agendador->tempo_radio_ativo_ms += agora_ms() - agendador->inicio_radio_ativo_ms;
+}
+
+void agendador_inicializar(agendador_tx_t *agendador) {
+    memset(agendador, 0, sizeof(*agendador));
+    agendador->inicio_estatisticas_ms = agora_ms();
+    agendador->ultimo_relatorio_ms = agendador->inicio_estatisticas_ms;
+    cyw43_wifi_pm(&cyw43_state, CYW43_AGGRESSIVE_PM);
+}
+
+// Envia todo o lote acumulado em uma única rajada
+void agendador_descarregar(agendador_tx_t *agendador, cliente_tcp_t *estado_tcp) {
+    if (agendador->tamanho == 0) return;
+
+    radio_modo_rajada(agendador);
+    if (!cliente_tcp_enviar_dados(estado_tcp, agendador->dados)) {
+        return; // Mantém o lote para a próxima tentativa
+    }
+    agendador->rajadas++;
+    agendador->amostras_enviadas += agendador->amostras;
+    agendador->bytes_enviados += agendador->tamanho;
+    agendador->tamanho = 0;
+    agendador->amostras = 0;
+    agendador->dados[0] = '\0';
+}
+
+// Acrescenta uma linha ao lote; amostras urgentes descarregam o lote imediatamente
+void agendador_adicionar_amostra(agendador_tx_t *agendador, cliente_tcp_t *estado_tcp, const char *linha, bool urgente) {
+    size_t tamanho_linha = strlen(linha);
+    if (agendador->tamanho + tamanho_linha >= sizeof(agendador->dados)) {
+        agendador_descarregar(agendador, estado_tcp);
+        if (agendador->tamanho + tamanho_linha >= sizeof(agendador->dados)) {
+            // Envio falhou e o lote está cheio: descarta as amostras antigas (vale a mais recente)
+            printf("Lote cheio sem conexão. Descartando %lu amostras.\n", (unsigned long)agendador->amostras);
+            agendador->tamanho = 0;
+            agendador->amostras = 0;
+        }
+    }
+
+    if (agendador->amostras == 0) {
+        agendador->inicio_lote_ms = agora_ms();
+    }
+    memcpy(agendador->dados + agendador->tamanho, linha, tamanho_linha + 1);
+    agendador->tamanho += tamanho_linha;
+    agendador->amostras++;
+
+    if (urgente) {
+        agendador_descarregar(agendador, estado_tcp);
+    }
+}
+
+// Chamado a cada volta do loop principal: verifica prazo do lote, fim da rajada e relatório
+void agendador_processar(agendador_tx_t *agendador, cliente_tcp_t *estado_tcp) {
+    uint32_t agora = agora_ms();
+
+    if (agendador->amostras > 0 && agora - agendador->inicio_lote_ms >= LATENCIA_MAXIMA_MS) {
+        agendador_descarregar(agendador, estado_tcp);
+    }
+
+    // Rajada concluída quando tudo foi confirmado (ou a conexão caiu)
+    if (agendador->radio_ativo && estado_tcp->bytes_aguardando_ack == 0) {
+        radio_modo_economia(agendador);
+    }
+
+    if (agora - agendador->ultimo_relatorio_ms >= PERIODO_ESTATISTICAS_MS) {
+        agendador->ultimo_relatorio_ms = agora;
+        uint64_t tempo_ativo = agendador->tempo_radio_ativo_ms;
+        if (agendador->radio_ativo) tempo_ativo += agora - agendador->inicio_radio_ativo_ms;
+        uint32_t tempo_total = agora - agendador->inicio_estatisticas_ms;
+        printf("[TX] rajadas=%lu amostras=%lu bytes/amostra=%.1f amostras/rajada=%.1f radio ativo=%.2f%%\n",
+               (unsigned long)agendador->rajadas, (unsigned long)agendador->amostras_enviadas,
+               agendador->amostras_enviadas ? (float)agendador->bytes_enviados / agendador->amostras_enviadas : 0.0f,
+               agendador->rajadas ? (float)agendador->amostras_enviadas / agendador->rajadas : 0.0f,
+               tempo_total ? 100.0f * (float)tempo_ativo / (float)tempo_total : 0.0f);
+    }
+}
+
+
 // =================================================================================
 // ==== FUNÇÕES DE INICIALIZAÇÃO DE HARDWARE ====
 // =================================================================================
@@ -226,52 +496,924 @@ void inicializar_leds() {
     gpio_put(LED_ESTADO, 0);
 }
 
-void inicializar_perifericos() {
-    // ADC para o Joystick
+uint16_t ler_adc(uint canal) {
+    adc_select_input(canal);
+    return adc_read();
+}
+
+
+// =================================================================================
+// ==== REGISTRO DE SENSORES E AGENDADOR DE LEITURAS ====
+// =================================================================================
+// Cada sensor é uma entrada de g_sensores com seu período, o custo (duração da etapa
+// bloqueante mais longa da leitura) e as funções do driver. A cada volta do loop,
+// sensores_processar() executa as leituras vencidas, primeiro as de menor período, e só
+// começa uma etapa se ela terminar antes do próximo prazo de todo sensor mais rápido:
+// os ~5ms da leitura do DHT11 se encaixam entre duas leituras do joystick em vez de
+// atrasá-las. Para incluir um sensor (ex.: um periférico I2C), basta uma entrada na
+// tabela e um driver que grave em g_leituras; os demais mantêm suas taxas desde que o
+// custo dele seja menor que o menor período da tabela.
+// Taxa alcançada e atraso (jitter) de cada sensor saem no relatório [SENSORES].
+
+// Últimos valores lidos; os sinalizadores dizem ao loop principal o que há de novo
+typedef struct {
+    uint16_t vrx, vry;
+    bool joystick_novo;
+    bool botao_joystick, botao_a, botao_b;
+    float temperatura, umidade;
+    bool amostra_tcp_pendente;   // Há uma linha nova para o servidor (DHT lido ou botão mudou)
+    bool amostra_urgente;        // ... e ela deve sair imediatamente (botão mudou)
+    bool dht_novo;               // Leitura nova do DHT11 (tópico separado no transporte MQTT)
+} leituras_t;
+
+static leituras_t g_leituras;
+
+typedef struct sensor_t_ sensor_t;
+
+// Executa uma etapa da leitura. Retorna 0 se a leitura terminou ou, se ela continua
+// (ex.: o sinal de início do DHT11), em quantos ms a próxima etapa deve ser chamada.
+typedef uint32_t (*sensor_ler_t)(sensor_t *sensor);
+
+struct sensor_t_ {
+    const char *nome;
+    uint32_t periodo_ms;
+    uint32_t custo_us;
+    void (*inicializar)(void);
+    sensor_ler_t ler;
+    // Estado mantido pelo agendador
+    uint8_t etapa;               // Para drivers em várias etapas
+    bool em_andamento;           // Leitura começou e ainda não terminou
+    bool adiado;                 // Vencido, esperando a vez de um sensor mais rápido
+    uint32_t planejado_us;       // Instante nominal da leitura atual
+    uint32_t proxima_etapa_us;
+    uint32_t atraso_atual_us;
+    // Estatísticas da janela atual do relatório
+    uint32_t leituras;
+    uint32_t perdidas;           // Períodos pulados por atraso maior que um período
+    uint64_t soma_atraso_us;
+    uint32_t atraso_maximo_us;
+};
+
+// --- Drivers ---
+static void sensor_joystick_iniciar(void) {
     adc_init();
     adc_gpio_init(PINO_JOY_VRX);
     adc_gpio_init(PINO_JOY_VRY);
+}
+
+static uint32_t sensor_joystick_ler(sensor_t *sensor) {
+    g_leituras.vrx = ler_adc(1); // ADC 1 -> PINO_JOY_VRX
+    g_leituras.vry = ler_adc(0); // ADC 0 -> PINO_JOY_VRY
+    g_leituras.joystick_novo = true;
+    return 0;
+}
 
+static void sensor_botoes_iniciar(void) {
     // Botões com pull-up interno
-    gpio_init(PINO_JOY_BOTAO);
-    gpio_set_dir(PINO_JOY_BOTAO, GPIO_IN);
-    gpio_pull_up(PINO_JOY_BOTAO);
+    const uint pinos[] = {PINO_JOY_BOTAO, PINO_BOTAO_A, PINO_BOTAO_B};
+    for (size_t i = 0; i < 3; i++) {
+        gpio_init(pinos[i]);
+        gpio_set_dir(pinos[i], GPIO_IN);
+        gpio_pull_up(pinos[i]);
+    }
+}
 
-    gpio_init(PINO_BOTAO_A);
-    gpio_set_dir(PINO_BOTAO_A, GPIO_IN);
-    gpio_pull_up(PINO_BOTAO_A);
+static uint32_t sensor_botoes_ler(sensor_t *sensor) {
+    // Lógica invertida por causa do pull-up
+    bool joystick = !gpio_get(PINO_JOY_BOTAO);
+    bool a = !gpio_get(PINO_BOTAO_A);
+    bool b = !gpio_get(PINO_BOTAO_B);
 
-    gpio_init(PINO_BOTAO_B);
-    gpio_set_dir(PINO_BOTAO_B, GPIO_IN);
-    gpio_pull_up(PINO_BOTAO_B);
-    
-    // Sensor DHT
+    // Mudança em qualquer botão é um evento urgente: gera amostra e envio imediatos
+    if (joystick != g_leituras.botao_joystick || a != g_leituras.botao_a || b != g_leituras.botao_b) {
+        g_leituras.amostra_tcp_pendente = true;
+        g_leituras.amostra_urgente = true;
+    }
+    g_leituras.botao_joystick = joystick;
+    g_leituras.botao_a = a;
+    g_leituras.botao_b = b;
+    return 0;
+}
+
+static void sensor_dht_iniciar(void) {
     dht_inicializar(PINO_DHT);
 }
 
-uint16_t ler_adc(uint canal) {
-    adc_select_input(canal);
-    return adc_read();
+static uint32_t sensor_dht_ler(sensor_t *sensor) {
+    if (sensor->etapa == 0) {
+        dht_iniciar_sinal(PINO_DHT);
+        sensor->etapa = 1;
+        return DHT_DURACAO_SINAL_INICIO_MS;
+    }
+    sensor->etapa = 0;
+    resultado_dht_t dados_dht = dht_concluir_leitura(PINO_DHT);
+    if (dados_dht.valido) {
+        g_leituras.temperatura = dados_dht.temperatura_c;
+        g_leituras.umidade = dados_dht.umidade;
+    } else {
+        printf("Falha na leitura do DHT11. Usando valores antigos.\n");
+    }
+    // Uma linha para o servidor a cada leitura do DHT11 (período normal de amostragem)
+    g_leituras.amostra_tcp_pendente = true;
+    g_leituras.dht_novo = true;
+    return 0;
+}
+
+static sensor_t g_sensores[] = {
+    // nome        período (ms)           custo (us)  inicialização            leitura
+    { "joystick", PERIODO_JOYSTICK_MS,    20,         sensor_joystick_iniciar, sensor_joystick_ler },
+    { "botoes",   PERIODO_BOTOES_MS,      10,         sensor_botoes_iniciar,   sensor_botoes_ler },
+    { "dht11",    PERIODO_AMOSTRAGEM_MS,  6000,       sensor_dht_iniciar,      sensor_dht_ler },
+};
+#define NUM_SENSORES (sizeof(g_sensores) / sizeof(g_sensores[0]))
+
+static uint32_t g_inicio_janela_sensores_us;
+
+// Diferença com sinal entre instantes de time_us_32() (correta mesmo após o estouro)
+static inline int32_t diferenca_us(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b);
+}
+
+void sensores_inicializar(void) {
+    uint32_t agora = time_us_32();
+    for (size_t i = 0; i < NUM_SENSORES; i++) {
+        sensor_t *sensor = &g_sensores[i];
+        sensor->inicializar();
+        sensor->planejado_us = agora;
+        sensor->proxima_etapa_us = agora;
+    }
+    g_inicio_janela_sensores_us = agora;
+}
+
+// Uma etapa de 'sensor' pode começar se terminar antes do próximo prazo de todo sensor
+// mais rápido. Atrasado mais de meio período, o sensor não espera mais (sem inanição).
+static bool sensor_cabe_agora(const sensor_t *sensor, uint32_t agora) {
+    if (diferenca_us(agora, sensor->planejado_us) > (int32_t)(sensor->periodo_ms * 500)) return true;
+    for (size_t i = 0; i < NUM_SENSORES; i++) {
+        const sensor_t *outro = &g_sensores[i];
+        if (outro->periodo_ms < sensor->periodo_ms &&
+            diferenca_us(outro->proxima_etapa_us, agora + sensor->custo_us) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void sensor_concluir_leitura(sensor_t *sensor, uint32_t agora) {
+    sensor->em_andamento = false;
+    sensor->leituras++;
+    sensor->soma_atraso_us += sensor->atraso_atual_us;
+    if (sensor->atraso_atual_us > sensor->atraso_maximo_us) sensor->atraso_maximo_us = sensor->atraso_atual_us;
+
+    // Próximo instante nominal; períodos que já passaram inteiros são pulados
+    uint32_t periodo_us = sensor->periodo_ms * 1000;
+    sensor->planejado_us += periodo_us;
+    if (diferenca_us(agora, sensor->planejado_us) >= 0) {
+        uint32_t pulados = (agora - sensor->planejado_us) / periodo_us + 1;
+        sensor->perdidas += pulados;
+        sensor->planejado_us += pulados * periodo_us;
+    }
+    sensor->proxima_etapa_us = sensor->planejado_us;
+}
+
+static void sensores_relatorio(uint32_t agora) {
+    uint32_t janela_us = agora - g_inicio_janela_sensores_us;
+    if (janela_us < PERIODO_ESTATISTICAS_MS * 1000u) return;
+    g_inicio_janela_sensores_us = agora;
+
+    for (size_t i = 0; i < NUM_SENSORES; i++) {
+        sensor_t *sensor = &g_sensores[i];
+        printf("[SENSORES] %-8s %.1f Hz (alvo %.1f Hz) atraso medio=%.2f ms max=%.2f ms perdidas=%lu\n",
+               sensor->nome, sensor->leituras * 1e6f / (float)janela_us, 1000.0f / (float)sensor->periodo_ms,
+               sensor->leituras ? (float)sensor->soma_atraso_us / sensor->leituras / 1000.0f : 0.0f,
+               sensor->atraso_maximo_us / 1000.0f, (unsigned long)sensor->perdidas);
+        sensor->leituras = 0;
+        sensor->perdidas = 0;
+        sensor->soma_atraso_us = 0;
+        sensor->atraso_maximo_us = 0;
+    }
 }
 
-bool conectar_wifi() {
-    printf("Conectando ao Wi-Fi...\n");
+// Executa todas as etapas de leitura vencidas que couberem agora
+void sensores_processar(void) {
+    while (true) {
+        uint32_t agora = time_us_32();
+
+        // Entre os vencidos, o de menor período primeiro
+        sensor_t *escolhido = NULL;
+        for (size_t i = 0; i < NUM_SENSORES; i++) {
+            sensor_t *sensor = &g_sensores[i];
+            if (diferenca_us(agora, sensor->proxima_etapa_us) >= 0 &&
+                (escolhido == NULL || sensor->periodo_ms < escolhido->periodo_ms)) {
+                escolhido = sensor;
+            }
+        }
+        if (escolhido == NULL) break;
+        if (!sensor_cabe_agora(escolhido, agora)) {
+            escolhido->adiado = true;
+            break;
+        }
+        escolhido->adiado = false;
+
+        if (!escolhido->em_andamento) {
+            escolhido->em_andamento = true;
+            escolhido->atraso_atual_us = agora - escolhido->planejado_us;
+        }
+        uint32_t continuar_ms = escolhido->ler(escolhido);
+        if (continuar_ms) {
+            escolhido->proxima_etapa_us = agora + continuar_ms * 1000;
+        } else {
+            sensor_concluir_leitura(escolhido, agora);
+        }
+    }
+    sensores_relatorio(time_us_32());
+}
+
+// Dorme até a próxima etapa de leitura (no máximo ESPERA_MAXIMA_LOOP_MS, já que o loop
+// também cuida da conexão e das rajadas). Sensores adiados esperam um mais rápido, que
+// já entra na conta.
+void sensores_aguardar_proximo(void) {
+    uint32_t agora = time_us_32();
+    int32_t espera = ESPERA_MAXIMA_LOOP_MS * 1000;
+    for (size_t i = 0; i < NUM_SENSORES; i++) {
+        if (g_sensores[i].adiado) continue;
+        int32_t falta = diferenca_us(g_sensores[i].proxima_etapa_us, agora);
+        if (falta < espera) espera = falta;
+    }
+    if (espera > 0) sleep_us(espera);
+}
+
+// =================================================================================
+// ==== CANAL UDP DO JOYSTICK (BAIXA LATÊNCIA) ====
+// =================================================================================
+// A posição do joystick vale apenas pelo valor mais recente: se um datagrama se perde,
+// o próximo o substitui, sem a retransmissão do TCP segurar as amostras seguintes.
+// Cada datagrama leva um número de sequência para o servidor descartar os atrasados:
+//     "SEQ=<n> VRX=<x> VRY=<y>\n"
+// Botões e DHT11 continuam no TCP (confiável), sem os campos VRX/VRY.
+
+#if TRANSPORTE_JOYSTICK_UDP
+typedef struct {
+    struct udp_pcb *pcb_udp;
+    ip_addr_t endereco_remoto;
+    uint32_t sequencia;
+    uint16_t ultimo_x, ultimo_y;
+    uint32_t ultimo_envio_ms;
+} canal_joystick_udp_t;
+
+bool joystick_udp_iniciar(canal_joystick_udp_t *canal, const ip_addr_t *endereco) {
+    memset(canal, 0, sizeof(*canal));
+    canal->endereco_remoto = *endereco;
+    cyw43_arch_lwip_begin();
+    canal->pcb_udp = udp_new();
+    cyw43_arch_lwip_end();
+    if (!canal->pcb_udp) {
+        printf("Erro ao criar socket UDP\n");
+        return false;
+    }
+    return true;
+}
+
+// Recebe cada leitura do sensor do joystick e envia se mudou (no máximo a cada
+// INTERVALO_MINIMO_JOYSTICK_MS) ou, parado, a cada INTERVALO_MAXIMO_JOYSTICK_MS
+void joystick_udp_processar(canal_joystick_udp_t *canal, uint16_t x, uint16_t y) {
+    uint32_t agora = agora_ms();
+    uint32_t desde_envio = agora - canal->ultimo_envio_ms;
+    if (canal->sequencia != 0 && desde_envio < INTERVALO_MINIMO_JOYSTICK_MS) return;
+
+    bool mudou = abs((int)x - (int)canal->ultimo_x) >= LIMIAR_MUDANCA_ADC ||
+                 abs((int)y - (int)canal->ultimo_y) >= LIMIAR_MUDANCA_ADC;
+    if (canal->sequencia != 0 && !mudou && desde_envio < INTERVALO_MAXIMO_JOYSTICK_MS) {
+        return;
+    }
+
+    char mensagem[64];
+    int tamanho = snprintf(mensagem, sizeof(mensagem), "SEQ=%lu VRX=%u VRY=%u\n",
+                           (unsigned long)++canal->sequencia, x, y);
+    // Chamado do loop principal: o lwIP só pode ser usado com a trava (threadsafe_background)
+    cyw43_arch_lwip_begin();
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, tamanho, PBUF_RAM);
+    if (!p) {
+        cyw43_arch_lwip_end();
+        printf("Erro alocando buffer UDP\n");
+        return;
+    }
+    memcpy(p->payload, mensagem, tamanho);
+    err_t erro = udp_sendto(canal->pcb_udp, p, &canal->endereco_remoto, PORTA_UDP_JOYSTICK);
+    pbuf_free(p);
+    cyw43_arch_lwip_end();
+    if (erro != ERR_OK) {
+        printf("Erro enviando datagrama do joystick: %d\n", erro);
+        return;
+    }
+    canal->ultimo_x = x;
+    canal->ultimo_y = y;
+    canal->ultimo_envio_ms = agora;
+}
+#endif
+
+// =================================================================================
+// ==== GERENCIADOR DE CONEXÃO WI-FI (RECONEXÃO RÁPIDA) ====
+// =================================================================================
+// O último BSSID e a última concessão DHCP ficam guardados no último setor da flash.
+// No boot (e após queda do enlace) tenta-se primeiro associar direto ao BSSID guardado,
+// sem varredura, com timeout curto; se falhar, faz a conexão completa. Se o DHCP
+// demorar mais que PRAZO_DHCP_MS, o IP guardado é aplicado enquanto o DHCP continua
+// rodando em segundo plano (quando ele concluir, o endereço é atualizado).
+// Quedas do enlace são percebidas pelos callbacks de status/enlace do lwIP.
+
+typedef struct {
+    uint32_t magico;
+    uint8_t bssid[6];
+    uint8_t reservado[2];
+    uint32_t ip;
+    uint32_t mascara;
+    uint32_t gateway;
+    uint32_t verificacao;       // Soma simples dos campos anteriores
+} cache_rede_t;
+
+typedef enum {
+    WIFI_ASSOCIANDO_RAPIDO,     // Associação ao BSSID guardado (sem varredura)
+    WIFI_ASSOCIANDO_COMPLETO,   // Varredura + associação normal
+    WIFI_AGUARDANDO_IP,         // Associado, aguardando DHCP
+    WIFI_CONECTADO
+} estado_wifi_t;
+
+typedef struct {
+    estado_wifi_t estado;
+    uint32_t inicio_etapa_ms;   // Início da etapa atual (para os timeouts)
+    uint32_t inicio_conexao_ms; // Início da conexão atual (boot ou queda do enlace)
+    cache_rede_t cache;
+    bool cache_valido;
+    bool conexao_rapida;        // A conexão atual foi feita pelo caminho rápido
+    bool usando_ip_guardado;    // IP da flash aplicado enquanto o DHCP não responde
+    bool primeira_conexao;      // Ainda não conectou desde o boot
+    volatile bool mudanca_netif; // Sinalizado pelos callbacks do lwIP
+
+    // Métricas (ms desde o início da conexão atual)
+    uint32_t t_associado_ms;
+    uint32_t t_ip_ms;
+    bool primeira_amostra_pendente;
+} gerenciador_wifi_t;
+
+static gerenciador_wifi_t g_wifi;
+
+static uint32_t cache_rede_verificacao(const cache_rede_t *cache) {
+    const uint8_t *bytes = (const uint8_t *)cache;
+    uint32_t soma = 0;
+    for (size_t i = 0; i < offsetof(cache_rede_t, verificacao); i++) {
+        soma = (soma << 1 | soma >> 31) + bytes[i];
+    }
+    return soma;
+}
+
+static bool cache_rede_ler(cache_rede_t *cache) {
+    memcpy(cache, (const void *)(XIP_BASE + OFFSET_CACHE_REDE), sizeof(*cache));
+    return cache->magico == MAGICO_CACHE_REDE && cache->verificacao == cache_rede_verificacao(cache);
+}
+
+// Executada com o outro núcleo e as interrupções pausadas (flash_safe_execute)
+static void cache_rede_gravar_na_flash(void *param) {
+    static uint8_t pagina[FLASH_PAGE_SIZE];
+    memset(pagina, 0xFF, sizeof(pagina));
+    memcpy(pagina, param, sizeof(cache_rede_t));
+    flash_range_erase(OFFSET_CACHE_REDE, FLASH_SECTOR_SIZE);
+    flash_range_program(OFFSET_CACHE_REDE, pagina, FLASH_PAGE_SIZE);
+}
+
+// Guarda BSSID e concessão atuais; só grava se algo mudou (poupa ciclos de apagamento da flash)
+static void cache_rede_atualizar(gerenciador_wifi_t *wifi) {
+    cache_rede_t novo;
+    memset(&novo, 0, sizeof(novo));
+    novo.magico = MAGICO_CACHE_REDE;
+    if (cyw43_wifi_get_bssid(&cyw43_state, novo.bssid) != 0) return;
+    novo.ip = ip4_addr_get_u32(netif_ip4_addr(netif_default));
+    novo.mascara = ip4_addr_get_u32(netif_ip4_netmask(netif_default));
+    novo.gateway = ip4_addr_get_u32(netif_ip4_gw(netif_default));
+    novo.verificacao = cache_rede_verificacao(&novo);
+
+    if (wifi->cache_valido && memcmp(&novo, &wifi->cache, sizeof(novo)) == 0) return;
+
+    if (flash_safe_execute(cache_rede_gravar_na_flash, &novo, 100) == PICO_OK) {
+        wifi->cache = novo;
+        wifi->cache_valido = true;
+        printf("Parâmetros da rede guardados na flash.\n");
+    } else {
+        printf("Não foi possível gravar os parâmetros da rede na flash.\n");
+    }
+}
+
+// Callback do lwIP: mudança de IP, netif up/down ou enlace up/down
+static void callback_status_netif(struct netif *netif) {
+    g_wifi.mudanca_netif = true;
+}
+
+// Ações pedidas por wifi_transicao() e executadas por wifi_processar()
+#define WIFI_ACAO_RAPIDA_FALHOU      (1u << 0) // Desiste do BSSID guardado (cyw43_wifi_leave)
+#define WIFI_ACAO_COMPLETA_FALHOU    (1u << 1) // Desiste da conexão completa (cyw43_wifi_leave)
+#define WIFI_ACAO_ENLACE_PERDIDO     (1u << 2) // Queda do enlace depois de conectado
+#define WIFI_ACAO_ASSOCIAR           (1u << 3) // Nova associação (rápida se wifi->conexao_rapida)
+#define WIFI_ACAO_USAR_IP_GUARDADO   (1u << 4) // DHCP lento: aplica a concessão guardada na flash
+#define WIFI_ACAO_CONECTADO          (1u << 5) // Enlace com IP
+#define WIFI_ACAO_ENDERECO_MUDOU     (1u << 6) // Novo endereço com o enlace ativo
+
+// Prepara o estado para uma nova associação (o pedido ao CYW43 fica com o adaptador)
+static void wifi_preparar_associacao(gerenciador_wifi_t *wifi, bool tentar_rapido, uint32_t agora) {
+    wifi->inicio_etapa_ms = agora;
+    wifi->usando_ip_guardado = false;
+    wifi->conexao_rapida = tentar_rapido && wifi->cache_valido;
+    wifi->estado = wifi->conexao_rapida ? WIFI_ASSOCIANDO_RAPIDO : WIFI_ASSOCIANDO_COMPLETO;
+}
+
+// Máquina de estados da conexão, sem acesso ao hardware: recebe o status do enlace
+// (cyw43_tcpip_link_status) e o instante atual, atualiza 'wifi' e devolve as ações
+// (WIFI_ACAO_*) que o adaptador deve executar. Testada no computador em simulacao/.
+uint32_t wifi_transicao(gerenciador_wifi_t *wifi, int status, uint32_t agora) {
+    uint32_t tempo_etapa = agora - wifi->inicio_etapa_ms;
+
+    switch (wifi->estado) {
+    case WIFI_ASSOCIANDO_RAPIDO:
+    case WIFI_ASSOCIANDO_COMPLETO:
+        if (status == CYW43_LINK_JOIN || status == CYW43_LINK_NOIP || status == CYW43_LINK_UP) {
+            wifi->t_associado_ms = agora - wifi->inicio_conexao_ms;
+            wifi->estado = WIFI_AGUARDANDO_IP;
+            wifi->inicio_etapa_ms = agora;
+            return wifi_transicao(wifi, status, agora); // Pode já estar com IP
+        }
+        bool falhou = status == CYW43_LINK_FAIL || status == CYW43_LINK_NONET || status == CYW43_LINK_BADAUTH;
+        if (wifi->estado == WIFI_ASSOCIANDO_RAPIDO && (falhou || tempo_etapa > TIMEOUT_RECONEXAO_RAPIDA_MS)) {
+            wifi_preparar_associacao(wifi, false, agora);
+            return WIFI_ACAO_RAPIDA_FALHOU | WIFI_ACAO_ASSOCIAR;
+        } else if (wifi->estado == WIFI_ASSOCIANDO_COMPLETO && (falhou || tempo_etapa > TIMEOUT_CONEXAO_WIFI_MS)) {
+            wifi_preparar_associacao(wifi, false, agora);
+            return WIFI_ACAO_COMPLETA_FALHOU | WIFI_ACAO_ASSOCIAR;
+        }
+        return 0;
+
+    case WIFI_AGUARDANDO_IP:
+        if (status == CYW43_LINK_UP) {
+            wifi->t_ip_ms = agora - wifi->inicio_conexao_ms;
+            wifi->estado = WIFI_CONECTADO;
+            wifi->mudanca_netif = false;
+            wifi->primeira_amostra_pendente = true;
+            return WIFI_ACAO_CONECTADO;
+        }
+        if (status < 0 || status == CYW43_LINK_DOWN) {
+            wifi_preparar_associacao(wifi, wifi->conexao_rapida, agora);
+            return WIFI_ACAO_ASSOCIAR;
+        }
+        if (tempo_etapa > PRAZO_DHCP_MS && wifi->cache_valido && !wifi->usando_ip_guardado) {
+            // DHCP lento: usa a concessão anterior. O DHCP continua e corrige o endereço se mudar.
+            wifi->usando_ip_guardado = true;
+            return WIFI_ACAO_USAR_IP_GUARDADO;
+        }
+        return 0;
+
+    case WIFI_CONECTADO:
+        if (status != CYW43_LINK_UP) {
+            wifi->mudanca_netif = false;
+            wifi->primeira_conexao = false;
+            wifi->inicio_conexao_ms = agora;
+            wifi_preparar_associacao(wifi, true, agora);
+            return WIFI_ACAO_ENLACE_PERDIDO | WIFI_ACAO_ASSOCIAR;
+        }
+        if (wifi->mudanca_netif) {
+            wifi->mudanca_netif = false;
+            return WIFI_ACAO_ENDERECO_MUDOU;
+        }
+        return 0;
+    }
+    return 0;
+}
+
+// Pede ao CYW43 a associação preparada por wifi_preparar_associacao()
+static void wifi_iniciar_associacao(gerenciador_wifi_t *wifi) {
+    if (wifi->conexao_rapida) {
+        printf("Reconexão rápida (BSSID %02x:%02x:%02x:%02x:%02x:%02x)...\n",
+               wifi->cache.bssid[0], wifi->cache.bssid[1], wifi->cache.bssid[2],
+               wifi->cache.bssid[3], wifi->cache.bssid[4], wifi->cache.bssid[5]);
+        cyw43_arch_wifi_connect_bssid_async(WIFI_SSID, wifi->cache.bssid, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK);
+    } else {
+        printf("Conectando ao Wi-Fi...\n");
+        cyw43_arch_wifi_connect_async(WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK);
+    }
+}
+
+// Inicializa o CYW43, lê o cache da flash e começa a primeira associação
+bool wifi_iniciar(gerenciador_wifi_t *wifi) {
+    memset(wifi, 0, sizeof(*wifi));
     if (cyw43_arch_init()) {
         printf("Erro ao inicializar Wi-Fi\n");
         gpio_put(LED_WIFI_ERRO, 1);
         return false;
     }
     cyw43_arch_enable_sta_mode();
-    if (cyw43_arch_wifi_connect_timeout_ms(WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK, 20000)) {
-        printf("Falha na conexão Wi-Fi\n");
+
+    cyw43_arch_lwip_begin();
+    netif_set_status_callback(netif_default, callback_status_netif);
+    netif_set_link_callback(netif_default, callback_status_netif);
+    cyw43_arch_lwip_end();
+
+    wifi->cache_valido = cache_rede_ler(&wifi->cache);
+    wifi->primeira_conexao = true;
+    wifi->inicio_conexao_ms = 0; // Métrica do boot: conta desde o reset
+    wifi_preparar_associacao(wifi, true, to_ms_since_boot(get_absolute_time()));
+    wifi_iniciar_associacao(wifi);
+    return true;
+}
+
+// Adaptador da máquina de estados: lê o enlace, aplica wifi_transicao() e executa as
+// ações no hardware. Chamada a cada volta do loop principal; retorna true enquanto
+// houver enlace com IP.
+bool wifi_processar(gerenciador_wifi_t *wifi) {
+    int status = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+    uint32_t acoes = wifi_transicao(wifi, status, to_ms_since_boot(get_absolute_time()));
+
+    if (acoes & WIFI_ACAO_RAPIDA_FALHOU) {
+        printf("Reconexão rápida falhou (%d). Fazendo conexão completa.\n", status);
+        cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+    }
+    if (acoes & WIFI_ACAO_COMPLETA_FALHOU) {
+        printf("Falha na conexão Wi-Fi (%d). Tentando novamente.\n", status);
         gpio_put(LED_WIFI_ERRO, 1);
+        cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+    }
+    if (acoes & WIFI_ACAO_ENLACE_PERDIDO) {
+        printf("Enlace Wi-Fi perdido (%d). Reconectando...\n", status);
+        gpio_put(LED_WIFI_CONECTADO, 0);
+    }
+    if (acoes & WIFI_ACAO_ASSOCIAR) {
+        wifi_iniciar_associacao(wifi);
+    }
+    if (acoes & WIFI_ACAO_USAR_IP_GUARDADO) {
+        ip4_addr_t ip, mascara, gateway;
+        ip4_addr_set_u32(&ip, wifi->cache.ip);
+        ip4_addr_set_u32(&mascara, wifi->cache.mascara);
+        ip4_addr_set_u32(&gateway, wifi->cache.gateway);
+        cyw43_arch_lwip_begin();
+        netif_set_addr(netif_default, &ip, &mascara, &gateway);
+        cyw43_arch_lwip_end();
+        printf("DHCP lento. Usando IP guardado: %s\n", ip4addr_ntoa(&ip));
+    }
+    if (acoes & WIFI_ACAO_CONECTADO) {
+        printf("Conectado! IP: %s\n", ip4addr_ntoa(netif_ip4_addr(netif_default)));
+        gpio_put(LED_WIFI_ERRO, 0);
+        gpio_put(LED_WIFI_CONECTADO, 1);
+        cache_rede_atualizar(wifi);
+    }
+    if (acoes & WIFI_ACAO_ENDERECO_MUDOU) {
+        printf("Endereço de rede atualizado: %s\n", ip4addr_ntoa(netif_ip4_addr(netif_default)));
+        cache_rede_atualizar(wifi);
+    }
+    return wifi->estado == WIFI_CONECTADO;
+}
+
+// Registra o tempo até a primeira amostra enviada após o boot ou após uma reconexão
+void wifi_registrar_primeira_amostra(gerenciador_wifi_t *wifi) {
+    if (!wifi->primeira_amostra_pendente) return;
+    wifi->primeira_amostra_pendente = false;
+    uint32_t t_amostra = to_ms_since_boot(get_absolute_time()) - wifi->inicio_conexao_ms;
+    printf("[%s] associado=%lums ip=%lums primeira amostra=%lums (reconexão rápida: %s, IP guardado: %s)\n",
+           wifi->primeira_conexao ? "BOOT" : "RECONEXAO",
+           (unsigned long)wifi->t_associado_ms, (unsigned long)wifi->t_ip_ms, (unsigned long)t_amostra,
+           wifi->conexao_rapida ? "sim" : "não", wifi->usando_ip_guardado ? "sim" : "não");
+}
+
+// =================================================================================
+// ==== PUBLICAÇÃO MQTT (OPCIONAL) ====
+// =================================================================================
+// Com TRANSPORTE_MQTT = 1 a placa publica em um broker MQTT em vez de falar com o
+// servidor.py: distribuição para vários consumidores e retenção do último estado ficam
+// por conta do broker. Um tópico por placa e sensor (<id> = identificador único da flash):
+//     rosadosventos/<id>/joystick   QoS 0          "SEQ=<n> VRX=<x> VRY=<y>\n" (várias linhas)
+//     rosadosventos/<id>/botoes     QoS 1, retido  "BTN=<j> A=<a> B=<b>\n"
+//     rosadosventos/<id>/ambiente   QoS 1, retido  "TEMP=<t> UMI=<u>\n"
+//     rosadosventos/<id>/status     QoS 1, retido  "online" ("offline" é o testamento)
+// As linhas têm o mesmo formato "CHAVE=valor" dos outros canais.
+//
+// Joystick (QoS 0): das leituras de 100 Hz entra no lote no máximo uma posição a cada
+// INTERVALO_POSICAO_JOYSTICK_MQTT_MS, e só se mudou (ou a cada INTERVALO_MAXIMO_JOYSTICK_MS,
+// parada); o lote sai a cada INTERVALO_MINIMO_JOYSTICK_MS ou quando enche. Sem espaço no
+// buffer de saída, o lote é descartado: o próximo traz posições mais novas.
+// Botões e DHT11 (QoS 1): no máximo JANELA_QOS1_MQTT publicações aguardando PUBACK. Com a
+// janela cheia o tópico fica pendente e, quando ela abre, sai o valor mais recente (o
+// estado intermediário é substituído, não enfileirado). Sem PUBACK no prazo do lwIP, o
+// tópico volta a ficar pendente.
+
+#if TRANSPORTE_MQTT
+#if JANELA_QOS1_MQTT >= MQTT_REQ_MAX_IN_FLIGHT
+#error "JANELA_QOS1_MQTT deve ser menor que MQTT_REQ_MAX_IN_FLIGHT (lwipopts.h)"
+#endif
+
+typedef enum {
+    TOPICO_MQTT_JOYSTICK,
+    TOPICO_MQTT_BOTOES,
+    TOPICO_MQTT_AMBIENTE,
+    TOPICO_MQTT_STATUS,
+    NUM_TOPICOS_MQTT
+} topico_mqtt_t;
+
+static const char *const NOMES_TOPICOS_MQTT[NUM_TOPICOS_MQTT] = {"joystick", "botoes", "ambiente", "status"};
+
+// Publicação QoS 1 aguardando PUBACK (uma posição da janela)
+typedef struct {
+    bool ocupada;
+    topico_mqtt_t topico;
+    uint32_t enviada_us;
+} publicacao_qos1_t;
+
+typedef struct {
+    mqtt_client_t *cliente;
+    ip_addr_t endereco_broker;
+    struct mqtt_connect_client_info_t info;
+    char id_placa[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+    char id_cliente[32];
+    char topicos[NUM_TOPICOS_MQTT][64];
+
+    volatile bool conectado;
+    volatile bool conexao_em_andamento;
+    bool conexao_agendada;           // Primeira tentativa após o Wi-Fi subir já foi agendada
+    bool estava_conectado;           // Conectado na volta anterior do loop (detecta a queda)
+    uint32_t ultima_tentativa_ms;
+    uint32_t espera_reconexao_ms;
+
+    // QoS 1
+    publicacao_qos1_t janela[JANELA_QOS1_MQTT];
+    volatile bool pendente[NUM_TOPICOS_MQTT];
+
+    // Lote do joystick (QoS 0)
+    char lote_joystick[LOTE_JOYSTICK_MQTT * 40];  // "SEQ=<até 10 dígitos> VRX=<x> VRY=<y>\n" por posição
+    size_t tamanho_lote;
+    uint32_t posicoes_lote;
+    uint32_t sequencia_joystick;
+    uint16_t ultimo_x, ultimo_y;
+    uint32_t ultima_posicao_ms;
+    uint32_t ultimo_envio_joystick_ms;
+
+    // Estatísticas da janela atual do relatório
+    uint32_t inicio_estatisticas_ms;
+    uint32_t publicadas[NUM_TOPICOS_MQTT];
+    uint32_t posicoes_publicadas;
+    uint32_t posicoes_descartadas;
+    uint32_t confirmadas;
+    uint32_t sem_confirmacao;
+    uint64_t soma_confirmacao_us;
+    uint32_t confirmacao_maxima_us;
+} publicador_mqtt_t;
+
+static publicador_mqtt_t g_mqtt;
+
+// Publicações em andamento são descartadas pelo lwIP ao fechar a conexão, sem callback
+static void mqtt_esvaziar_janela(publicador_mqtt_t *mqtt) {
+    memset(mqtt->janela, 0, sizeof(mqtt->janela));
+}
+
+static void callback_mqtt_conexao(mqtt_client_t *cliente, void *arg, mqtt_connection_status_t status) {
+    publicador_mqtt_t *mqtt = (publicador_mqtt_t*)arg;
+    mqtt->conexao_em_andamento = false;
+    if (status == MQTT_CONNECT_ACCEPTED) {
+        printf("Conectado ao broker MQTT.\n");
+        mqtt->conectado = true;
+        // Os tópicos retidos recebem o estado atual: pode ter mudado enquanto estava fora
+        mqtt->pendente[TOPICO_MQTT_STATUS] = true;
+        mqtt->pendente[TOPICO_MQTT_BOTOES] = true;
+        mqtt->pendente[TOPICO_MQTT_AMBIENTE] = true;
+    } else {
+        printf("Conexão MQTT encerrada (status %d).\n", status);
+        mqtt->conectado = false;
+        mqtt_esvaziar_janela(mqtt);
+    }
+}
+
+// PUBACK recebido (ERR_OK) ou prazo do lwIP esgotado
+static void callback_mqtt_publicacao(void *arg, err_t erro) {
+    publicacao_qos1_t *publicacao = (publicacao_qos1_t*)arg;
+    if (!publicacao->ocupada) return; // Janela esvaziada por uma desconexão
+    if (erro == ERR_OK) {
+        uint32_t espera_us = time_us_32() - publicacao->enviada_us;
+        g_mqtt.confirmadas++;
+        g_mqtt.soma_confirmacao_us += espera_us;
+        if (espera_us > g_mqtt.confirmacao_maxima_us) g_mqtt.confirmacao_maxima_us = espera_us;
+    } else {
+        g_mqtt.sem_confirmacao++;
+        g_mqtt.pendente[publicacao->topico] = true;
+    }
+    publicacao->ocupada = false;
+}
+
+bool mqtt_iniciar(publicador_mqtt_t *mqtt) {
+    memset(mqtt, 0, sizeof(*mqtt));
+    ipaddr_aton(IP_BROKER_MQTT, &mqtt->endereco_broker);
+    pico_get_unique_board_id_string(mqtt->id_placa, sizeof(mqtt->id_placa));
+    snprintf(mqtt->id_cliente, sizeof(mqtt->id_cliente), "rosa-%s", mqtt->id_placa);
+    for (int i = 0; i < NUM_TOPICOS_MQTT; i++) {
+        snprintf(mqtt->topicos[i], sizeof(mqtt->topicos[i]), "%s/%s/%s",
+                 PREFIXO_TOPICOS_MQTT, mqtt->id_placa, NOMES_TOPICOS_MQTT[i]);
+    }
+
+    mqtt->info.client_id = mqtt->id_cliente;
+    mqtt->info.keep_alive = KEEP_ALIVE_MQTT_S;
+    mqtt->info.will_topic = mqtt->topicos[TOPICO_MQTT_STATUS];
+    mqtt->info.will_msg = "offline";
+    mqtt->info.will_qos = 1;
+    mqtt->info.will_retain = 1;
+
+    cyw43_arch_lwip_begin();
+    mqtt->cliente = mqtt_client_new(); // Aloca do heap do lwIP
+    cyw43_arch_lwip_end();
+    if (!mqtt->cliente) {
+        printf("Erro ao criar cliente MQTT\n");
         return false;
     }
-    printf("Conectado! IP: %s\n", ip4addr_ntoa(netif_ip4_addr(netif_default)));
-    gpio_put(LED_WIFI_CONECTADO, 1);
+    mqtt->inicio_estatisticas_ms = agora_ms();
+    printf("MQTT: tópicos %s/%s/*, memória do publicador=%u bytes + buffer de saída do lwIP=%u bytes\n",
+           PREFIXO_TOPICOS_MQTT, mqtt->id_placa, (unsigned)sizeof(*mqtt), (unsigned)MQTT_OUTPUT_RINGBUF_SIZE);
     return true;
 }
 
+static void mqtt_conectar(publicador_mqtt_t *mqtt) {
+    printf("Conectando ao broker MQTT %s:%d...\n", ipaddr_ntoa(&mqtt->endereco_broker), PORTA_BROKER_MQTT);
+    mqtt->ultima_tentativa_ms = agora_ms();
+    mqtt->espera_reconexao_ms = sortear_espera_reconexao(NULL); // O broker não pede espera
+    mqtt->conexao_em_andamento = true;
+    cyw43_arch_lwip_begin();
+    err_t erro = mqtt_client_connect(mqtt->cliente, &mqtt->endereco_broker, PORTA_BROKER_MQTT,
+                                     callback_mqtt_conexao, mqtt, &mqtt->info);
+    cyw43_arch_lwip_end();
+    if (erro != ERR_OK) {
+        printf("Erro ao iniciar conexão MQTT: %d\n", erro);
+        mqtt->conexao_em_andamento = false;
+    }
+}
+
+// Wi-Fi caiu: a conexão com o broker não serve mais
+void mqtt_desconectar(publicador_mqtt_t *mqtt) {
+    mqtt->conexao_agendada = false;
+    mqtt->estava_conectado = false;
+    if (!mqtt->conectado && !mqtt->conexao_em_andamento) return;
+    cyw43_arch_lwip_begin();
+    mqtt_disconnect(mqtt->cliente);
+    cyw43_arch_lwip_end();
+    mqtt->conectado = false;
+    mqtt->conexao_em_andamento = false;
+    mqtt_esvaziar_janela(mqtt);
+}
+
+// Publica o valor atual de um tópico QoS 1 se houver espaço na janela
+static bool mqtt_publicar_qos1(publicador_mqtt_t *mqtt, topico_mqtt_t topico) {
+    publicacao_qos1_t *publicacao = NULL;
+    for (int i = 0; i < JANELA_QOS1_MQTT; i++) {
+        if (!mqtt->janela[i].ocupada) {
+            publicacao = &mqtt->janela[i];
+            break;
+        }
+    }
+    if (!publicacao) return false;
+
+    char mensagem[64];
+    switch (topico) {
+    case TOPICO_MQTT_BOTOES:
+        snprintf(mensagem, sizeof(mensagem), "BTN=%d A=%d B=%d\n",
+                 g_leituras.botao_joystick, g_leituras.botao_a, g_leituras.botao_b);
+        break;
+    case TOPICO_MQTT_AMBIENTE:
+        snprintf(mensagem, sizeof(mensagem), "TEMP=%.1f UMI=%.1f\n", g_leituras.temperatura, g_leituras.umidade);
+        break;
+    default:
+        snprintf(mensagem, sizeof(mensagem), "online");
+        break;
+    }
+
+    cyw43_arch_lwip_begin();
+    publicacao->ocupada = true;
+    publicacao->topico = topico;
+    publicacao->enviada_us = time_us_32();
+    err_t erro = mqtt_publish(mqtt->cliente, mqtt->topicos[topico], mensagem, strlen(mensagem), 1, 1,
+                              callback_mqtt_publicacao, publicacao);
+    if (erro != ERR_OK) publicacao->ocupada = false;
+    cyw43_arch_lwip_end();
+    if (erro != ERR_OK) {
+        // ERR_MEM: buffer de saída cheio; o tópico continua pendente
+        return false;
+    }
+    mqtt->publicadas[topico]++;
+    return true;
+}
+
+// Recebe cada leitura do joystick: coloca no lote (se for a vez) e publica o lote (se for a hora)
+static void mqtt_joystick_processar(publicador_mqtt_t *mqtt, uint16_t x, uint16_t y) {
+    uint32_t agora = agora_ms();
+    bool primeira = mqtt->sequencia_joystick == 0;
+    uint32_t desde_posicao = agora - mqtt->ultima_posicao_ms;
+    bool mudou = abs((int)x - (int)mqtt->ultimo_x) >= LIMIAR_MUDANCA_ADC ||
+                 abs((int)y - (int)mqtt->ultimo_y) >= LIMIAR_MUDANCA_ADC;
+
+    if (mqtt->posicoes_lote < LOTE_JOYSTICK_MQTT &&
+        (primeira || (desde_posicao >= INTERVALO_POSICAO_JOYSTICK_MQTT_MS &&
+                      (mudou || desde_posicao >= INTERVALO_MAXIMO_JOYSTICK_MS)))) {
+        mqtt->tamanho_lote += snprintf(mqtt->lote_joystick + mqtt->tamanho_lote,
+                                       sizeof(mqtt->lote_joystick) - mqtt->tamanho_lote,
+                                       "SEQ=%lu VRX=%u VRY=%u\n",
+                                       (unsigned long)++mqtt->sequencia_joystick, x, y);
+        mqtt->posicoes_lote++;
+        mqtt->ultimo_x = x;
+        mqtt->ultimo_y = y;
+        mqtt->ultima_posicao_ms = agora;
+    }
+
+    if (mqtt->posicoes_lote == 0) return;
+    if (mqtt->posicoes_lote < LOTE_JOYSTICK_MQTT &&
+        agora - mqtt->ultimo_envio_joystick_ms < INTERVALO_MINIMO_JOYSTICK_MS) {
+        return;
+    }
+
+    cyw43_arch_lwip_begin();
+    err_t erro = mqtt_publish(mqtt->cliente, mqtt->topicos[TOPICO_MQTT_JOYSTICK], mqtt->lote_joystick,
+                              mqtt->tamanho_lote, 0, 0, NULL, NULL);
+    cyw43_arch_lwip_end();
+    if (erro == ERR_OK) {
+        mqtt->publicadas[TOPICO_MQTT_JOYSTICK]++;
+        mqtt->posicoes_publicadas += mqtt->posicoes_lote;
+    } else {
+        mqtt->posicoes_descartadas += mqtt->posicoes_lote;
+    }
+    mqtt->tamanho_lote = 0;
+    mqtt->posicoes_lote = 0;
+    mqtt->ultimo_envio_joystick_ms = agora;
+}
+
+static void mqtt_relatorio(publicador_mqtt_t *mqtt) {
+    uint32_t agora = agora_ms();
+    uint32_t janela_ms = agora - mqtt->inicio_estatisticas_ms;
+    if (janela_ms < PERIODO_ESTATISTICAS_MS) return;
+    mqtt->inicio_estatisticas_ms = agora;
+
+    uint32_t total = 0;
+    for (int i = 0; i < NUM_TOPICOS_MQTT; i++) total += mqtt->publicadas[i];
+    uint32_t joystick = mqtt->publicadas[TOPICO_MQTT_JOYSTICK];
+    printf("[MQTT] %.1f msg/s (joystick %.1f msg/s, %.1f posições/msg, descartadas=%lu) "
+           "QoS 1: publicadas=%lu PUBACK medio=%.1f ms max=%.1f ms sem PUBACK=%lu\n",
+           total * 1000.0f / (float)janela_ms, joystick * 1000.0f / (float)janela_ms,
+           joystick ? (float)mqtt->posicoes_publicadas / joystick : 0.0f,
+           (unsigned long)mqtt->posicoes_descartadas, (unsigned long)(total - joystick),
+           mqtt->confirmadas ? (float)mqtt->soma_confirmacao_us / mqtt->confirmadas / 1000.0f : 0.0f,
+           mqtt->confirmacao_maxima_us / 1000.0f, (unsigned long)mqtt->sem_confirmacao);
+    memset(mqtt->publicadas, 0, sizeof(mqtt->publicadas));
+    mqtt->posicoes_publicadas = 0;
+    mqtt->posicoes_descartadas = 0;
+    mqtt->confirmadas = 0;
+    mqtt->sem_confirmacao = 0;
+    mqtt->soma_confirmacao_us = 0;
+    mqtt->confirmacao_maxima_us = 0;
+}
+
+// Chamada a cada volta do loop principal com o Wi-Fi conectado
+void mqtt_processar(publicador_mqtt_t *mqtt) {
+    // Leituras novas marcam os tópicos; o valor publicado é sempre o mais recente
+    if (g_leituras.amostra_urgente) mqtt->pendente[TOPICO_MQTT_BOTOES] = true;
+    if (g_leituras.dht_novo) mqtt->pendente[TOPICO_MQTT_AMBIENTE] = true;
+    g_leituras.amostra_tcp_pendente = false;
+    g_leituras.amostra_urgente = false;
+    g_leituras.dht_novo = false;
+
+    if (!mqtt->conectado) {
+        g_leituras.joystick_novo = false;
+        if (!mqtt->conexao_agendada) {
+            // Wi-Fi acabou de subir: primeira tentativa após um atraso curto e sorteado
+            mqtt->ultima_tentativa_ms = agora_ms();
+            mqtt->espera_reconexao_ms = get_rand_32() % (ATRASO_MAXIMO_PRIMEIRA_TCP_MS + 1);
+            mqtt->conexao_agendada = true;
+        }
+        if (mqtt->estava_conectado) {
+            // O broker derrubou a conexão: a espera conta a partir da queda, sorteada como
+            // em qualquer tentativa (senão, todas as placas voltariam na mesma hora)
+            mqtt->estava_conectado = false;
+            mqtt->ultima_tentativa_ms = agora_ms();
+            mqtt->espera_reconexao_ms = sortear_espera_reconexao(NULL);
+        }
+        if (!mqtt->conexao_em_andamento && agora_ms() - mqtt->ultima_tentativa_ms >= mqtt->espera_reconexao_ms) {
+            mqtt_conectar(mqtt);
+        }
+    } else {
+        mqtt->estava_conectado = true;
+        if (g_leituras.joystick_novo) {
+            g_leituras.joystick_novo = false;
+            mqtt_joystick_processar(mqtt, g_leituras.vrx, g_leituras.vry);
+        }
+        // Botões antes do DHT11: são os eventos que precisam sair logo
+        static const topico_mqtt_t ordem_qos1[] = {TOPICO_MQTT_STATUS, TOPICO_MQTT_BOTOES, TOPICO_MQTT_AMBIENTE};
+        for (size_t i = 0; i < sizeof(ordem_qos1) / sizeof(ordem_qos1[0]); i++) {
+            topico_mqtt_t topico = ordem_qos1[i];
+            if (mqtt->pendente[topico] && mqtt_publicar_qos1(mqtt, topico)) {
+                mqtt->pendente[topico] = false;
+                if (topico != TOPICO_MQTT_STATUS) wifi_registrar_primeira_amostra(&g_wifi);
+            }
+        }
+    }
+    mqtt_relatorio(mqtt);
+}
+#endif
+
 // =================================================================================
 // ==== FUNÇÃO PRINCIPAL (MAIN) ====
 // =================================================================================
@@ -279,12 +1421,27 @@ int main() {
     stdio_init_all();
     
     inicializar_leds();
-    inicializar_perifericos();
+    sensores_inicializar();
 
-    if (!conectar_wifi()) {
+    if (!wifi_iniciar(&g_wifi)) {
         while (1) { tight_loop_contents(); } // Loop infinito em caso de falha no Wi-Fi
     }
 
+#if TRANSPORTE_MQTT
+    if (!mqtt_iniciar(&g_mqtt)) {
+        return 1;
+    }
+
+    while (true) {
+        sensores_processar();
+        if (wifi_processar(&g_wifi)) {
+            mqtt_processar(&g_mqtt);
+        } else {
+            mqtt_desconectar(&g_mqtt);
+        }
+        sensores_aguardar_proximo();
+    }
+#else
     // Prepara o estado do cliente TCP
     cliente_tcp_t *estado_tcp = calloc(1, sizeof(cliente_tcp_t));
     if (!estado_tcp) {
@@ -292,46 +1449,95 @@ int main() {
         return 1;
     }
     ipaddr_aton(IP_SERVIDOR, &estado_tcp->endereco_remoto);
+
+#if TRANSPORTE_JOYSTICK_UDP
+    static canal_joystick_udp_t canal_joystick;
+    if (!joystick_udp_iniciar(&canal_joystick, &estado_tcp->endereco_remoto)) {
+        return 1;
+    }
+#endif
     
-    // Variáveis para guardar os dados dos sensores
-    float temperatura = 0.0f;
-    float umidade = 0.0f;
+    // Agendador que acumula as amostras e controla o modo de energia do rádio
+    static agendador_tx_t agendador;
+    agendador_inicializar(&agendador);
+
+    uint32_t ultima_tentativa_tcp_ms = 0;
+    uint32_t espera_tcp_ms = 0;     // Espera sorteada até a próxima tentativa
+    bool tcp_agendado = false;      // Primeira tentativa após o Wi-Fi subir já foi agendada
+    bool tcp_estava_conectado = false; // Conectado na volta anterior do loop (detecta a queda)
 
     while (true) {
+        // Leituras de todos os sensores, cada um no seu período (ver REGISTRO DE SENSORES)
+        sensores_processar();
+
+        if (!wifi_processar(&g_wifi)) {
+            // Sem enlace: a conexão TCP antiga não serve mais
+            if (estado_tcp->pcb_tcp != NULL) {
+                cliente_tcp_fechar_conexao(estado_tcp);
+            }
+            tcp_agendado = false;
+            tcp_estava_conectado = false;
+            sensores_aguardar_proximo();
+            continue;
+        }
+
+#if TRANSPORTE_JOYSTICK_UDP
+        // O joystick segue pelo UDP mesmo enquanto o TCP estiver reconectando
+        if (g_leituras.joystick_novo) {
+            g_leituras.joystick_novo = false;
+            joystick_udp_processar(&canal_joystick, g_leituras.vrx, g_leituras.vry);
+        }
+#endif
+
+        if (estado_tcp->conectado) tcp_estava_conectado = true;
         if (!estado_tcp->conectado) {
-            printf("Tentando conectar...\n");
-            cliente_tcp_conectar(estado_tcp);
-            sleep_ms(3000); // Espera 3 segundos antes de tentar de novo
-        } else {
-            // Se conectado, lê sensores e envia dados
-
-            // Lê os botões (lógica invertida por causa do pull-up)
-            bool botaoJoystick = !gpio_get(PINO_JOY_BOTAO);
-            bool botaoA = !gpio_get(PINO_BOTAO_A);
-            bool botaoB = !gpio_get(PINO_BOTAO_B);
-
-            // Lê os eixos do Joystick
-            uint16_t x = ler_adc(1); // ADC 1 -> PINO_JOY_VRX
-            uint16_t y = ler_adc(0); // ADC 0 -> PINO_JOY_VRY
-
-            // Lê os dados do sensor DHT11
-            resultado_dht_t dados_dht = dht_ler_bloqueante(PINO_DHT);
-            if (dados_dht.valido) {
-                temperatura = dados_dht.temperatura_c;
-                umidade = dados_dht.umidade;
-            } else {
-                printf("Falha na leitura do DHT11. Usando valores antigos.\n");
+            if (!tcp_agendado) {
+                // Wi-Fi acabou de subir: primeira tentativa após um atraso curto e sorteado
+                ultima_tentativa_tcp_ms = agora_ms();
+                espera_tcp_ms = get_rand_32() % (ATRASO_MAXIMO_PRIMEIRA_TCP_MS + 1);
+                tcp_agendado = true;
+            }
+            if (tcp_estava_conectado || estado_tcp->espera_pedida_ms != 0) {
+                // Conexão fechada pelo servidor (ou por erro) ou recusada com RETRY: a próxima
+                // tentativa conta a partir de agora, com espera sorteada
+                tcp_estava_conectado = false;
+                ultima_tentativa_tcp_ms = agora_ms();
+                espera_tcp_ms = sortear_espera_reconexao(&estado_tcp->espera_pedida_ms);
             }
-            
+            if (agora_ms() - ultima_tentativa_tcp_ms >= espera_tcp_ms) {
+                printf("Tentando conectar...\n");
+                cliente_tcp_fechar_conexao(estado_tcp); // Descarta tentativa anterior que não completou
+                cliente_tcp_conectar(estado_tcp);
+                ultima_tentativa_tcp_ms = agora_ms();
+                espera_tcp_ms = sortear_espera_reconexao(&estado_tcp->espera_pedida_ms);
+            }
+        } else if (g_leituras.amostra_tcp_pendente || g_wifi.primeira_amostra_pendente) {
+            // Se conectado, entrega a amostra nova ao agendador. A primeira após conectar
+            // vai direto, sem esperar o lote, assim como as mudanças de botão.
+            bool urgente = g_leituras.amostra_urgente || g_wifi.primeira_amostra_pendente;
+            g_leituras.amostra_tcp_pendente = false;
+            g_leituras.amostra_urgente = false;
+
             // Monta a string de dados
             char mensagem[256];
-            snprintf(mensagem, sizeof(mensagem), "VRX=%u VRY=%u BTN=%d A=%d B=%d TEMP=%.1f UMI=%.1f\n", 
-                     x, y, botaoJoystick, botaoA, botaoB, temperatura, umidade);
-            
-            cliente_tcp_enviar_dados(estado_tcp, mensagem);
-            
-            // Espera antes da próxima leitura. O DHT11 não deve ser lido mais de uma vez a cada 2s.
-            sleep_ms(2000);
+#if TRANSPORTE_JOYSTICK_UDP
+            snprintf(mensagem, sizeof(mensagem), "BTN=%d A=%d B=%d TEMP=%.1f UMI=%.1f\n",
+                     g_leituras.botao_joystick, g_leituras.botao_a, g_leituras.botao_b,
+                     g_leituras.temperatura, g_leituras.umidade);
+#else
+            snprintf(mensagem, sizeof(mensagem), "VRX=%u VRY=%u BTN=%d A=%d B=%d TEMP=%.1f UMI=%.1f\n",
+                     g_leituras.vrx, g_leituras.vry, g_leituras.botao_joystick, g_leituras.botao_a,
+                     g_leituras.botao_b, g_leituras.temperatura, g_leituras.umidade);
+#endif
+
+            agendador_adicionar_amostra(&agendador, estado_tcp, mensagem, urgente);
+            if (agendador.amostras == 0) { // Lote foi enviado
+                wifi_registrar_primeira_amostra(&g_wifi);
+            }
         }
+        agendador_processar(&agendador, estado_tcp);
+        cliente_tcp_apagar_led(estado_tcp);
+        sensores_aguardar_proximo();
     }
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,992 @@
+// plataforma.c
+// Implementação do sdk_falso/ sobre um relógio virtual (ver plataforma.h).
+#define _GNU_SOURCE
+#define PLATAFORMA_SIMULADA
+#include "sdk_falso.h"
+#include "plataforma.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+// =================================================================================
+// ==== MODELO ====
+// =================================================================================
+#define INTERVALO_BEACON_US 102400u     // 100 TU, o padrão dos pontos de acesso
+#define ACORDADO_BEACON_US 2000u        // Recepção de um beacon
+#define ACORDADO_PACOTE_PM1_US 3000u    // PM1: acorda, troca um pacote e volta a dormir
+#define RETORNO_PM2_US 200000u          // PM2: acordado até 200ms após o último pacote
+#define TCP_SND_BUF_SIMULADO 1072u      // Padrão do lwIP (2 * TCP_MSS de 536)
+// O lwIP mede o RTO em ticks do temporizador lento (500ms): com RTT curto, fica em ~2
+// ticks. Estimativa, não medição na placa.
+#define RTO_TCP_SIMULADO_US 1000000u
+// stdio USB (CDC) com o terminal aberto: o buffer de saída do TinyUSB (256 bytes) enche
+// com um lote impresso e o printf passa a esperar os pacotes de 64 bytes, um por quadro
+// USB de 1ms. Estimativas, não medições na placa.
+#define CUSTO_PRINTF_USB_US 20u
+#define CUSTO_PRINTF_USB_US_POR_BYTE 16u
+
+cenario_t g_cenario = {
+    .duracao_s = 600,
+    .rtt_ms = 40,
+    .associacao_ms = 1200,
+    .dhcp_ms = 300,
+    .custo_printf_us = CUSTO_PRINTF_USB_US,
+    .custo_printf_us_por_byte = CUSTO_PRINTF_USB_US_POR_BYTE,
+};
+
+resultados_sim_t g_resultados;
+
+// =================================================================================
+// ==== RELÓGIO VIRTUAL E EVENTOS ("INTERRUPÇÕES") ====
+// =================================================================================
+typedef struct evento_t_ evento_t;
+struct evento_t_ {
+    uint64_t t_us;
+    void (*executar)(evento_t *evento);
+    bool recepcao;               // Pacote que chega pelo rádio: só é entregue com o CYW43 acordado
+    bool guardado;               // ... e já esperou o beacon no ponto de acesso
+    struct tcp_pcb *pcb;
+    uint32_t valor;
+    char *dados;                 // Cópia do que é entregue ao servidor (evento_entrega)
+};
+
+#define MAX_EVENTOS 256
+static evento_t g_eventos[MAX_EVENTOS];
+static int g_num_eventos;
+
+static uint64_t g_agora_us;
+static uint64_t g_fim_us;
+static bool g_em_irq;
+static jmp_buf g_fim_simulacao;
+
+uint64_t sim_agora_us(void) {
+    return g_agora_us;
+}
+
+static evento_t *agendar(uint64_t t_us, void (*executar)(evento_t *), bool recepcao, struct tcp_pcb *pcb, uint32_t valor) {
+    if (g_num_eventos == MAX_EVENTOS) {
+        fprintf(stderr, "simulação: fila de eventos cheia\n");
+        exit(2);
+    }
+    g_eventos[g_num_eventos] = (evento_t){t_us, executar, recepcao, false, pcb, valor, NULL};
+    return &g_eventos[g_num_eventos++];
+}
+
+static int proximo_evento(void) {
+    int escolhido = -1;
+    for (int i = 0; i < g_num_eventos; i++) {
+        if (escolhido < 0 || g_eventos[i].t_us < g_eventos[escolhido].t_us) escolhido = i;
+    }
+    return escolhido;
+}
+
+static void radio_processar_beacons_ate(uint64_t t_us);
+static bool radio_acordado(uint64_t t_us);
+static void radio_pacote(uint64_t t_us);
+static void radio_contabilizar_modo_ate(uint64_t t_us);
+static void tempo_real_esperar_ate(uint64_t t_us);
+static void mqtt_fechamento_pelo_broker(void);
+
+// Avança o relógio até t_us executando os eventos vencidos. Dentro de um callback
+// (g_em_irq), o tempo anda sem executar outros: as interrupções não se aninham.
+static void avancar_ate(uint64_t t_us) {
+    if (!g_em_irq) {
+        if (g_cenario.porta_broker_mqtt) tempo_real_esperar_ate(t_us);
+        int i;
+        while ((i = proximo_evento()) >= 0 && g_eventos[i].t_us <= t_us) {
+            evento_t evento = g_eventos[i];
+            g_eventos[i] = g_eventos[--g_num_eventos];
+            if (evento.t_us > g_agora_us) {
+                radio_contabilizar_modo_ate(evento.t_us);
+                radio_processar_beacons_ate(evento.t_us);
+                g_agora_us = evento.t_us;
+            }
+            if (evento.recepcao) {
+                if (!evento.guardado && !radio_acordado(g_agora_us)) {
+                    // O ponto de acesso guarda o pacote até o próximo beacon
+                    evento.t_us = (g_agora_us / INTERVALO_BEACON_US + 1) * INTERVALO_BEACON_US;
+                    evento.guardado = true;
+                    g_eventos[g_num_eventos++] = evento;
+                    continue;
+                }
+                radio_pacote(g_agora_us);
+                g_resultados.pacotes_rx++;
+            }
+            g_em_irq = true;
+            evento.executar(&evento);
+            g_em_irq = false;
+        }
+    }
+    if (t_us > g_agora_us) {
+        radio_contabilizar_modo_ate(t_us);
+        radio_processar_beacons_ate(t_us);
+        g_agora_us = t_us;
+    }
+    if (!g_em_irq) mqtt_fechamento_pelo_broker();
+    if (!g_em_irq && g_agora_us >= g_fim_us) longjmp(g_fim_simulacao, 1);
+}
+
+void sleep_us(uint64_t us) { avancar_ate(g_agora_us + us); }
+void sleep_ms(uint32_t ms) { avancar_ate(g_agora_us + (uint64_t)ms * 1000); }
+void busy_wait_us(uint64_t us) { avancar_ate(g_agora_us + us); }
+void busy_wait_ms(uint32_t ms) { avancar_ate(g_agora_us + (uint64_t)ms * 1000); }
+uint32_t time_us_32(void) { return (uint32_t)g_agora_us; }
+uint64_t time_us_64(void) { return g_agora_us; }
+absolute_time_t get_absolute_time(void) { return g_agora_us; }
+uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000); }
+bool stdio_init_all(void) { return true; }
+
+int sim_printf(const char *formato, ...) {
+    char texto[2048];
+    va_list argumentos;
+    va_start(argumentos, formato);
+    int tamanho = vsnprintf(texto, sizeof(texto), formato, argumentos);
+    va_end(argumentos);
+    if (g_cenario.verboso || texto[0] == '[') {
+        size_t comprimento = strlen(texto);
+        printf("%10.3f %s%s", g_agora_us / 1e6, texto, comprimento && texto[comprimento - 1] == '\n' ? "" : "\n");
+    }
+    // O firmware fica parado enquanto o texto sai (as interrupções continuam)
+    uint64_t custo = g_cenario.custo_printf_us + (uint64_t)g_cenario.custo_printf_us_por_byte * tamanho;
+    g_resultados.bytes_printf += tamanho;
+    g_resultados.tempo_printf_us += custo;
+    avancar_ate(g_agora_us + custo);
+    return tamanho;
+}
+
+// =================================================================================
+// ==== RÁDIO (CYW43) ====
+// =================================================================================
+cyw43_t cyw43_state;
+
+static uint32_t g_modo_pm = CYW43_PERFORMANCE_PM; // Padrão do driver após cyw43_arch_init
+static uint64_t g_modo_desde_us;
+static uint64_t g_acordado_ate_us;
+static uint64_t g_proximo_beacon_us = INTERVALO_BEACON_US;
+static bool g_associado;
+
+static void radio_contabilizar_modo_ate(uint64_t t_us) {
+    if (g_modo_pm == CYW43_PERFORMANCE_PM) g_resultados.tempo_desempenho_us += t_us - g_modo_desde_us;
+    g_modo_desde_us = t_us;
+}
+
+// Soma o intervalo [inicio, fim) ao tempo acordado, sem contar duas vezes o que já estava
+// acordado. Os intervalos chegam em ordem de início.
+static void radio_acordar(uint64_t inicio, uint64_t fim) {
+    if (fim <= g_acordado_ate_us) return;
+    g_resultados.tempo_acordado_us += fim - (inicio > g_acordado_ate_us ? inicio : g_acordado_ate_us);
+    g_acordado_ate_us = fim;
+}
+
+static void radio_processar_beacons_ate(uint64_t t_us) {
+    while (g_proximo_beacon_us <= t_us) {
+        if (g_associado) radio_acordar(g_proximo_beacon_us, g_proximo_beacon_us + ACORDADO_BEACON_US);
+        g_proximo_beacon_us += INTERVALO_BEACON_US;
+    }
+}
+
+static bool radio_acordado(uint64_t t_us) {
+    return t_us < g_acordado_ate_us;
+}
+
+// Um pacote enviado ou recebido agora
+static void radio_pacote(uint64_t t_us) {
+    radio_acordar(t_us, t_us + (g_modo_pm == CYW43_PERFORMANCE_PM ? RETORNO_PM2_US : ACORDADO_PACOTE_PM1_US));
+}
+
+static void radio_transmitir(void) {
+    radio_pacote(g_agora_us);
+    g_resultados.pacotes_tx++;
+}
+
+int cyw43_wifi_pm(cyw43_t *estado, uint32_t modo) {
+    radio_contabilizar_modo_ate(g_agora_us);
+    if (modo != g_modo_pm) g_resultados.trocas_modo_pm++;
+    g_modo_pm = modo;
+    return 0;
+}
+
+// --- Wi-Fi ---
+static uint64_t g_t_associacao_us = UINT64_MAX;  // Instante em que o enlace sobe
+static uint64_t g_t_ip_us = UINT64_MAX;          // Instante em que o DHCP responde
+static bool g_ip_anunciado;
+
+static struct netif g_netif;
+struct netif *netif_default = &g_netif;
+
+int cyw43_arch_init(void) { return 0; }
+void cyw43_arch_enable_sta_mode(void) {}
+// --- Trava do lwIP ---
+static int g_profundidade_trava;
+
+void cyw43_arch_lwip_begin(void) { g_profundidade_trava++; }
+void cyw43_arch_lwip_end(void) { g_profundidade_trava--; }
+
+// Os callbacks já rodam com a trava; no loop principal ela precisa ter sido tomada
+#define VERIFICAR_TRAVA() verificar_trava(__func__)
+static void verificar_trava(const char *funcao) {
+    static const char *ja_avisadas[32];
+    if (g_em_irq || g_profundidade_trava > 0) return;
+    g_resultados.chamadas_lwip_sem_trava++;
+    for (int i = 0; i < 32; i++) {
+        if (ja_avisadas[i] == funcao) return;
+        if (!ja_avisadas[i]) {
+            ja_avisadas[i] = funcao;
+            fprintf(stderr, "%10.3f %s() chamada sem cyw43_arch_lwip_begin()\n", g_agora_us / 1e6, funcao);
+            return;
+        }
+    }
+}
+
+static void evento_ip(evento_t *evento) {
+    if (g_agora_us < g_t_ip_us) return; // Associação desfeita (ou refeita) depois de agendado
+    g_netif.ip_addr.addr = inet_addr("192.168.0.50");
+    g_netif.netmask.addr = inet_addr("255.255.255.0");
+    g_netif.gw.addr = inet_addr("192.168.0.1");
+    g_ip_anunciado = true;
+    if (g_netif.status_callback) g_netif.status_callback(&g_netif);
+}
+
+// Ponto de acesso fora do ar de [queda, fim da queda)
+static uint64_t inicio_queda_us(void) {
+    return g_cenario.queda_enlace_s ? (uint64_t)g_cenario.queda_enlace_s * 1000000u : UINT64_MAX;
+}
+
+static uint64_t fim_queda_us(void) {
+    return inicio_queda_us() == UINT64_MAX ? 0 : inicio_queda_us() + (uint64_t)g_cenario.duracao_queda_ms * 1000;
+}
+
+static int iniciar_associacao(void) {
+    uint64_t inicio = g_agora_us;
+    if (inicio >= inicio_queda_us() && inicio < fim_queda_us()) inicio = fim_queda_us();
+    g_t_associacao_us = inicio + (uint64_t)g_cenario.associacao_ms * 1000;
+    g_t_ip_us = g_t_associacao_us + (uint64_t)g_cenario.dhcp_ms * 1000;
+    g_ip_anunciado = false;
+    agendar(g_t_ip_us, evento_ip, false, NULL, 0);
+    return 0;
+}
+
+int cyw43_arch_wifi_connect_async(const char *ssid, const char *senha, uint32_t autenticacao) {
+    return iniciar_associacao();
+}
+
+int cyw43_arch_wifi_connect_bssid_async(const char *ssid, const uint8_t *bssid, const char *senha, uint32_t autenticacao) {
+    return iniciar_associacao();
+}
+
+int cyw43_wifi_leave(cyw43_t *estado, int itf) {
+    g_t_associacao_us = g_t_ip_us = UINT64_MAX;
+    g_associado = false;
+    return 0;
+}
+
+int cyw43_wifi_get_bssid(cyw43_t *estado, uint8_t bssid[6]) {
+    static const uint8_t bssid_simulado[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    memcpy(bssid, bssid_simulado, 6);
+    return 0;
+}
+
+int cyw43_tcpip_link_status(cyw43_t *estado, int itf) {
+    static bool queda_aplicada;
+    if (!queda_aplicada && g_agora_us >= inicio_queda_us()) {
+        // O enlace cai: só volta com uma nova associação, depois do fim da queda
+        queda_aplicada = true;
+        g_t_associacao_us = g_t_ip_us = UINT64_MAX;
+        g_ip_anunciado = false;
+        if (g_netif.link_callback) g_netif.link_callback(&g_netif);
+    }
+    g_associado = g_agora_us >= g_t_associacao_us;
+    if (!g_associado) return CYW43_LINK_DOWN;
+    if (!g_ip_anunciado) return CYW43_LINK_NOIP;
+    return CYW43_LINK_UP;
+}
+
+void netif_set_status_callback(struct netif *netif, netif_status_callback_fn callback) {
+    VERIFICAR_TRAVA();
+    netif->status_callback = callback;
+}
+void netif_set_link_callback(struct netif *netif, netif_status_callback_fn callback) {
+    VERIFICAR_TRAVA();
+    netif->link_callback = callback;
+}
+
+void netif_set_addr(struct netif *netif, const ip4_addr_t *ip, const ip4_addr_t *mascara, const ip4_addr_t *gateway) {
+    VERIFICAR_TRAVA();
+    netif->ip_addr = *ip;
+    netif->netmask = *mascara;
+    netif->gw = *gateway;
+}
+
+char *ip4addr_ntoa(const ip4_addr_t *endereco) {
+    struct in_addr in = {.s_addr = endereco->addr};
+    return inet_ntoa(in);
+}
+
+char *ipaddr_ntoa(const ip_addr_t *endereco) {
+    return ip4addr_ntoa(endereco);
+}
+
+int ipaddr_aton(const char *texto, ip_addr_t *endereco) {
+    struct in_addr in;
+    if (!inet_aton(texto, &in)) return 0;
+    endereco->addr = in.s_addr;
+    return 1;
+}
+
+// =================================================================================
+// ==== GPIO, ADC E SENSOR DHT11 ====
+// =================================================================================
+#define NUM_PINOS 30
+#define PINO_DHT_SIMULADO 16
+static bool g_pino_saida[NUM_PINOS];
+static bool g_pino_valor[NUM_PINOS];
+static uint g_canal_adc;
+
+// Resposta do DHT11 a partir do instante em que o Pico solta a linha (gpio_set_dir IN):
+// 80us em nível baixo, 80us em alto e, para cada bit, 50us baixo seguidos de 26us (0)
+// ou 70us (1) em alto. Leitura fixa de 25,3 °C e 60,1 %.
+static uint64_t g_dht_inicio_resposta_us = UINT64_MAX;
+static const uint8_t g_dht_dados[5] = {60, 1, 25, 3, (60 + 1 + 25 + 3) & 0xFF};
+
+static bool dht_nivel(uint64_t t_us) {
+    if (t_us < g_dht_inicio_resposta_us) return true;
+    uint64_t t = t_us - g_dht_inicio_resposta_us;
+    if (t < 20) return true;
+    if (t < 100) return false;
+    if (t < 180) return true;
+    t -= 180;
+    for (int i = 0; i < 40; i++) {
+        uint64_t alto = (g_dht_dados[i / 8] >> (7 - i % 8)) & 1 ? 70 : 26;
+        if (t < 50) return false;
+        if (t < 50 + alto) return true;
+        t -= 50 + alto;
+    }
+    return t >= 50;
+}
+
+void gpio_init(uint pino) {
+    g_pino_saida[pino] = false;
+    g_pino_valor[pino] = false;
+}
+
+void gpio_set_dir(uint pino, bool saida) {
+    if (pino == PINO_DHT_SIMULADO && g_pino_saida[pino] && !saida) g_dht_inicio_resposta_us = g_agora_us;
+    g_pino_saida[pino] = saida;
+}
+
+void gpio_put(uint pino, bool valor) { g_pino_valor[pino] = valor; }
+void gpio_pull_up(uint pino) {}
+
+static void joystick_padrao(uint64_t t_us, uint16_t *x, uint16_t *y) {
+    // Move por 5s e fica parado por 25s, a cada 30s
+    uint64_t fase = t_us % 30000000u;
+    if (fase > 5000000u) fase = 5000000u;
+    *x = (uint16_t)(2048 + fase * 1800 / 5000000u);
+    *y = 2048;
+}
+
+static bool botao_padrao(uint64_t t_us, unsigned pino) {
+    // Botão A pressionado por 200ms a cada 15s
+    return pino == 5 && t_us % 15000000u < 200000u;
+}
+
+bool gpio_get(uint pino) {
+    if (g_pino_saida[pino]) return g_pino_valor[pino];
+    if (pino == PINO_DHT_SIMULADO) return dht_nivel(g_agora_us);
+    bool pressionado = (g_cenario.botao ? g_cenario.botao : botao_padrao)(g_agora_us, pino);
+    return !pressionado; // Pull-up: pressionado = nível baixo
+}
+
+void adc_init(void) {}
+void adc_gpio_init(uint pino) {}
+void adc_select_input(uint canal) { g_canal_adc = canal; }
+
+uint16_t adc_read(void) {
+    uint16_t x, y;
+    (g_cenario.joystick ? g_cenario.joystick : joystick_padrao)(g_agora_us, &x, &y);
+    return g_canal_adc == 1 ? x : y; // ADC 1 = VRX, ADC 0 = VRY
+}
+
+// =================================================================================
+// ==== ALEATORIEDADE, IDENTIFICADOR E FLASH ====
+// =================================================================================
+static uint32_t g_semente = 0x2545F491u;
+
+uint32_t get_rand_32(void) {
+    g_semente ^= g_semente << 13;
+    g_semente ^= g_semente >> 17;
+    g_semente ^= g_semente << 5;
+    return g_semente;
+}
+
+void pico_get_unique_board_id_string(char *id, uint tamanho) {
+    snprintf(id, tamanho, "%s", g_cenario.id_placa ? g_cenario.id_placa : "E6614C311B6A9F2A");
+}
+
+static uint8_t *g_flash;
+
+static void flash_mapear(void) {
+    if (g_flash) return;
+    // O firmware lê a flash direto do endereço XIP, como na placa
+    g_flash = mmap((void *)(uintptr_t)XIP_BASE, PICO_FLASH_SIZE_BYTES, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (g_flash != (uint8_t *)(uintptr_t)XIP_BASE) {
+        fprintf(stderr, "simulação: não foi possível mapear a flash em 0x%08x\n", XIP_BASE);
+        exit(2);
+    }
+    memset(g_flash, 0xFF, PICO_FLASH_SIZE_BYTES);
+}
+
+void flash_range_erase(uint32_t deslocamento, size_t tamanho) {
+    memset(g_flash + deslocamento, 0xFF, tamanho);
+}
+
+void flash_range_program(uint32_t deslocamento, const uint8_t *dados, size_t tamanho) {
+    for (size_t i = 0; i < tamanho; i++) g_flash[deslocamento + i] &= dados[i];
+}
+
+int flash_safe_execute(void (*funcao)(void *), void *parametro, uint32_t timeout_ms) {
+    funcao(parametro);
+    return PICO_OK;
+}
+
+// =================================================================================
+// ==== CAMINHO ATÉ O SERVIDOR (PERDA E ATRASO) ====
+// =================================================================================
+// Sorteios próprios, para que a perda não mude a sequência de get_rand_32 do firmware
+static uint32_t g_semente_rede = 0x9E3779B9u;
+
+static uint32_t rede_sortear(void) {
+    g_semente_rede ^= g_semente_rede << 13;
+    g_semente_rede ^= g_semente_rede >> 17;
+    g_semente_rede ^= g_semente_rede << 5;
+    return g_semente_rede;
+}
+
+static bool rede_perde_pacote(void) {
+    if (!g_cenario.perda_por_mil || rede_sortear() % 1000 >= g_cenario.perda_por_mil) return false;
+    g_resultados.pacotes_perdidos++;
+    return true;
+}
+
+static uint64_t rede_atraso_ida_us(void) {
+    uint64_t atraso = (uint64_t)g_cenario.rtt_ms * 500;
+    if (g_cenario.variacao_atraso_ms) atraso += rede_sortear() % ((uint64_t)g_cenario.variacao_atraso_ms * 1000 + 1);
+    return atraso;
+}
+
+static void evento_entrega(evento_t *evento) {
+    g_cenario.entregue(g_agora_us, evento->pcb != NULL, evento->dados, (uint16_t)evento->valor);
+    free(evento->dados);
+}
+
+// Entrega 'dados' ao servidor no instante t_us (do lado do servidor: não passa pelo rádio)
+static void rede_entregar(uint64_t t_us, struct tcp_pcb *pcb, const void *dados, uint16_t tamanho) {
+    if (!g_cenario.entregue) return;
+    evento_t *evento = agendar(t_us, evento_entrega, false, pcb, tamanho);
+    evento->dados = malloc(tamanho);
+    memcpy(evento->dados, dados, tamanho);
+}
+
+// =================================================================================
+// ==== LWIP: PBUF, TCP E UDP ====
+// =================================================================================
+struct pbuf *pbuf_alloc(int camada, u16_t tamanho, int tipo) {
+    VERIFICAR_TRAVA();
+    struct pbuf *p = malloc(sizeof(struct pbuf) + tamanho);
+    if (!p) return NULL;
+    p->next = NULL;
+    p->payload = p + 1;
+    p->tot_len = p->len = tamanho;
+    return p;
+}
+
+u8_t pbuf_free(struct pbuf *p) {
+    VERIFICAR_TRAVA();
+    free(p);
+    return 1;
+}
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *destino, u16_t tamanho, u16_t deslocamento) {
+    if (deslocamento >= p->len) return 0;
+    if (tamanho > p->len - deslocamento) tamanho = p->len - deslocamento;
+    memcpy(destino, (const uint8_t *)p->payload + deslocamento, tamanho);
+    return tamanho;
+}
+
+// Fechamento pelo servidor (g_cenario.fechamento_servidor_s): uma vez por simulação
+static bool g_servidor_fechou;
+static bool g_fechamento_agendado;   // Evento agendado para a conexão TCP aberta
+static uint64_t g_fechamento_us;
+
+static uint64_t instante_fechamento_us(void) {
+    return g_cenario.fechamento_servidor_s ? (uint64_t)g_cenario.fechamento_servidor_s * 1000000u : UINT64_MAX;
+}
+
+static void registrar_fechamento(void) {
+    g_servidor_fechou = true;
+    g_fechamento_us = g_agora_us;
+}
+
+static void registrar_conexao_aceita(void) {
+    if (g_servidor_fechou && g_resultados.reconexao_us == 0) g_resultados.reconexao_us = g_agora_us - g_fechamento_us;
+}
+
+struct tcp_pcb {
+    void *arg;
+    tcp_connected_fn conectado;
+    tcp_sent_fn enviado;
+    tcp_recv_fn recebido;
+    tcp_err_fn erro;
+    bool vivo;                   // false depois de tcp_close/tcp_abort (eventos pendentes são ignorados)
+    uint32_t nao_enviados;       // Escritos e ainda não passados a tcp_output
+    uint32_t em_voo;             // Enviados aguardando ACK
+    uint8_t fluxo[TCP_SND_BUF_SIMULADO]; // Os em voo e, depois deles, os não enviados
+    uint64_t ultima_entrega_us;  // Entrega ao servidor do último segmento enviado
+};
+
+struct tcp_pcb *tcp_new_ip_type(u8_t tipo) {
+    VERIFICAR_TRAVA();
+    // Nunca liberado: eventos agendados podem apontar para um PCB já fechado
+    struct tcp_pcb *pcb = calloc(1, sizeof(*pcb));
+    pcb->vivo = true;
+    return pcb;
+}
+
+void tcp_arg(struct tcp_pcb *pcb, void *arg) {
+    VERIFICAR_TRAVA();
+    pcb->arg = arg;
+}
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn callback) {
+    VERIFICAR_TRAVA();
+    pcb->enviado = callback;
+}
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn callback) {
+    VERIFICAR_TRAVA();
+    pcb->recebido = callback;
+}
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn callback) {
+    VERIFICAR_TRAVA();
+    pcb->erro = callback;
+}
+void tcp_recved(struct tcp_pcb *pcb, u16_t tamanho) {
+    VERIFICAR_TRAVA();
+}
+
+// FIN do servidor: a placa vê um tcp_recv com pbuf NULL
+static void evento_servidor_fecha(evento_t *evento) {
+    struct tcp_pcb *pcb = evento->pcb;
+    g_fechamento_agendado = false;
+    if (!pcb->vivo) return; // A placa fechou antes: o fechamento fica para a próxima conexão
+    registrar_fechamento();
+    if (pcb->recebido) pcb->recebido(pcb->arg, pcb, NULL, ERR_OK);
+}
+
+static void evento_tcp_conectado(evento_t *evento) {
+    struct tcp_pcb *pcb = evento->pcb;
+    if (!pcb->vivo) return;
+    g_resultados.conexoes_tcp++;
+    registrar_conexao_aceita();
+    if (g_cenario.fechamento_servidor_s && !g_servidor_fechou && !g_fechamento_agendado) {
+        uint64_t t_us = instante_fechamento_us();
+        agendar(t_us > g_agora_us ? t_us : g_agora_us, evento_servidor_fecha, true, pcb, 0);
+        g_fechamento_agendado = true;
+    }
+    if (pcb->conectado) pcb->conectado(pcb->arg, pcb, ERR_OK);
+}
+
+static void evento_tcp_ack(evento_t *evento) {
+    struct tcp_pcb *pcb = evento->pcb;
+    if (!pcb->vivo) return;
+    pcb->em_voo -= evento->valor;
+    memmove(pcb->fluxo, pcb->fluxo + evento->valor, pcb->em_voo + pcb->nao_enviados);
+    g_resultados.bytes_tcp_confirmados += evento->valor;
+    if (pcb->enviado) pcb->enviado(pcb->arg, pcb, (u16_t)evento->valor);
+}
+
+err_t tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *endereco, u16_t porta, tcp_connected_fn callback) {
+    VERIFICAR_TRAVA();
+    pcb->conectado = callback;
+    radio_transmitir(); // SYN
+    agendar(g_agora_us + (uint64_t)g_cenario.rtt_ms * 1000, evento_tcp_conectado, true, pcb, 0);
+    return ERR_OK;
+}
+
+err_t tcp_write(struct tcp_pcb *pcb, const void *dados, u16_t tamanho, u8_t flags) {
+    VERIFICAR_TRAVA();
+    if (pcb->nao_enviados + pcb->em_voo + tamanho > TCP_SND_BUF_SIMULADO) return ERR_MEM;
+    memcpy(pcb->fluxo + pcb->em_voo + pcb->nao_enviados, dados, tamanho);
+    pcb->nao_enviados += tamanho;
+    g_resultados.escritas_tcp++;
+    g_resultados.bytes_tcp_escritos += tamanho;
+    return ERR_OK;
+}
+
+err_t tcp_output(struct tcp_pcb *pcb) {
+    VERIFICAR_TRAVA();
+    if (pcb->nao_enviados == 0) return ERR_OK;
+    radio_transmitir();
+    // Cada perda custa um RTO; depois o segmento ainda espera os anteriores, e o ACK
+    // (cumulativo) volta meio RTT depois da entrega. As retransmissões não entram na
+    // conta do rádio.
+    uint64_t envio_us = g_agora_us, rto_us = RTO_TCP_SIMULADO_US;
+    while (rede_perde_pacote()) {
+        g_resultados.retransmissoes_tcp++;
+        envio_us += rto_us;
+        rto_us *= 2;
+    }
+    uint64_t entrega_us = envio_us + rede_atraso_ida_us();
+    if (entrega_us < pcb->ultima_entrega_us) entrega_us = pcb->ultima_entrega_us;
+    pcb->ultima_entrega_us = entrega_us;
+    rede_entregar(entrega_us, pcb, pcb->fluxo + pcb->em_voo, (uint16_t)pcb->nao_enviados);
+    agendar(entrega_us + (uint64_t)g_cenario.rtt_ms * 500, evento_tcp_ack, true, pcb, pcb->nao_enviados);
+    pcb->em_voo += pcb->nao_enviados;
+    pcb->nao_enviados = 0;
+    return ERR_OK;
+}
+
+err_t tcp_close(struct tcp_pcb *pcb) {
+    VERIFICAR_TRAVA();
+    pcb->vivo = false;
+    return ERR_OK;
+}
+
+void tcp_abort(struct tcp_pcb *pcb) {
+    VERIFICAR_TRAVA();
+    pcb->vivo = false;
+}
+
+struct udp_pcb {
+    int reservado;
+};
+
+struct udp_pcb *udp_new(void) {
+    VERIFICAR_TRAVA();
+    static struct udp_pcb pcb;
+    return &pcb;
+}
+
+err_t udp_sendto(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *endereco, u16_t porta) {
+    VERIFICAR_TRAVA();
+    radio_transmitir();
+    g_resultados.datagramas_udp++;
+    if (!rede_perde_pacote()) rede_entregar(g_agora_us + rede_atraso_ida_us(), NULL, p->payload, p->len);
+    return ERR_OK;
+}
+
+// =================================================================================
+// ==== LWIP: CLIENTE MQTT ====
+// =================================================================================
+// Sem broker (porta_broker_mqtt = 0), as conexões falham e o firmware volta a tentar.
+// Com broker, o subconjunto do MQTT 3.1.1 que o firmware usa: CONNECT (com last will),
+// PUBLISH QoS 0 e 1, PUBACK, PINGREQ e DISCONNECT. Como no lwIP, no máximo
+// MQTT_REQ_MAX_IN_FLIGHT publicações QoS 1 aguardam PUBACK, e a conexão que cai só avisa
+// pelo callback de conexão (as publicações pendentes são descartadas sem callback).
+#define TAMANHO_RECEPCAO_MQTT 256
+
+typedef struct {
+    bool ocupado;
+    uint16_t id;
+    mqtt_request_cb_t callback;
+    void *arg;
+} pedido_mqtt_t;
+
+struct mqtt_client_s {
+    int socket;                        // -1 = sem conexão
+    bool aceito;                       // CONNACK recebido
+    mqtt_connection_cb_t callback;
+    void *arg;
+    uint16_t keep_alive_s;
+    uint64_t ultimo_envio_us;
+    uint16_t proximo_id;
+    pedido_mqtt_t pedidos[MQTT_REQ_MAX_IN_FLIGHT];
+    uint8_t recebidos[TAMANHO_RECEPCAO_MQTT];
+    size_t tamanho_recebidos;
+};
+
+static struct mqtt_client_s g_cliente_mqtt = {.socket = -1};
+static struct timespec g_inicio_real;
+
+static uint64_t relogio_real_us(void) {
+    struct timespec agora;
+    clock_gettime(CLOCK_MONOTONIC, &agora);
+    return (uint64_t)(agora.tv_sec - g_inicio_real.tv_sec) * 1000000u + (agora.tv_nsec - g_inicio_real.tv_nsec) / 1000;
+}
+
+double sim_inicio_monotonico_s(void) {
+    return g_inicio_real.tv_sec + g_inicio_real.tv_nsec / 1e9;
+}
+
+static size_t mqtt_escrever_tamanho(uint8_t *destino, size_t tamanho) {
+    size_t n = 0;
+    do {
+        uint8_t byte = tamanho % 128;
+        tamanho /= 128;
+        destino[n++] = byte | (tamanho ? 0x80 : 0);
+    } while (tamanho);
+    return n;
+}
+
+static size_t mqtt_escrever_texto(uint8_t *destino, const void *texto, size_t tamanho) {
+    destino[0] = (uint8_t)(tamanho >> 8);
+    destino[1] = (uint8_t)tamanho;
+    memcpy(destino + 2, texto, tamanho);
+    return tamanho + 2;
+}
+
+// Monta o pacote (cabeçalho fixo + 'corpo') e o envia inteiro, ou nada (buffer cheio)
+static err_t mqtt_enviar(mqtt_client_t *cliente, uint8_t tipo, const uint8_t *corpo, size_t tamanho) {
+    uint8_t pacote[8 + 1024];
+    if (tamanho > sizeof(pacote) - 8) return ERR_VAL;
+    pacote[0] = tipo;
+    size_t cabecalho = 1 + mqtt_escrever_tamanho(pacote + 1, tamanho);
+    memcpy(pacote + cabecalho, corpo, tamanho);
+    ssize_t enviados = send(cliente->socket, pacote, cabecalho + tamanho, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (enviados != (ssize_t)(cabecalho + tamanho)) {
+        // Um envio parcial corromperia o fluxo: não acontece com o broker local e buffers do kernel
+        if (enviados > 0) {
+            fprintf(stderr, "simulação: envio MQTT parcial\n");
+            exit(2);
+        }
+        return errno == EAGAIN || errno == EWOULDBLOCK ? ERR_MEM : ERR_CONN;
+    }
+    cliente->ultimo_envio_us = g_agora_us;
+    g_resultados.bytes_mqtt += cabecalho + tamanho;
+    radio_transmitir();
+    return ERR_OK;
+}
+
+static void mqtt_fechar(mqtt_client_t *cliente) {
+    if (cliente->socket >= 0) close(cliente->socket);
+    cliente->socket = -1;
+    cliente->aceito = false;
+    cliente->tamanho_recebidos = 0;
+    memset(cliente->pedidos, 0, sizeof(cliente->pedidos));
+}
+
+mqtt_client_t *mqtt_client_new(void) {
+    VERIFICAR_TRAVA();
+    return &g_cliente_mqtt;
+}
+
+err_t mqtt_client_connect(mqtt_client_t *cliente, const ip_addr_t *endereco, u16_t porta, mqtt_connection_cb_t callback,
+                          void *arg, const struct mqtt_connect_client_info_t *info) {
+    VERIFICAR_TRAVA();
+    if (!g_cenario.porta_broker_mqtt) return ERR_CONN;
+    if (cliente->socket >= 0) return ERR_ISCONN;
+
+    // O endereço do firmware (IP_BROKER_MQTT) é trocado pelo broker local
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in broker = {.sin_family = AF_INET, .sin_port = htons(g_cenario.porta_broker_mqtt),
+                                 .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    if (s < 0 || connect(s, (struct sockaddr *)&broker, sizeof(broker)) != 0) {
+        if (s >= 0) close(s);
+        return ERR_CONN;
+    }
+    int um = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));
+    cliente->socket = s;
+    cliente->callback = callback;
+    cliente->arg = arg;
+    cliente->keep_alive_s = info->keep_alive;
+
+    uint8_t corpo[512];
+    size_t n = mqtt_escrever_texto(corpo, "MQTT", 4);
+    corpo[n++] = 4;                                      // MQTT 3.1.1
+    uint8_t flags = 0x02;                                // Clean session
+    if (info->will_topic) flags |= 0x04 | (info->will_qos & 3) << 3 | (info->will_retain ? 0x20 : 0);
+    corpo[n++] = flags;
+    corpo[n++] = (uint8_t)(info->keep_alive >> 8);
+    corpo[n++] = (uint8_t)info->keep_alive;
+    n += mqtt_escrever_texto(corpo + n, info->client_id, strlen(info->client_id));
+    if (info->will_topic) {
+        n += mqtt_escrever_texto(corpo + n, info->will_topic, strlen(info->will_topic));
+        n += mqtt_escrever_texto(corpo + n, info->will_msg, strlen(info->will_msg));
+    }
+    if (mqtt_enviar(cliente, 0x10, corpo, n) != ERR_OK) {
+        mqtt_fechar(cliente);
+        return ERR_CONN;
+    }
+    return ERR_OK;
+}
+
+void mqtt_disconnect(mqtt_client_t *cliente) {
+    VERIFICAR_TRAVA();
+    if (cliente->socket < 0) return;
+    mqtt_enviar(cliente, 0xE0, NULL, 0);
+    mqtt_fechar(cliente);
+}
+
+err_t mqtt_publish(mqtt_client_t *cliente, const char *topico, const void *dados, u16_t tamanho, u8_t qos, u8_t reter,
+                   mqtt_request_cb_t callback, void *arg) {
+    VERIFICAR_TRAVA();
+    if (!cliente->aceito) return ERR_CONN;
+    pedido_mqtt_t *pedido = NULL;
+    if (qos > 0) {
+        for (int i = 0; i < MQTT_REQ_MAX_IN_FLIGHT && !pedido; i++) {
+            if (!cliente->pedidos[i].ocupado) pedido = &cliente->pedidos[i];
+        }
+        if (!pedido) return ERR_MEM;
+    }
+
+    uint8_t corpo[1024];
+    size_t tamanho_topico = strlen(topico);
+    if (tamanho_topico + tamanho + 4 > sizeof(corpo)) return ERR_MEM;
+    size_t n = mqtt_escrever_texto(corpo, topico, tamanho_topico);
+    uint16_t id = 0;
+    if (qos > 0) {
+        if (++cliente->proximo_id == 0) cliente->proximo_id = 1;
+        id = cliente->proximo_id;
+        corpo[n++] = (uint8_t)(id >> 8);
+        corpo[n++] = (uint8_t)id;
+    }
+    memcpy(corpo + n, dados, tamanho);
+    n += tamanho;
+    err_t erro = mqtt_enviar(cliente, 0x30 | (qos ? 0x02 : 0) | (reter ? 0x01 : 0), corpo, n);
+    if (erro != ERR_OK) return erro;
+    g_resultados.publicacoes_mqtt[qos ? 1 : 0]++;
+    if (pedido) *pedido = (pedido_mqtt_t){true, id, callback, arg};
+    return ERR_OK;
+}
+
+// Conexão caída: avisa o firmware pelo callback, como o lwIP
+static void mqtt_conexao_perdida(mqtt_client_t *cliente) {
+    bool estava_aceito = cliente->aceito;
+    mqtt_fechar(cliente);
+    cliente->callback(cliente, cliente->arg, estava_aceito ? MQTT_CONNECT_DISCONNECTED : MQTT_CONNECT_REFUSED_SERVER);
+}
+
+// Um pacote completo do broker (já sem o cabeçalho fixo)
+static void mqtt_tratar_pacote(mqtt_client_t *cliente, uint8_t tipo, const uint8_t *corpo, size_t tamanho) {
+    switch (tipo >> 4) {
+    case 2: // CONNACK
+        if (tamanho >= 2 && corpo[1] == 0) {
+            cliente->aceito = true;
+            g_resultados.conexoes_mqtt++;
+            registrar_conexao_aceita();
+            cliente->callback(cliente, cliente->arg, MQTT_CONNECT_ACCEPTED);
+        } else {
+            mqtt_fechar(cliente);
+            cliente->callback(cliente, cliente->arg, tamanho >= 2 ? corpo[1] : MQTT_CONNECT_REFUSED_SERVER);
+        }
+        break;
+    case 4: // PUBACK
+        if (tamanho < 2) break;
+        for (int i = 0; i < MQTT_REQ_MAX_IN_FLIGHT; i++) {
+            pedido_mqtt_t *pedido = &cliente->pedidos[i];
+            if (pedido->ocupado && pedido->id == (corpo[0] << 8 | corpo[1])) {
+                pedido->ocupado = false;
+                g_resultados.pubacks_mqtt++;
+                if (pedido->callback) pedido->callback(pedido->arg, ERR_OK);
+                break;
+            }
+        }
+        break;
+    default: // PINGRESP e o que mais vier
+        break;
+    }
+}
+
+// O broker fecha a conexão no instante do cenário, como a queda vista pelo mqtt_receber
+static void mqtt_fechamento_pelo_broker(void) {
+    mqtt_client_t *cliente = &g_cliente_mqtt;
+    if (!cliente->aceito || g_servidor_fechou || g_agora_us < instante_fechamento_us()) return;
+    registrar_fechamento();
+    g_em_irq = true;
+    mqtt_conexao_perdida(cliente);
+    g_em_irq = false;
+}
+
+// O que chegou do broker, tratado como a interrupção do lwIP (com o relógio no instante atual)
+static void mqtt_receber(mqtt_client_t *cliente) {
+    ssize_t lidos = recv(cliente->socket, cliente->recebidos + cliente->tamanho_recebidos,
+                         sizeof(cliente->recebidos) - cliente->tamanho_recebidos, MSG_DONTWAIT);
+    if (lidos < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+    g_em_irq = true;
+    if (lidos <= 0) {
+        mqtt_conexao_perdida(cliente);
+        g_em_irq = false;
+        return;
+    }
+    radio_pacote(g_agora_us);
+    g_resultados.pacotes_rx++;
+    cliente->tamanho_recebidos += lidos;
+    size_t posicao = 0;
+    while (cliente->socket >= 0 && cliente->tamanho_recebidos - posicao >= 2) {
+        const uint8_t *pacote = cliente->recebidos + posicao;
+        size_t disponivel = cliente->tamanho_recebidos - posicao;
+        size_t tamanho = 0, cabecalho = 1;
+        for (int multiplicador = 1; cabecalho < disponivel; multiplicador *= 128) {
+            tamanho += (pacote[cabecalho] & 0x7F) * multiplicador;
+            if (!(pacote[cabecalho++] & 0x80)) break;
+        }
+        if (cabecalho + tamanho > disponivel) break; // Pacote incompleto
+        mqtt_tratar_pacote(cliente, pacote[0], pacote + cabecalho, tamanho);
+        posicao += cabecalho + tamanho;
+    }
+    if (cliente->socket >= 0) {
+        memmove(cliente->recebidos, cliente->recebidos + posicao, cliente->tamanho_recebidos - posicao);
+        cliente->tamanho_recebidos -= posicao;
+    }
+    g_em_irq = false;
+}
+
+// Com broker: espera o relógio real chegar a t_us, atendendo o socket do MQTT no instante
+// em que algo chega. O keep alive (PINGREQ) também sai daqui, como o temporizador do lwIP.
+static void tempo_real_esperar_ate(uint64_t t_us) {
+    mqtt_client_t *cliente = &g_cliente_mqtt;
+    while (true) {
+        uint64_t real = relogio_real_us();
+        if (real >= t_us) {
+            if (real - t_us > g_resultados.atraso_tempo_real_us) g_resultados.atraso_tempo_real_us = real - t_us;
+            return;
+        }
+        if (cliente->aceito && cliente->keep_alive_s &&
+            g_agora_us - cliente->ultimo_envio_us >= (uint64_t)cliente->keep_alive_s * 1000000u) {
+            mqtt_enviar(cliente, 0xC0, NULL, 0);
+        }
+        if (cliente->socket < 0) {
+            struct timespec espera = {(t_us - real) / 1000000u, (t_us - real) % 1000000u * 1000};
+            nanosleep(&espera, NULL);
+            continue;
+        }
+        struct pollfd pfd = {.fd = cliente->socket, .events = POLLIN};
+        if (poll(&pfd, 1, (int)((t_us - real + 999) / 1000)) > 0) {
+            real = relogio_real_us();
+            uint64_t instante = real < t_us ? real : t_us;
+            if (instante > g_agora_us) {
+                radio_contabilizar_modo_ate(instante);
+                radio_processar_beacons_ate(instante);
+                g_agora_us = instante;
+            }
+            mqtt_receber(cliente);
+        }
+    }
+}
+
+// =================================================================================
+// ==== EXECUÇÃO ====
+// =================================================================================
+bool sim_executar(void) {
+    flash_mapear();
+    if (g_cenario.semente) g_semente = g_cenario.semente;
+    clock_gettime(CLOCK_MONOTONIC, &g_inicio_real);
+    g_fim_us = (uint64_t)g_cenario.duracao_s * 1000000u;
+    if (setjmp(g_fim_simulacao) == 0) {
+        firmware_main();
+        return false;
+    }
+    radio_contabilizar_modo_ate(g_agora_us);
+    g_resultados.tempo_us = g_agora_us;
+    return true;
+}
@@ -0,0 +1,108 @@
+// plataforma.h
+// Simulação do rosaDosVentosWEB.c no computador: o firmware é compilado sem alterações
+// sobre o sdk_falso/, com um relógio virtual em microssegundos. O tempo só anda quando o
+// firmware dorme ou espera (sleep_us, sleep_ms, ...); os callbacks do lwIP (ACKs, conexão
+// estabelecida) rodam nesses momentos, como a interrupção do modo threadsafe_background.
+//
+// Modelo do rádio: os pacotes recebidos só chegam com o CYW43 acordado. Em
+// CYW43_PERFORMANCE_PM (PM2) ele fica acordado até 200ms depois do último pacote; em
+// CYW43_AGGRESSIVE_PM (PM1) acorda só para transmitir e, nos beacons, para buscar o que o
+// ponto de acesso guardou. Os tempos do modelo estão em plataforma.c.
+//
+// O cliente MQTT do lwIP é simulado sobre um socket de verdade até um broker em
+// 127.0.0.1:porta_broker_mqtt (MQTT 3.1.1, sem broker = as conexões falham). Com um
+// broker, o relógio virtual acompanha o real, para que os tempos medidos por outros
+// processos (assinantes, o próprio broker) façam sentido.
+//
+// Perda e atraso no caminho até o servidor: cada pacote de dados (segmento TCP ou
+// datagrama UDP) se perde com probabilidade perda_por_mil / 1000 e, entregue, leva meio
+// RTT mais um atraso sorteado entre 0 e variacao_atraso_ms. O TCP reenvia o segmento
+// perdido depois do RTO (dobrando a cada perda) e entrega o fluxo em ordem: os segmentos
+// seguintes esperam o perdido (bloqueio na cabeça da fila), e o ACK só sai depois disso.
+// O UDP só perde. O que chega à aplicação do servidor é passado a g_cenario.entregue.
+//
+// Fechamento pelo servidor: em fechamento_servidor_s, o servidor (ou o broker MQTT) fecha
+// a conexão da placa, uma vez, como num servidor.py reiniciado (no TCP, o FIN chega como
+// um tcp_recv com pbuf NULL). Se nenhuma estiver aberta nesse instante, fecha a próxima
+// que abrir. reconexao_us é o tempo até a conexão seguinte ser aceita. Com semente, cada
+// execução sorteia diferente no get_rand_32, como placas diferentes.
+//
+// O printf custa tempo, como o stdio USB da placa: custo_printf_us por chamada mais
+// custo_printf_us_por_byte por byte escrito (0 e 0 = de graça).
+//
+// Como no modo threadsafe_background, o loop principal só pode chamar o lwIP entre
+// cyw43_arch_lwip_begin() e cyw43_arch_lwip_end(); cada chamada fora disso é contada em
+// chamadas_lwip_sem_trava (e a primeira de cada função é mostrada).
+#ifndef PLATAFORMA_H
+#define PLATAFORMA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Parâmetros do cenário, com valores padrão em plataforma.c; ajustar antes de sim_executar()
+typedef struct {
+    uint32_t duracao_s;          // Tempo virtual simulado
+    uint32_t rtt_ms;             // Ida e volta até o servidor
+    uint32_t associacao_ms;      // Tempo do connect_async até o enlace (CYW43_LINK_JOIN)
+    uint32_t dhcp_ms;            // Do enlace até o IP (CYW43_LINK_UP)
+    uint32_t queda_enlace_s;     // Instante de uma queda do Wi-Fi (0 = sem queda)
+    uint32_t duracao_queda_ms;   // ... e quanto tempo o ponto de acesso fica fora do ar
+    uint32_t perda_por_mil;      // Pacotes de dados perdidos até o servidor, por mil (TCP e UDP)
+    uint32_t variacao_atraso_ms; // Atraso extra de cada pacote, sorteado entre 0 e isto
+    uint32_t fechamento_servidor_s; // Instante em que o servidor fecha a conexão (0 = nunca)
+    uint32_t semente;            // Semente do get_rand_32 (0 = padrão)
+    bool verboso;                // Mostra toda a saída do firmware (senão, só os relatórios "[...]")
+    uint32_t custo_printf_us;          // Tempo de cada printf (formatação, trava do stdio)
+    uint32_t custo_printf_us_por_byte; // ... mais isto por byte escrito
+    uint16_t porta_broker_mqtt;  // Broker MQTT em 127.0.0.1 (0 = sem broker)
+    const char *id_placa;        // pico_get_unique_board_id_string (NULL = padrão)
+    // Posição do joystick e botões pressionados no instante t (NULL = padrão do cenário)
+    void (*joystick)(uint64_t t_us, uint16_t *x, uint16_t *y);
+    bool (*botao)(uint64_t t_us, unsigned pino);
+    // Dados entregues à aplicação do servidor no instante t: cada datagrama UDP e o fluxo
+    // TCP, em ordem, um segmento por chamada (NULL = descartados)
+    void (*entregue)(uint64_t t_us, bool tcp, const char *dados, uint16_t tamanho);
+} cenario_t;
+
+extern cenario_t g_cenario;
+
+// Resultados acumulados durante a simulação
+typedef struct {
+    uint64_t tempo_us;
+    uint64_t tempo_desempenho_us;    // Tempo com CYW43_PERFORMANCE_PM ligado
+    uint64_t tempo_acordado_us;      // Rádio acordado, segundo o modelo (inclui os beacons)
+    uint32_t trocas_modo_pm;
+    uint32_t pacotes_tx;
+    uint32_t pacotes_rx;
+    uint32_t conexoes_tcp;
+    uint64_t reconexao_us;           // Do fechamento pelo servidor até a conexão seguinte (0 = não voltou)
+    uint32_t escritas_tcp;
+    uint64_t bytes_tcp_escritos;
+    uint64_t bytes_tcp_confirmados;
+    uint32_t datagramas_udp;
+    uint32_t pacotes_perdidos;       // Segmentos TCP (cada tentativa) e datagramas UDP
+    uint32_t retransmissoes_tcp;
+    uint64_t bytes_printf;
+    uint64_t tempo_printf_us;        // Tempo gasto no printf (modelo de custo acima)
+    uint32_t conexoes_mqtt;          // CONNACK aceitos
+    uint32_t publicacoes_mqtt[2];    // Por QoS (0 e 1)
+    uint64_t bytes_mqtt;             // Pacotes MQTT enviados ao broker, com cabeçalhos
+    uint32_t pubacks_mqtt;
+    uint64_t atraso_tempo_real_us;   // Maior atraso do relógio virtual em relação ao real
+    uint32_t chamadas_lwip_sem_trava; // Chamadas ao lwIP fora de um callback e sem cyw43_arch_lwip_begin
+} resultados_sim_t;
+
+extern resultados_sim_t g_resultados;
+
+// main() do firmware, renomeada na compilação (-Dmain=firmware_main)
+int firmware_main(void);
+
+// Executa o firmware até g_cenario.duracao_s de tempo virtual. Retorna false se ele terminou antes.
+bool sim_executar(void);
+
+uint64_t sim_agora_us(void);
+
+// Com broker: instante (CLOCK_MONOTONIC, em segundos) que corresponde ao tempo virtual 0
+double sim_inicio_monotonico_s(void);
+
+#endif // PLATAFORMA_H
@@ -0,0 +1 @@
+#include "sdk_falso.h"
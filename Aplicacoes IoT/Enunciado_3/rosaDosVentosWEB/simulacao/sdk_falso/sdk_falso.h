@@ -0,0 +1,221 @@
+// sdk_falso.h
+// Declarações do Pico SDK, do driver CYW43 e do lwIP usadas pelo rosaDosVentosWEB.c,
+// implementadas em plataforma.c sobre um relógio virtual. Todos os cabeçalhos desta
+// pasta (pico/stdlib.h, lwip/tcp.h, ...) apenas incluem este arquivo.
+#ifndef SDK_FALSO_H
+#define SDK_FALSO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+#include "lwipopts.h"
+
+// --- Tipos básicos ---
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+typedef int8_t err_t;
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+
+// --- Saída padrão: passa pelo relógio virtual (custo da impressão) ---
+#ifndef PLATAFORMA_SIMULADA
+int sim_printf(const char *formato, ...) __attribute__((format(printf, 1, 2)));
+#define printf sim_printf
+#endif
+
+// --- pico/stdlib, pico/time ---
+bool stdio_init_all(void);
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+void busy_wait_us(uint64_t us);
+void busy_wait_ms(uint32_t ms);
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
+absolute_time_t get_absolute_time(void);
+uint32_t to_ms_since_boot(absolute_time_t t);
+static inline void tight_loop_contents(void) {}
+#define PICO_OK 0
+
+// --- hardware/gpio, hardware/adc ---
+#define GPIO_OUT 1
+#define GPIO_IN 0
+void gpio_init(uint pino);
+void gpio_set_dir(uint pino, bool saida);
+void gpio_put(uint pino, bool valor);
+bool gpio_get(uint pino);
+void gpio_pull_up(uint pino);
+void adc_init(void);
+void adc_gpio_init(uint pino);
+void adc_select_input(uint canal);
+uint16_t adc_read(void);
+
+// --- pico/rand, pico/unique_id ---
+uint32_t get_rand_32(void);
+#define PICO_UNIQUE_BOARD_ID_SIZE_BYTES 8
+void pico_get_unique_board_id_string(char *id, uint tamanho);
+
+// --- hardware/flash, pico/flash (a flash fica mapeada em XIP_BASE, como na placa) ---
+#define XIP_BASE 0x10000000u
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+#define FLASH_SECTOR_SIZE 4096u
+#define FLASH_PAGE_SIZE 256u
+void flash_range_erase(uint32_t deslocamento, size_t tamanho);
+void flash_range_program(uint32_t deslocamento, const uint8_t *dados, size_t tamanho);
+int flash_safe_execute(void (*funcao)(void *), void *parametro, uint32_t timeout_ms);
+
+// --- lwIP: códigos de erro ---
+#define ERR_OK 0
+#define ERR_MEM -1
+#define ERR_BUF -2
+#define ERR_TIMEOUT -3
+#define ERR_RTE -4
+#define ERR_INPROGRESS -5
+#define ERR_VAL -6
+#define ERR_WOULDBLOCK -7
+#define ERR_USE -8
+#define ERR_ALREADY -9
+#define ERR_ISCONN -10
+#define ERR_CONN -11
+#define ERR_IF -12
+#define ERR_ABRT -13
+#define ERR_RST -14
+#define ERR_CLSD -15
+#define ERR_ARG -16
+
+// --- lwIP: endereços e netif ---
+typedef struct { uint32_t addr; } ip4_addr_t;
+typedef ip4_addr_t ip_addr_t;
+#define IPADDR_TYPE_V4 0
+#define IPADDR_TYPE_ANY 46
+#define IP_GET_TYPE(endereco) IPADDR_TYPE_V4
+#define ip4_addr_get_u32(endereco) ((endereco)->addr)
+#define ip4_addr_set_u32(endereco, valor) ((endereco)->addr = (valor))
+char *ip4addr_ntoa(const ip4_addr_t *endereco);
+char *ipaddr_ntoa(const ip_addr_t *endereco);
+int ipaddr_aton(const char *texto, ip_addr_t *endereco);
+
+struct netif;
+typedef void (*netif_status_callback_fn)(struct netif *netif);
+struct netif {
+    ip4_addr_t ip_addr;
+    ip4_addr_t netmask;
+    ip4_addr_t gw;
+    netif_status_callback_fn status_callback;
+    netif_status_callback_fn link_callback;
+};
+extern struct netif *netif_default;
+#define netif_ip4_addr(n) ((const ip4_addr_t *)&(n)->ip_addr)
+#define netif_ip4_netmask(n) ((const ip4_addr_t *)&(n)->netmask)
+#define netif_ip4_gw(n) ((const ip4_addr_t *)&(n)->gw)
+void netif_set_status_callback(struct netif *netif, netif_status_callback_fn callback);
+void netif_set_link_callback(struct netif *netif, netif_status_callback_fn callback);
+void netif_set_addr(struct netif *netif, const ip4_addr_t *ip, const ip4_addr_t *mascara, const ip4_addr_t *gateway);
+
+// --- lwIP: pbuf ---
+#define PBUF_TRANSPORT 0
+#define PBUF_RAM 0
+struct pbuf {
+    struct pbuf *next;
+    void *payload;
+    u16_t tot_len;
+    u16_t len;
+};
+struct pbuf *pbuf_alloc(int camada, u16_t tamanho, int tipo);
+u8_t pbuf_free(struct pbuf *p);
+u16_t pbuf_copy_partial(const struct pbuf *p, void *destino, u16_t tamanho, u16_t deslocamento);
+
+// --- lwIP: TCP ---
+#define TCP_WRITE_FLAG_COPY 0x01
+#define TCP_WRITE_FLAG_MORE 0x02
+struct tcp_pcb;
+typedef err_t (*tcp_connected_fn)(void *arg, struct tcp_pcb *pcb, err_t erro);
+typedef err_t (*tcp_sent_fn)(void *arg, struct tcp_pcb *pcb, u16_t tamanho);
+typedef err_t (*tcp_recv_fn)(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t erro);
+typedef void (*tcp_err_fn)(void *arg, err_t erro);
+struct tcp_pcb *tcp_new_ip_type(u8_t tipo);
+void tcp_arg(struct tcp_pcb *pcb, void *arg);
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn callback);
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn callback);
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn callback);
+err_t tcp_connect(struct tcp_pcb *pcb, const ip_addr_t *endereco, u16_t porta, tcp_connected_fn callback);
+err_t tcp_write(struct tcp_pcb *pcb, const void *dados, u16_t tamanho, u8_t flags);
+err_t tcp_output(struct tcp_pcb *pcb);
+err_t tcp_close(struct tcp_pcb *pcb);
+void tcp_abort(struct tcp_pcb *pcb);
+void tcp_recved(struct tcp_pcb *pcb, u16_t tamanho);
+
+// --- lwIP: UDP ---
+struct udp_pcb;
+struct udp_pcb *udp_new(void);
+err_t udp_sendto(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *endereco, u16_t porta);
+
+// --- lwIP: cliente MQTT (apps/mqtt.h) ---
+typedef struct mqtt_client_s mqtt_client_t;
+typedef enum {
+    MQTT_CONNECT_ACCEPTED = 0,
+    MQTT_CONNECT_REFUSED_PROTOCOL_VERSION = 1,
+    MQTT_CONNECT_REFUSED_IDENTIFIER = 2,
+    MQTT_CONNECT_REFUSED_SERVER = 3,
+    MQTT_CONNECT_REFUSED_USERNAME_PASS = 4,
+    MQTT_CONNECT_REFUSED_NOT_AUTHORIZED_ = 5,
+    MQTT_CONNECT_DISCONNECTED = 256,
+    MQTT_CONNECT_TIMEOUT = 257
+} mqtt_connection_status_t;
+typedef void (*mqtt_connection_cb_t)(mqtt_client_t *cliente, void *arg, mqtt_connection_status_t status);
+typedef void (*mqtt_request_cb_t)(void *arg, err_t erro);
+struct mqtt_connect_client_info_t {
+    const char *client_id;
+    const char *client_user;
+    const char *client_pass;
+    u16_t keep_alive;
+    const char *will_topic;
+    const char *will_msg;
+    u8_t will_qos;
+    u8_t will_retain;
+};
+mqtt_client_t *mqtt_client_new(void);
+err_t mqtt_client_connect(mqtt_client_t *cliente, const ip_addr_t *endereco, u16_t porta, mqtt_connection_cb_t callback,
+                          void *arg, const struct mqtt_connect_client_info_t *info);
+void mqtt_disconnect(mqtt_client_t *cliente);
+err_t mqtt_publish(mqtt_client_t *cliente, const char *topico, const void *dados, u16_t tamanho, u8_t qos, u8_t reter,
+                   mqtt_request_cb_t callback, void *arg);
+
+// --- CYW43 ---
+typedef struct { int itf_state; } cyw43_t;
+extern cyw43_t cyw43_state;
+#define CYW43_ITF_STA 0
+#define CYW43_AUTH_WPA2_AES_PSK 0x00400004
+// Mesmos valores do cyw43-driver: PERFORMANCE = PM2 (volta a dormir 200ms após o
+// último pacote); AGGRESSIVE = PM1 (dorme entre beacons e acorda a cada pacote)
+#define CYW43_NO_POWERSAVE_MODE 0
+#define CYW43_PM1_POWERSAVE_MODE 1
+#define CYW43_PM2_POWERSAVE_MODE 2
+#define cyw43_pm_value(modo, retorno_ms, li_beacon, li_dtim, li_assoc) \
+    ((li_assoc) << 20 | (li_dtim) << 16 | (li_beacon) << 12 | ((retorno_ms) / 10) << 4 | (modo))
+#define CYW43_AGGRESSIVE_PM cyw43_pm_value(CYW43_PM1_POWERSAVE_MODE, 10, 0, 0, 0)
+#define CYW43_PERFORMANCE_PM cyw43_pm_value(CYW43_PM2_POWERSAVE_MODE, 200, 1, 1, 10)
+#define CYW43_DEFAULT_PM CYW43_PERFORMANCE_PM
+#define CYW43_LINK_DOWN 0
+#define CYW43_LINK_JOIN 1
+#define CYW43_LINK_NOIP 2
+#define CYW43_LINK_UP 3
+#define CYW43_LINK_FAIL -1
+#define CYW43_LINK_NONET -2
+#define CYW43_LINK_BADAUTH -3
+int cyw43_arch_init(void);
+void cyw43_arch_enable_sta_mode(void);
+void cyw43_arch_lwip_begin(void);
+void cyw43_arch_lwip_end(void);
+int cyw43_arch_wifi_connect_async(const char *ssid, const char *senha, uint32_t autenticacao);
+int cyw43_arch_wifi_connect_bssid_async(const char *ssid, const uint8_t *bssid, const char *senha, uint32_t autenticacao);
+int cyw43_wifi_leave(cyw43_t *estado, int itf);
+int cyw43_wifi_pm(cyw43_t *estado, uint32_t modo);
+int cyw43_wifi_get_bssid(cyw43_t *estado, uint8_t bssid[6]);
+int cyw43_tcpip_link_status(cyw43_t *estado, int itf);
+
+#endif // SDK_FALSO_H
@@ -0,0 +1,82 @@
+// sim_mqtt.c
+// O firmware com TRANSPORTE_MQTT = 1 publicando em um broker MQTT de verdade (em
+// 127.0.0.1), com o relógio virtual acompanhando o real (ver plataforma.h):
+//     sim_mqtt [porta do broker] [segundos] [id da placa]      (porta 0 = sem broker)
+// Usado pela bancada/bancada_mqtt.py (várias placas, assinante, latência); sozinho, sem
+// broker, confere que o firmware continua tentando e não chama o lwIP sem a trava.
+//
+// Cenário: o joystick anda LIMIAR_MUDANCA_ADC a cada leitura de 10ms, de modo que o VRX
+// publicado diz quando a posição foi lida: VRX = 64 * ((t_ms / 10) % 64). O botão A é
+// pressionado a cada 2s, (7 * k) % 50 ms depois do início do k-ésimo período (para cair
+// em pontos diferentes da varredura de 50ms dos botões), e solto 200ms depois.
+// O DHT11 é o padrão da plataforma.
+// O fonte do firmware é incluído aqui para ter acesso ao tamanho do publicador.
+#include "plataforma.h"
+
+#define main firmware_main
+#include "rosaDosVentosWEB.c"
+#undef main
+#undef printf
+
+#include <string.h>
+
+#define PERIODO_BOTAO_A_US 2000000u
+#define DURACAO_BOTAO_A_US 200000u
+#define PASSO_BOTAO_A_US 7000u
+#define VARREDURA_BOTOES_US 50000u
+
+static void joystick_relogio(uint64_t t_us, uint16_t *x, uint16_t *y) {
+    *x = (uint16_t)(LIMIAR_MUDANCA_ADC * ((t_us / 10000u) % 64));
+    *y = 2048;
+}
+
+static bool botao_a_periodico(uint64_t t_us, unsigned pino) {
+    uint64_t k = t_us / PERIODO_BOTAO_A_US;
+    uint64_t apertado = k * PERIODO_BOTAO_A_US + k * PASSO_BOTAO_A_US % VARREDURA_BOTOES_US;
+    return pino == PINO_BOTAO_A && t_us >= apertado && t_us < apertado + DURACAO_BOTAO_A_US;
+}
+
+int main(int argc, char **argv) {
+    g_cenario.porta_broker_mqtt = argc > 1 ? (uint16_t)atoi(argv[1]) : 0;
+    g_cenario.duracao_s = argc > 2 ? (uint32_t)atoi(argv[2]) : 60;
+    g_cenario.id_placa = argc > 3 ? argv[3] : NULL;
+    g_cenario.joystick = joystick_relogio;
+    g_cenario.botao = botao_a_periodico;
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    // Os ponteiros do host têm 8 bytes; na placa, 4 (cliente e os 5 textos do info)
+    size_t publicador_placa = sizeof(publicador_mqtt_t) - 6 * (sizeof(void *) - 4);
+    printf("[SIM] memoria do publicador=%zu bytes (host), ~%zu bytes na placa; cliente MQTT do lwIP: "
+           "buffer de saida=%u bytes, %u publicacoes QoS 1 em voo\n",
+           sizeof(publicador_mqtt_t), publicador_placa, (unsigned)MQTT_OUTPUT_RINGBUF_SIZE,
+           (unsigned)MQTT_REQ_MAX_IN_FLIGHT);
+
+    if (!sim_executar()) {
+        fprintf(stderr, "O firmware terminou antes do fim da simulação\n");
+        return 1;
+    }
+
+    const resultados_sim_t *r = &g_resultados;
+    printf("[SIM] inicio=%.6f placa=%s\n", sim_inicio_monotonico_s(), g_mqtt.id_placa);
+    printf("[SIM] conexoes=%u publicacoes qos0=%u qos1=%u pubacks=%u bytes=%llu atraso max do relogio=%.2f ms\n",
+           r->conexoes_mqtt, r->publicacoes_mqtt[0], r->publicacoes_mqtt[1], r->pubacks_mqtt,
+           (unsigned long long)r->bytes_mqtt, r->atraso_tempo_real_us / 1e3);
+
+    if (r->chamadas_lwip_sem_trava) {
+        fprintf(stderr, "Chamadas ao lwIP sem a trava: %u\n", r->chamadas_lwip_sem_trava);
+        return 1;
+    }
+    if (!g_cenario.porta_broker_mqtt) {
+        return r->publicacoes_mqtt[0] + r->publicacoes_mqtt[1] == 0 ? 0 : 1;
+    }
+    if (r->conexoes_mqtt == 0 || r->publicacoes_mqtt[0] == 0) {
+        fprintf(stderr, "Nada publicado no broker\n");
+        return 1;
+    }
+    // Todo QoS 1 confirmado, menos a janela que estava em voo no fim
+    if (r->publicacoes_mqtt[1] - r->pubacks_mqtt > JANELA_QOS1_MQTT) {
+        fprintf(stderr, "Publicações QoS 1 sem PUBACK: %u\n", r->publicacoes_mqtt[1] - r->pubacks_mqtt);
+        return 1;
+    }
+    return 0;
+}
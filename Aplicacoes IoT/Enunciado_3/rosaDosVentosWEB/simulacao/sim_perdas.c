@@ -0,0 +1,197 @@
+// sim_perdas.c
+// Idade da posição do joystick no servidor com perda e atraso no caminho (ver plataforma.h),
+// para o transporte escolhido na compilação (TRANSPORTE_JOYSTICK_UDP, ver CMakeLists.txt):
+//     sim_perdas [perda em %] [RTT em ms] [variação do atraso em ms]   (padrão: 5 40 0)
+// Cenário: o joystick muda a cada leitura de 10ms e a posição diz quando foi lida,
+// VRX = 64 * ((t_ms / 10) % 64) e VRY = 64 * ((t_ms / 640) % 64) (um ciclo de 40,96s);
+// o botão A é pressionado a cada 2s, (7 * k) % 50 ms depois do início do k-ésimo período,
+// e solto 200ms depois. O lote do TCP sai a cada amostra (LATENCIA_MAXIMA_MS = 0), para
+// que a diferença entre os transportes seja só a da rede.
+// Relata, em ms:
+//   - idade na entrega: do instante da leitura até a chegada ao servidor, por posição;
+//   - idade da seta: idade da posição mais recente que o servidor tem (descartando, como o
+//     servidor.py, datagramas com SEQ não maior que o último), a cada 10ms;
+//   - botão A: da mudança do botão até a chegada ao servidor da linha TCP com o novo estado.
+// Falha se o lwIP for chamado sem a trava, se o fluxo TCP chegar incompleto ou, no UDP, se
+// alguma posição entregue tiver mais que meio RTT + a variação + dois períodos do joystick.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "plataforma.h"
+
+#ifndef TRANSPORTE_JOYSTICK_UDP
+#error "Defina TRANSPORTE_JOYSTICK_UDP (transporte simulado)"
+#endif
+
+#define PERIODO_JOYSTICK_US 10000u       // PERIODO_JOYSTICK_MS do firmware
+#define POSICOES_NO_CICLO 64u
+#define CICLO_JOYSTICK_US ((uint64_t)PERIODO_JOYSTICK_US * POSICOES_NO_CICLO * POSICOES_NO_CICLO)
+#define PINO_BOTAO_A 5
+#define PERIODO_BOTAO_A_US 2000000u
+#define DURACAO_BOTAO_A_US 200000u
+#define PASSO_BOTAO_A_US 7000u
+#define VARREDURA_BOTOES_US 50000u
+#define MAX_AMOSTRAS 200000
+
+typedef struct {
+    uint32_t *valores;
+    size_t quantidade;
+} amostras_t;
+
+static void amostras_adicionar(amostras_t *a, uint64_t valor_us) {
+    if (!a->valores) a->valores = malloc(MAX_AMOSTRAS * sizeof(uint32_t));
+    if (a->quantidade < MAX_AMOSTRAS) a->valores[a->quantidade++] = (uint32_t)valor_us;
+}
+
+static int comparar_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentil_ms(amostras_t *a, double p) {
+    if (a->quantidade == 0) return 0.0;
+    qsort(a->valores, a->quantidade, sizeof(uint32_t), comparar_u32);
+    size_t i = (size_t)(p * a->quantidade);
+    return a->valores[i < a->quantidade ? i : a->quantidade - 1] / 1e3;
+}
+
+static amostras_t g_idade_entrega;    // Por posição entregue
+static amostras_t g_idade_botao;      // Por mudança do botão A entregue
+static amostras_t g_entregas_seta;    // Instantes em que a seta mudou (us; 32 bits bastam para ~70 min)...
+static amostras_t g_leituras_seta;    // ... e a leitura que ela passou a mostrar
+static uint32_t g_ultima_sequencia;
+static uint64_t g_bytes_tcp_entregues;
+static int g_ultimo_botao_a = -1;
+
+static void joystick_relogio(uint64_t t_us, uint16_t *x, uint16_t *y) {
+    *x = (uint16_t)(64 * ((t_us / PERIODO_JOYSTICK_US) % POSICOES_NO_CICLO));
+    *y = (uint16_t)(64 * ((t_us / (PERIODO_JOYSTICK_US * POSICOES_NO_CICLO)) % POSICOES_NO_CICLO));
+}
+
+static bool botao_a_periodico(uint64_t t_us, unsigned pino) {
+    uint64_t k = t_us / PERIODO_BOTAO_A_US;
+    uint64_t apertado = k * PERIODO_BOTAO_A_US + k * PASSO_BOTAO_A_US % VARREDURA_BOTOES_US;
+    return pino == PINO_BOTAO_A && t_us >= apertado && t_us < apertado + DURACAO_BOTAO_A_US;
+}
+
+// Último instante, até t, em que o botão A foi pressionado (pressionado) ou solto
+static uint64_t mudanca_botao_a(uint64_t t_us, bool pressionado) {
+    uint64_t deslocamento = pressionado ? 0 : DURACAO_BOTAO_A_US;
+    for (int64_t k = (int64_t)(t_us / PERIODO_BOTAO_A_US); k >= 0; k--) {
+        uint64_t instante = k * PERIODO_BOTAO_A_US + k * PASSO_BOTAO_A_US % VARREDURA_BOTOES_US + deslocamento;
+        if (instante <= t_us) return instante;
+    }
+    return 0;
+}
+
+// Última leitura, até t, que deu a posição (x, y)
+static uint64_t instante_leitura(uint64_t t_us, unsigned x, unsigned y) {
+    uint64_t no_ciclo = ((uint64_t)(y / 64) * POSICOES_NO_CICLO + x / 64 % POSICOES_NO_CICLO) * PERIODO_JOYSTICK_US;
+    uint64_t inicio = t_us - t_us % CICLO_JOYSTICK_US;
+    if (inicio + no_ciclo > t_us) {
+        if (inicio < CICLO_JOYSTICK_US) return 0;
+        inicio -= CICLO_JOYSTICK_US;
+    }
+    return inicio + no_ciclo;
+}
+
+static void registrar_posicao(uint64_t t_us, unsigned x, unsigned y, bool atualiza_seta) {
+    uint64_t leitura = instante_leitura(t_us, x, y);
+    amostras_adicionar(&g_idade_entrega, t_us - leitura);
+    if (atualiza_seta) {
+        amostras_adicionar(&g_entregas_seta, t_us);
+        amostras_adicionar(&g_leituras_seta, leitura);
+    }
+}
+
+static void entregue(uint64_t t_us, bool tcp, const char *dados, uint16_t tamanho) {
+    if (tcp) g_bytes_tcp_entregues += tamanho;
+    char texto[1200];
+    if (tamanho >= sizeof(texto)) tamanho = sizeof(texto) - 1;
+    memcpy(texto, dados, tamanho);
+    texto[tamanho] = '\0';
+
+    char *contexto_linha;
+    for (char *linha = strtok_r(texto, "\n", &contexto_linha); linha; linha = strtok_r(NULL, "\n", &contexto_linha)) {
+        const char *vrx = strstr(linha, "VRX="), *vry = strstr(linha, "VRY=");
+        const char *seq = strstr(linha, "SEQ="), *a = strstr(linha, " A=");
+        if (vrx && vry) {
+            unsigned x = (unsigned)atoi(vrx + 4), y = (unsigned)atoi(vry + 4);
+            // Como o servidor.py: só atualiza a seta com sequência nova (o TCP já chega em ordem)
+            uint32_t sequencia = seq ? (uint32_t)strtoul(seq + 4, NULL, 10) : 0;
+            bool nova = !seq || sequencia == 1 || sequencia > g_ultima_sequencia;
+            if (seq && nova) g_ultima_sequencia = sequencia;
+            registrar_posicao(t_us, x, y, nova);
+        }
+        if (a) {
+            int estado = atoi(a + 3);
+            if (g_ultimo_botao_a >= 0 && estado != g_ultimo_botao_a) {
+                amostras_adicionar(&g_idade_botao, t_us - mudanca_botao_a(t_us, estado == 1));
+            }
+            g_ultimo_botao_a = estado;
+        }
+    }
+}
+
+// Idade da posição mostrada pela seta a cada 10ms, da primeira entrega até o fim
+static void amostrar_seta(amostras_t *idades, uint64_t fim_us) {
+    if (g_entregas_seta.quantidade == 0) return;
+    size_t atual = 0;
+    for (uint64_t t = g_entregas_seta.valores[0]; t < fim_us; t += PERIODO_JOYSTICK_US) {
+        while (atual + 1 < g_entregas_seta.quantidade && g_entregas_seta.valores[atual + 1] <= t) atual++;
+        amostras_adicionar(idades, t - g_leituras_seta.valores[atual]);
+    }
+}
+
+int main(int argc, char **argv) {
+    double perda_pct = argc > 1 ? atof(argv[1]) : 5.0;
+    g_cenario.perda_por_mil = (uint32_t)(perda_pct * 10 + 0.5);
+    if (argc > 2) g_cenario.rtt_ms = (uint32_t)atoi(argv[2]);
+    if (argc > 3) g_cenario.variacao_atraso_ms = (uint32_t)atoi(argv[3]);
+    g_cenario.joystick = joystick_relogio;
+    g_cenario.botao = botao_a_periodico;
+    g_cenario.entregue = entregue;
+
+    if (!sim_executar()) {
+        fprintf(stderr, "O firmware terminou antes do fim da simulação\n");
+        return 1;
+    }
+
+    const resultados_sim_t *r = &g_resultados;
+    amostras_t idade_seta = {0};
+    amostrar_seta(&idade_seta, r->tempo_us);
+
+    printf("[SIM] joystick por %s, perda=%.1f%% RTT=%ums variacao=%ums: %u pacotes perdidos, %u retransmissoes TCP\n",
+           TRANSPORTE_JOYSTICK_UDP ? "UDP" : "TCP", perda_pct, g_cenario.rtt_ms, g_cenario.variacao_atraso_ms,
+           r->pacotes_perdidos, r->retransmissoes_tcp);
+    size_t posicoes = g_idade_entrega.quantidade, atualizacoes = g_entregas_seta.quantidade;
+    double entrega_max = percentil_ms(&g_idade_entrega, 1.0);
+    printf("[SIM] idade na entrega: %zu posicoes, p50=%.1f p99=%.1f max=%.1f ms\n", posicoes,
+           percentil_ms(&g_idade_entrega, 0.50), percentil_ms(&g_idade_entrega, 0.99), entrega_max);
+    printf("[SIM] idade da seta:    %zu atualizacoes, p50=%.1f p99=%.1f max=%.1f ms\n", atualizacoes,
+           percentil_ms(&idade_seta, 0.50), percentil_ms(&idade_seta, 0.99), percentil_ms(&idade_seta, 1.0));
+    printf("[SIM] botao A (TCP):    %zu mudancas, p50=%.1f p99=%.1f max=%.1f ms\n", g_idade_botao.quantidade,
+           percentil_ms(&g_idade_botao, 0.50), percentil_ms(&g_idade_botao, 0.99), percentil_ms(&g_idade_botao, 1.0));
+
+    if (r->chamadas_lwip_sem_trava) {
+        fprintf(stderr, "Chamadas ao lwIP sem a trava: %u\n", r->chamadas_lwip_sem_trava);
+        return 1;
+    }
+    if (posicoes == 0 || g_idade_botao.quantidade == 0) {
+        fprintf(stderr, "Nenhuma posição ou mudança do botão chegou ao servidor\n");
+        return 1;
+    }
+    // Todo byte confirmado pelo ACK já foi entregue (o ACK só sai depois da entrega em ordem)
+    if (g_bytes_tcp_entregues < r->bytes_tcp_confirmados) {
+        fprintf(stderr, "Fluxo TCP incompleto: %llu de %llu bytes\n", (unsigned long long)g_bytes_tcp_entregues,
+                (unsigned long long)r->bytes_tcp_confirmados);
+        return 1;
+    }
+    double limite_udp_ms = g_cenario.rtt_ms / 2.0 + g_cenario.variacao_atraso_ms + 2 * PERIODO_JOYSTICK_US / 1e3;
+    if (TRANSPORTE_JOYSTICK_UDP && entrega_max > limite_udp_ms) {
+        fprintf(stderr, "Posição entregue pelo UDP com %.1f ms (limite %.1f ms)\n", entrega_max, limite_udp_ms);
+        return 1;
+    }
+    return 0;
+}
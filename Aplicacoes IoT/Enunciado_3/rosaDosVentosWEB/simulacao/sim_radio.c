@@ -0,0 +1,45 @@
+// sim_radio.c
+// Ciclo de trabalho do rádio para uma política do agendador de transmissão
+// (LATENCIA_MAXIMA_MS e TAMANHO_LOTE, definidos na compilação; ver CMakeLists.txt).
+// Cenário padrão de plataforma.c: DHT11 a cada 2s, botão A a cada 15s, joystick se
+// movendo 5s a cada 30s (datagramas UDP), RTT de 40ms, 10 minutos de tempo virtual.
+#include <stdio.h>
+
+#include "plataforma.h"
+
+#ifndef LATENCIA_MAXIMA_MS
+#error "Defina LATENCIA_MAXIMA_MS (política simulada)"
+#endif
+
+int main(void) {
+    if (!sim_executar()) {
+        fprintf(stderr, "O firmware terminou antes do fim da simulação\n");
+        return 1;
+    }
+
+    const resultados_sim_t *r = &g_resultados;
+    double segundos = r->tempo_us / 1e6;
+    printf("[SIM] politica: latencia maxima=%ums lote=%uB\n", LATENCIA_MAXIMA_MS, TAMANHO_LOTE);
+    printf("[SIM] escritas TCP=%u (%.2f/s) bytes=%llu datagramas UDP=%u pacotes tx=%u rx=%u\n",
+           r->escritas_tcp, r->escritas_tcp / segundos, (unsigned long long)r->bytes_tcp_escritos,
+           r->datagramas_udp, r->pacotes_tx, r->pacotes_rx);
+    printf("[SIM] PERFORMANCE_PM=%.2f%% do tempo (%u trocas de modo), radio acordado (modelo)=%.2f%%\n",
+           100.0 * r->tempo_desempenho_us / r->tempo_us, r->trocas_modo_pm,
+           100.0 * r->tempo_acordado_us / r->tempo_us);
+
+    if (r->chamadas_lwip_sem_trava) {
+        fprintf(stderr, "Chamadas ao lwIP sem a trava: %u\n", r->chamadas_lwip_sem_trava);
+        return 1;
+    }
+    // Tudo o que foi escrito foi confirmado, exceto o que estava em voo no fim
+    if (r->bytes_tcp_escritos - r->bytes_tcp_confirmados > TAMANHO_LOTE) {
+        fprintf(stderr, "Bytes TCP sem confirmação: %llu\n",
+                (unsigned long long)(r->bytes_tcp_escritos - r->bytes_tcp_confirmados));
+        return 1;
+    }
+    if (r->escritas_tcp == 0 || r->datagramas_udp == 0) {
+        fprintf(stderr, "Nenhuma amostra enviada\n");
+        return 1;
+    }
+    return 0;
+}
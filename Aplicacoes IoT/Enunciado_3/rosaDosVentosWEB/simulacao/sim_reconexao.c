@@ -0,0 +1,107 @@
+// sim_reconexao.c
+// Várias placas conectadas ao mesmo servidor, que fecha a conexão de todas no mesmo
+// instante (servidor.py reiniciado, broker fora do ar por um momento):
+//     sim_reconexao [placas] [instante do fechamento em s] [porta do broker]   (padrão: 50 30 0)
+// Cada placa é um processo (fork) com a sua semente do get_rand_32 e o mesmo cenário.
+// Compilado com TRANSPORTE_MQTT = 1, o fechamento é o do broker (em 127.0.0.1:porta,
+// ver bancada/broker_mqtt.py); senão, o da conexão TCP do servidor.py.
+// Relata o tempo de cada placa até a conexão seguinte. Falha se alguma não voltar, se
+// alguma voltar antes de meio INTERVALO_RECONEXAO_TCP_MS (reconexão imediata, sem
+// sorteio) ou se as voltas não se espalharem por pelo menos meio intervalo entre o
+// percentil 10 e o 90.
+// O fonte do firmware é incluído aqui para usar as constantes de reconexão.
+#include "plataforma.h"
+
+#define main firmware_main
+#include "rosaDosVentosWEB.c"
+#undef main
+#undef printf
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define MAX_PLACAS 1000
+
+static int comparar_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Processo filho: uma placa. Escreve reconexao_us no cano (0 = não voltou ou erro).
+static void executar_placa(int placa, int cano) {
+    static char id[16];
+    snprintf(id, sizeof(id), "placa%03d", placa);
+    g_cenario.semente = 0x9E3779B9u * (uint32_t)(placa + 1);
+    g_cenario.id_placa = id;
+    uint64_t reconexao_us = 0;
+    if (sim_executar() && g_resultados.chamadas_lwip_sem_trava == 0) reconexao_us = g_resultados.reconexao_us;
+    if (write(cano, &reconexao_us, sizeof(reconexao_us)) != sizeof(reconexao_us)) _exit(1);
+    _exit(0);
+}
+
+int main(int argc, char **argv) {
+    int placas = argc > 1 ? atoi(argv[1]) : 50;
+    if (placas < 2 || placas > MAX_PLACAS) placas = 50;
+    g_cenario.fechamento_servidor_s = argc > 2 ? (uint32_t)atoi(argv[2]) : 30;
+    g_cenario.porta_broker_mqtt = argc > 3 ? (uint16_t)atoi(argv[3]) : 0;
+    // Depois do fechamento, tempo para a espera mais longa (150% do intervalo) e a conexão
+    g_cenario.duracao_s = g_cenario.fechamento_servidor_s + 3 * INTERVALO_RECONEXAO_TCP_MS / 1000 + 5;
+
+    fflush(stdout);
+    int canos[MAX_PLACAS];
+    for (int i = 0; i < placas; i++) {
+        int cano[2];
+        if (pipe(cano) != 0) {
+            perror("pipe");
+            return 1;
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            close(cano[0]);
+            // Só os relatórios do próprio teste aparecem
+            freopen("/dev/null", "w", stdout);
+            executar_placa(i, cano[1]);
+        }
+        close(cano[1]);
+        canos[i] = cano[0];
+    }
+
+    uint64_t reconexoes_us[MAX_PLACAS];
+    int voltaram = 0;
+    for (int i = 0; i < placas; i++) {
+        uint64_t reconexao_us = 0;
+        if (read(canos[i], &reconexao_us, sizeof(reconexao_us)) == sizeof(reconexao_us) && reconexao_us) {
+            reconexoes_us[voltaram++] = reconexao_us;
+        }
+        close(canos[i]);
+    }
+    while (wait(NULL) > 0) {}
+
+    printf("[SIM] %s fechou %d placas em t=%us: %d voltaram\n", TRANSPORTE_MQTT ? "broker MQTT" : "servidor TCP",
+           placas, g_cenario.fechamento_servidor_s, voltaram);
+    if (voltaram < placas) {
+        fprintf(stderr, "%d placas não reconectaram (ou chamaram o lwIP sem a trava)\n", placas - voltaram);
+        return 1;
+    }
+    qsort(reconexoes_us, voltaram, sizeof(uint64_t), comparar_u64);
+    uint64_t p10 = reconexoes_us[voltaram / 10], p90 = reconexoes_us[voltaram * 9 / 10];
+    printf("[SIM] reconexao: min=%.0f p10=%.0f p50=%.0f p90=%.0f max=%.0f ms\n", reconexoes_us[0] / 1e3, p10 / 1e3,
+           reconexoes_us[voltaram / 2] / 1e3, p90 / 1e3, reconexoes_us[voltaram - 1] / 1e3);
+
+    uint64_t meio_intervalo_us = (uint64_t)INTERVALO_RECONEXAO_TCP_MS * 1000 / 2;
+    if (reconexoes_us[0] < meio_intervalo_us) {
+        fprintf(stderr, "Placa reconectou em %.0f ms, antes da espera mínima\n", reconexoes_us[0] / 1e3);
+        return 1;
+    }
+    if (p90 - p10 < meio_intervalo_us) {
+        fprintf(stderr, "Reconexões concentradas: p90 - p10 = %.0f ms\n", (p90 - p10) / 1e3);
+        return 1;
+    }
+    return 0;
+}
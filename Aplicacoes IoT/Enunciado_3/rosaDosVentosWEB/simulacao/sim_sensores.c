@@ -0,0 +1,95 @@
+// sim_sensores.c
+// Taxa e jitter reais das leituras do joystick e dos botões no firmware completo, com o
+// custo do printf (ver plataforma.h) e o tráfego TCP/UDP do cenário padrão de plataforma.c.
+// Os instantes vêm da própria plataforma (cada adc_read e gpio_get dos botões), não do
+// relatório [SENSORES] do firmware.
+//     sim_sensores [custo do printf em us/byte]    (padrão: o do stdio USB em plataforma.c)
+// Falha se a taxa ficar abaixo de 99% da pedida ou se alguma leitura atrasar um período inteiro.
+// Com o stdio na UART a 115200 baud (sim_sensores 87), os três relatórios [SENSORES] saem
+// em ~25ms e seguram o joystick por 2 ou 3 períodos a cada minuto; no USB, não.
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "plataforma.h"
+
+#define PERIODO_JOYSTICK_US 10000u   // PERIODO_JOYSTICK_MS do firmware
+#define PERIODO_BOTOES_US 50000u     // PERIODO_BOTOES_MS
+#define PINO_BOTAO_A 5
+
+typedef struct {
+    const char *nome;
+    uint32_t periodo_us;
+    uint64_t ultima_us;
+    uint32_t leituras;
+    uint32_t intervalo_maximo_us;
+    uint32_t lacunas;                // Intervalos de mais de 1,5 período (leituras perdidas)
+    uint64_t soma_desvio_us;         // |intervalo - período|
+} medicao_t;
+
+static medicao_t g_joystick = {"joystick", PERIODO_JOYSTICK_US};
+static medicao_t g_botoes = {"botoes", PERIODO_BOTOES_US};
+
+static void registrar_leitura(medicao_t *m, uint64_t t_us) {
+    // Uma leitura do sensor faz várias chamadas no mesmo instante (os dois eixos, os três botões)
+    if (m->leituras > 0 && t_us == m->ultima_us) return;
+    if (m->leituras > 0) {
+        uint32_t intervalo = (uint32_t)(t_us - m->ultima_us);
+        if (intervalo > m->intervalo_maximo_us) m->intervalo_maximo_us = intervalo;
+        if (intervalo * 2 > m->periodo_us * 3) m->lacunas++;
+        m->soma_desvio_us += intervalo > m->periodo_us ? intervalo - m->periodo_us : m->periodo_us - intervalo;
+    }
+    m->ultima_us = t_us;
+    m->leituras++;
+}
+
+static void joystick_medido(uint64_t t_us, uint16_t *x, uint16_t *y) {
+    registrar_leitura(&g_joystick, t_us);
+    // Move por 5s e fica parado por 25s, a cada 30s (como o padrão da plataforma)
+    uint64_t fase = t_us % 30000000u;
+    if (fase > 5000000u) fase = 5000000u;
+    *x = (uint16_t)(2048 + fase * 1800 / 5000000u);
+    *y = 2048;
+}
+
+static bool botao_medido(uint64_t t_us, unsigned pino) {
+    if (pino == PINO_BOTAO_A) registrar_leitura(&g_botoes, t_us);
+    return pino == PINO_BOTAO_A && t_us % 15000000u < 200000u;
+}
+
+static bool relatar(const medicao_t *m, double segundos) {
+    double taxa = m->leituras / segundos;
+    double alvo = 1e6 / m->periodo_us;
+    printf("[SIM] %-8s %.2f Hz (alvo %.1f Hz) desvio medio=%.3f ms intervalo max=%.2f ms lacunas=%u (%.1f/min)\n",
+           m->nome, taxa, alvo, m->leituras > 1 ? m->soma_desvio_us / 1e3 / (m->leituras - 1) : 0.0,
+           m->intervalo_maximo_us / 1e3, m->lacunas, m->lacunas * 60.0 / segundos);
+    return taxa >= 0.99 * alvo && m->intervalo_maximo_us < 2 * m->periodo_us;
+}
+
+int main(int argc, char **argv) {
+    g_cenario.joystick = joystick_medido;
+    g_cenario.botao = botao_medido;
+    if (argc > 1) g_cenario.custo_printf_us_por_byte = (uint32_t)atoi(argv[1]);
+
+    if (!sim_executar()) {
+        fprintf(stderr, "O firmware terminou antes do fim da simulação\n");
+        return 1;
+    }
+
+    const resultados_sim_t *r = &g_resultados;
+    double segundos = r->tempo_us / 1e6;
+    printf("[SIM] printf: %llu bytes em %.1fs, %.3f%% do tempo (%u us + %u us/byte)\n",
+           (unsigned long long)r->bytes_printf, segundos, 100.0 * r->tempo_printf_us / r->tempo_us,
+           g_cenario.custo_printf_us, g_cenario.custo_printf_us_por_byte);
+    bool ok = relatar(&g_joystick, segundos);
+    ok = relatar(&g_botoes, segundos) && ok;
+
+    if (r->chamadas_lwip_sem_trava) {
+        fprintf(stderr, "Chamadas ao lwIP sem a trava: %u\n", r->chamadas_lwip_sem_trava);
+        return 1;
+    }
+    if (!ok) {
+        fprintf(stderr, "Leituras abaixo da taxa pedida ou com atraso de um período inteiro\n");
+        return 1;
+    }
+    return 0;
+}
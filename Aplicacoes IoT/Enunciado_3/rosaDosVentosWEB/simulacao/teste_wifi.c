@@ -0,0 +1,226 @@
+// teste_wifi.c
+// Testes do gerenciador de conexão Wi-Fi do rosaDosVentosWEB.c:
+// 1. wifi_transicao() (sem hardware) com roteiros de status do enlace: associação,
+//    DHCP lento com e sem concessão guardada, falhas e queda do enlace.
+// 2. O firmware inteiro na plataforma simulada: boot, queda do ponto de acesso e
+//    reconexão rápida com DHCP lento, sem chamadas ao lwIP fora da trava.
+// O fonte do firmware é incluído aqui para ter acesso aos tipos e funções internos.
+#include "plataforma.h"
+
+#define main firmware_main
+#include "rosaDosVentosWEB.c"
+#undef main
+#undef printf
+
+static int g_falhas;
+
+#define VERIFICAR(condicao) do { \
+        if (!(condicao)) { \
+            fprintf(stderr, "%s:%d: falhou: %s\n", __FILE__, __LINE__, #condicao); \
+            g_falhas++; \
+        } \
+    } while (0)
+
+// Roteiro do enlace: status a partir de cada instante
+typedef struct {
+    uint32_t t_ms;
+    int status;
+} trecho_t;
+
+#define NUM_ACOES 7
+
+typedef struct {
+    uint32_t todas;                  // União das ações pedidas
+    uint32_t vezes[NUM_ACOES];       // Quantas vezes cada ação foi pedida
+    uint32_t primeira_ms[NUM_ACOES]; // Instante da primeira vez
+} registro_acoes_t;
+
+static int indice_acao(uint32_t acao) {
+    return __builtin_ctz(acao);
+}
+
+// Chama wifi_transicao() a cada 10ms de 'inicio' até 'fim', como o loop principal
+static registro_acoes_t executar_roteiro(gerenciador_wifi_t *wifi, const trecho_t *roteiro, size_t trechos,
+                                         uint32_t inicio, uint32_t fim) {
+    registro_acoes_t registro;
+    memset(&registro, 0, sizeof(registro));
+    for (uint32_t t = inicio; t <= fim; t += 10) {
+        int status = CYW43_LINK_DOWN;
+        for (size_t i = 0; i < trechos; i++) {
+            if (roteiro[i].t_ms <= t) status = roteiro[i].status;
+        }
+        uint32_t acoes = wifi_transicao(wifi, status, t);
+        registro.todas |= acoes;
+        for (int i = 0; i < NUM_ACOES; i++) {
+            if (acoes & (1u << i)) {
+                if (registro.vezes[i]++ == 0) registro.primeira_ms[i] = t;
+            }
+        }
+    }
+    return registro;
+}
+
+#define VEZES(registro, acao) ((registro).vezes[indice_acao(acao)])
+#define PRIMEIRA(registro, acao) ((registro).primeira_ms[indice_acao(acao)])
+#define TRECHOS(roteiro) (sizeof(roteiro) / sizeof(roteiro[0]))
+
+static void novo_gerenciador(gerenciador_wifi_t *wifi, bool com_cache) {
+    memset(wifi, 0, sizeof(*wifi));
+    wifi->cache_valido = com_cache;
+    wifi->primeira_conexao = true;
+    wifi_preparar_associacao(wifi, true, 0);
+}
+
+static void teste_boot_sem_cache(void) {
+    gerenciador_wifi_t wifi;
+    novo_gerenciador(&wifi, false);
+    VERIFICAR(wifi.estado == WIFI_ASSOCIANDO_COMPLETO);
+
+    const trecho_t roteiro[] = {{0, CYW43_LINK_DOWN}, {1200, CYW43_LINK_NOIP}, {1500, CYW43_LINK_UP}};
+    registro_acoes_t r = executar_roteiro(&wifi, roteiro, TRECHOS(roteiro), 0, 3000);
+    VERIFICAR(r.todas == WIFI_ACAO_CONECTADO);
+    VERIFICAR(PRIMEIRA(r, WIFI_ACAO_CONECTADO) == 1500);
+    VERIFICAR(wifi.estado == WIFI_CONECTADO);
+    VERIFICAR(wifi.t_associado_ms == 1200 && wifi.t_ip_ms == 1500);
+    VERIFICAR(!wifi.conexao_rapida && !wifi.usando_ip_guardado);
+    VERIFICAR(wifi.primeira_amostra_pendente);
+}
+
+static void teste_associacao_ja_com_ip(void) {
+    gerenciador_wifi_t wifi;
+    novo_gerenciador(&wifi, true);
+    // Enlace e IP no mesmo instante: conecta na mesma chamada
+    const trecho_t roteiro[] = {{0, CYW43_LINK_DOWN}, {800, CYW43_LINK_UP}};
+    registro_acoes_t r = executar_roteiro(&wifi, roteiro, TRECHOS(roteiro), 0, 1000);
+    VERIFICAR(PRIMEIRA(r, WIFI_ACAO_CONECTADO) == 800);
+    VERIFICAR(wifi.t_associado_ms == 800 && wifi.t_ip_ms == 800);
+    VERIFICAR(wifi.conexao_rapida);
+}
+
+static void teste_dhcp_lento_com_cache(void) {
+    gerenciador_wifi_t wifi;
+    novo_gerenciador(&wifi, true);
+    VERIFICAR(wifi.estado == WIFI_ASSOCIANDO_RAPIDO);
+
+    const trecho_t roteiro[] = {{0, CYW43_LINK_DOWN}, {400, CYW43_LINK_NOIP}, {4000, CYW43_LINK_UP}};
+    registro_acoes_t r = executar_roteiro(&wifi, roteiro, TRECHOS(roteiro), 0, 5000);
+    // O IP guardado é aplicado uma única vez, logo depois do prazo do DHCP
+    VERIFICAR(VEZES(r, WIFI_ACAO_USAR_IP_GUARDADO) == 1);
+    VERIFICAR(PRIMEIRA(r, WIFI_ACAO_USAR_IP_GUARDADO) == 400 + PRAZO_DHCP_MS + 10);
+    VERIFICAR(PRIMEIRA(r, WIFI_ACAO_CONECTADO) == 4000);
+    VERIFICAR(wifi.usando_ip_guardado && wifi.conexao_rapida);
+    VERIFICAR(wifi.t_associado_ms == 400 && wifi.t_ip_ms == 4000);
+}
+
+static void teste_dhcp_lento_sem_cache(void) {
+    gerenciador_wifi_t wifi;
+    novo_gerenciador(&wifi, false);
+    const trecho_t roteiro[] = {{0, CYW43_LINK_DOWN}, {400, CYW43_LINK_NOIP}, {4000, CYW43_LINK_UP}};
+    registro_acoes_t r = executar_roteiro(&wifi, roteiro, TRECHOS(roteiro), 0, 5000);
+    VERIFICAR(VEZES(r, WIFI_ACAO_USAR_IP_GUARDADO) == 0);
+    VERIFICAR(PRIMEIRA(r, WIFI_ACAO_CONECTADO) == 4000);
+}
+
+static void teste_reconexao_rapida_expira(void) {
+    gerenciador_wifi_t wifi;
+    novo_gerenciador(&wifi, true);
+    const trecho_t roteiro[] = {{0, CYW43_LINK_DOWN}};
+    registro_acoes_t r = executar_roteiro(&wifi, roteiro, TRECHOS(roteiro), 0, 30000);
+    // Sem resposta: desiste do BSSID guardado após o timeout curto e faz a conexão completa,
+    // que por sua vez é refeita a cada TIMEOUT_CONEXAO_WIFI_MS
+    VERIFICAR(VEZES(r, WIFI_ACAO_RAPIDA_FALHOU) == 1);
+    VERIFICAR(PRIMEIRA(r, WIFI_ACAO_RAPIDA_FALHOU) == TIMEOUT_RECONEXAO_RAPIDA_MS + 10);
+    VERIFICAR(VEZES(r, WIFI_ACAO_COMPLETA_FALHOU) == 1);
+    VERIFICAR(PRIMEIRA(r, WIFI_ACAO_COMPLETA_FALHOU) == TIMEOUT_RECONEXAO_RAPIDA_MS + 10 + TIMEOUT_CONEXAO_WIFI_MS + 10);
+    VERIFICAR(VEZES(r, WIFI_ACAO_ASSOCIAR) == 2);
+    VERIFICAR(wifi.estado == WIFI_ASSOCIANDO_COMPLETO && !wifi.conexao_rapida);
+}
+
+static void teste_reconexao_rapida_recusada(void) {
+    gerenciador_wifi_t wifi;
+    novo_gerenciador(&wifi, true);
+    const trecho_t roteiro[] = {{0, CYW43_LINK_DOWN}, {100, CYW43_LINK_NONET}, {200, CYW43_LINK_DOWN},
+                                {1500, CYW43_LINK_JOIN}, {1700, CYW43_LINK_UP}};
+    registro_acoes_t r = executar_roteiro(&wifi, roteiro, TRECHOS(roteiro), 0, 2000);
+    VERIFICAR(PRIMEIRA(r, WIFI_ACAO_RAPIDA_FALHOU) == 100);
+    VERIFICAR(PRIMEIRA(r, WIFI_ACAO_CONECTADO) == 1700);
+    VERIFICAR(!wifi.conexao_rapida);
+}
+
+static void teste_queda_do_enlace(void) {
+    gerenciador_wifi_t wifi;
+    novo_gerenciador(&wifi, true);
+    const trecho_t roteiro[] = {{0, CYW43_LINK_DOWN}, {300, CYW43_LINK_UP}, {10000, CYW43_LINK_DOWN},
+                                {10300, CYW43_LINK_NOIP}, {10500, CYW43_LINK_UP}};
+    registro_acoes_t r = executar_roteiro(&wifi, roteiro, TRECHOS(roteiro), 0, 11000);
+    VERIFICAR(VEZES(r, WIFI_ACAO_CONECTADO) == 2);
+    VERIFICAR(VEZES(r, WIFI_ACAO_ENLACE_PERDIDO) == 1);
+    VERIFICAR(PRIMEIRA(r, WIFI_ACAO_ENLACE_PERDIDO) == 10000);
+    VERIFICAR(VEZES(r, WIFI_ACAO_ASSOCIAR) == 1);
+    // Métricas da reconexão contam a partir da queda; ela usa o caminho rápido
+    VERIFICAR(!wifi.primeira_conexao && wifi.conexao_rapida);
+    VERIFICAR(wifi.inicio_conexao_ms == 10000);
+    VERIFICAR(wifi.t_associado_ms == 300 && wifi.t_ip_ms == 500);
+}
+
+static void teste_enlace_cai_aguardando_ip(void) {
+    gerenciador_wifi_t wifi;
+    novo_gerenciador(&wifi, false);
+    const trecho_t roteiro[] = {{0, CYW43_LINK_DOWN}, {500, CYW43_LINK_JOIN}, {800, CYW43_LINK_DOWN}};
+    registro_acoes_t r = executar_roteiro(&wifi, roteiro, TRECHOS(roteiro), 0, 800);
+    VERIFICAR(r.todas == WIFI_ACAO_ASSOCIAR);
+    VERIFICAR(PRIMEIRA(r, WIFI_ACAO_ASSOCIAR) == 800);
+    VERIFICAR(wifi.estado == WIFI_ASSOCIANDO_COMPLETO);
+}
+
+static void teste_endereco_mudou(void) {
+    gerenciador_wifi_t wifi;
+    novo_gerenciador(&wifi, false);
+    const trecho_t roteiro[] = {{0, CYW43_LINK_UP}};
+    executar_roteiro(&wifi, roteiro, TRECHOS(roteiro), 0, 100);
+    VERIFICAR(wifi.estado == WIFI_CONECTADO);
+    wifi.mudanca_netif = true; // Callback de status do lwIP (ex.: o DHCP corrigiu o IP guardado)
+    VERIFICAR(wifi_transicao(&wifi, CYW43_LINK_UP, 200) == WIFI_ACAO_ENDERECO_MUDOU);
+    VERIFICAR(!wifi.mudanca_netif);
+    VERIFICAR(wifi_transicao(&wifi, CYW43_LINK_UP, 210) == 0);
+}
+
+// Firmware completo: o primeiro boot grava o cache; na queda, a reconexão rápida usa o
+// BSSID guardado e, como o DHCP demora mais que PRAZO_DHCP_MS, também o IP guardado
+static void teste_firmware_queda_e_dhcp_lento(void) {
+    g_cenario.duracao_s = 60;
+    g_cenario.associacao_ms = 1200;
+    g_cenario.dhcp_ms = 2500;
+    g_cenario.queda_enlace_s = 30;
+    g_cenario.duracao_queda_ms = 1000;
+    VERIFICAR(sim_executar());
+
+    VERIFICAR(g_wifi.estado == WIFI_CONECTADO);
+    VERIFICAR(g_wifi.cache_valido);
+    VERIFICAR(!g_wifi.primeira_conexao);
+    VERIFICAR(g_wifi.conexao_rapida);
+    VERIFICAR(g_wifi.usando_ip_guardado);
+    VERIFICAR(!g_wifi.primeira_amostra_pendente);  // A primeira amostra após a reconexão saiu
+    VERIFICAR(g_resultados.conexoes_tcp == 2);
+    VERIFICAR(g_resultados.chamadas_lwip_sem_trava == 0);
+}
+
+int main(void) {
+    teste_boot_sem_cache();
+    teste_associacao_ja_com_ip();
+    teste_dhcp_lento_com_cache();
+    teste_dhcp_lento_sem_cache();
+    teste_reconexao_rapida_expira();
+    teste_reconexao_rapida_recusada();
+    teste_queda_do_enlace();
+    teste_enlace_cai_aguardando_ip();
+    teste_endereco_mudou();
+    teste_firmware_queda_e_dhcp_lento();
+
+    if (g_falhas) {
+        fprintf(stderr, "%d verificações falharam\n", g_falhas);
+        return 1;
+    }
+    printf("teste_wifi: ok\n");
+    return 0;
+}
@@ -1,91 +1,614 @@
 import asyncio
+import http
 import websockets
 import json
+import os
+import socket
+import sys
+import time
+import multiprocessing
 from datetime import datetime
+from urllib.parse import parse_qs, urlparse
+
+from admissao import Admissao
+from telemetria import interpretar_bloco, interpretar_registro, implementacao as implementacao_telemetria
+from regras import MotorRegras, carregar_regras
 
 # --- CONFIGURAÇÕES ---
 PORTA_TCP = 8082
 PORTA_WEBSOCKET = 8083
+PORTA_UDP_JOYSTICK = 8084
+PORTA_UDP_ENUNCIADO_2 = 8081      # Datagramas "VRX=.. VRY=.." do rosaDosVentos.c
 ARQUIVO_LOG = "log_servidor.txt"
+ARQUIVO_AMOSTRAS = "amostras.jsonl"
+ARQUIVO_REGRAS = "regras.txt"     # Alertas avaliados sobre o fluxo (ver regras.py)
+PERIODO_PRAZOS_REGRAS_S = 0.5     # Conferência das regras com "por <N>s"
+INTERVALO_GRAVACAO_S = 1.0        # As amostras são gravadas em lote, não uma escrita por mensagem
+TAMANHO_LEITURA_TCP = 4096        # Bytes lidos por vez da conexão da placa (várias linhas por leitura)
+TAMANHO_MAXIMO_LINHA = 1024       # Linha sem '\n' maior que isso é descartada
+
+# Números de sequência do joystick (UDP): recuo maior que isso é tratado como reinício da placa
+JANELA_REINICIO_SEQUENCIA = 1000
+# Amostras UDP esperando a publicação; com a fila cheia, o datagrama é descartado (como o
+# kernel faria com o buffer do socket cheio) e conta no [CONEXOES]
+TAMANHO_FILA_UDP = 256
+
+# Processos que atendem as placas via TCP (ver "SHARDS TCP" abaixo).
+# 1 = tudo em um processo; 0 = um shard por núcleo. Também aceito na linha de comando:
+#     python servidor.py [num_shards]
+NUM_SHARDS_TCP = 1
+TAMANHO_LEITURA_SHARD = 65536
+# Origens reservadas nas linhas shard -> principal: abertura/fechamento de conexão de placa
+CONTROLE_CONECTOU = "controle:conectou"
+CONTROLE_DESCONECTOU = "controle:desconectou"
+
+# Admissão de conexões (ver admissao.py); as taxas e rajadas são divididas entre os shards
+TAXA_ADMISSAO_POR_S = 50          # Conexões novas aceitas por segundo (balde comum)
+RAJADA_ADMISSAO = 100             # Conexões aceitas de uma vez antes de a taxa valer
+TAXA_ADMISSAO_CONHECIDAS_POR_S = 200  # Balde só das placas conhecidas, além do comum
+RAJADA_ADMISSAO_CONHECIDAS = 200
+RESERVA_PLACAS = 20               # Fichas do balde que os dashboards não podem usar
+FILA_HANDSHAKES = 128             # backlog do listen(): conexões esperando o accept
+ESPERA_MAXIMA_SUGERIDA_S = 60     # Teto do RETRY= / Retry-After enviado a quem é recusado
+PERIODO_RELATORIO_CONEXOES_S = 60
+INTERVALO_SNAPSHOT_S = 0.25       # Cada snapshot é remontado no máximo uma vez por intervalo
 
 CLIENTES_WEB_CONECTADOS = set()
+PREFIXO_LOG = ""                  # "[shard N] " nos processos de shard
 
 def log(mensagem):
     timestamp = datetime.now().strftime("%Y-%m-%d %H:%M:%S")
-    log_completo = f"[{timestamp}] {mensagem}"
+    log_completo = f"[{timestamp}] {PREFIXO_LOG}{mensagem}"
     print(log_completo)
     with open(ARQUIVO_LOG, "a") as f:
         f.write(log_completo + "\n")
 
+# --- AMOSTRAS NORMALIZADAS ---
+# Os dois firmwares falam o mesmo formato "CHAVE=valor CHAVE=valor ...":
+#   rosaDosVentos.c (UDP 8081):     VRX=.. VRY=..
+#   rosaDosVentosWEB.c (TCP 8082):  [VRX=.. VRY=..] BTN=.. A=.. B=.. TEMP=.. UMI=..
+#   rosaDosVentosWEB.c (UDP 8084):  SEQ=.. VRX=.. VRY=..
+# Tudo passa pelo interpretador do módulo telemetria (em C, se compilado) e vira uma
+# Amostra, que segue pelo mesmo caminho (publicar_amostra) para o WebSocket e para o
+# arquivo de amostras.
+
+# --- ADMISSÃO DE CONEXÕES ---
+# Balde de fichas com prioridade para as placas já conhecidas (ver admissao.py)
+
+def criar_admissao(num_shards=1):
+    return Admissao(TAXA_ADMISSAO_POR_S / num_shards, max(1, RAJADA_ADMISSAO // num_shards),
+                    TAXA_ADMISSAO_CONHECIDAS_POR_S / num_shards, max(1, RAJADA_ADMISSAO_CONHECIDAS // num_shards),
+                    RESERVA_PLACAS, ESPERA_MAXIMA_SUGERIDA_S)
+
+admissao_conexoes = criar_admissao()
+dispositivos_conhecidos = set()   # Placas que já enviaram amostras válidas (por IP)
+canais_shards = []                # No principal: StreamWriter de cada shard (ver "SHARDS TCP")
+
+def conhecer_dispositivo(dispositivo):
+    """ Marca a placa como conhecida. No principal, uma placa nova é repassada aos shards:
+    depois de uma queda, ela pode reconectar em outro shard (ou chegar só por UDP antes). """
+    if dispositivo in dispositivos_conhecidos:
+        return
+    dispositivos_conhecidos.add(dispositivo)
+    for canal in canais_shards:
+        canal.write(f"conhecido\t{dispositivo}\n".encode())
+
+# --- CONTABILIDADE DAS CONEXÕES ---
+# Bytes retidos por conexão: linha incompleta da placa ou mensagens ainda não enviadas ao
+# dashboard (buffer de escrita do transporte). Resumo periódico em [CONEXOES].
+
+class RegistroConexao:
+    __slots__ = ('tipo', 'endereco', 'transporte', 'bytes_pendentes')
+
+    def __init__(self, tipo, endereco, transporte):
+        self.tipo = tipo                 # "placa" ou "dashboard"
+        self.endereco = endereco
+        self.transporte = transporte
+        self.bytes_pendentes = 0         # Mantido pelo manipulador (linha incompleta)
+
+    def bytes_retidos(self):
+        escrita = self.transporte.get_write_buffer_size() if self.transporte else 0
+        return self.bytes_pendentes + escrita
+
+conexoes_ativas = set()
+
+async def relatorio_conexoes_periodico():
+    while True:
+        await asyncio.sleep(PERIODO_RELATORIO_CONEXOES_S)
+        placas = sum(1 for c in conexoes_ativas if c.tipo == "placa")
+        retidos = [(c.bytes_retidos(), c) for c in conexoes_ativas]
+        total = sum(b for b, _ in retidos)
+        maior = max(retidos, key=lambda item: item[0], default=(0, None))
+        log(f"[CONEXOES] placas={placas} dashboards={len(conexoes_ativas) - placas} "
+            f"bytes retidos={total} (maior: {maior[0]} de {maior[1].endereco if maior[1] else '-'}) "
+            f"aceitas={admissao_conexoes.aceitas} (conhecidas {admissao_conexoes.aceitas_conhecidas}) "
+            f"recusadas={admissao_conexoes.recusadas} "
+            f"datagramas descartados={datagramas_descartados}")
+
+class Amostra:
+    __slots__ = ('dispositivo', 'origem', 'recebido_em', 'campos')
+
+    def __init__(self, dispositivo, origem, campos):
+        self.dispositivo = dispositivo   # Identidade da placa (IP de origem)
+        self.origem = origem             # "tcp", "udp-joystick" ou "udp-enunciado2"
+        self.recebido_em = time.time()   # Momento da recepção no servidor
+        self.campos = campos             # Campos já convertidos (int/float)
+
+    def para_json(self):
+        return json.dumps({**self.campos, 'DISPOSITIVO': self.dispositivo})
+
+    def para_registro(self):
+        return json.dumps({'t': round(self.recebido_em, 3), 'dispositivo': self.dispositivo,
+                           'origem': self.origem, **self.campos})
+
+ultima_sequencia = {}      # Placa -> último SEQ repassado (joystick via UDP)
+amostras_a_gravar = []     # Linhas (para_registro) para a gravação periódica em ARQUIVO_AMOSTRAS
+canal_principal = None     # Em um shard: StreamWriter do socket até o processo principal
+motor_regras = MotorRegras([])
+conexoes_por_placa = {}    # Placa -> conexões TCP abertas (em qualquer shard)
+
+def sequencia_atrasada(amostra):
+    """ Descarta datagramas atrasados ou duplicados do joystick (campo SEQ).
+    A placa começa em 1 a cada boot; fora isso, sequência não maior é atrasada ou duplicada. """
+    sequencia = amostra.campos.pop('SEQ', None)
+    if sequencia is None:
+        return False
+    ultima = ultima_sequencia.get(amostra.dispositivo)
+    if ultima is not None and sequencia != 1 and ultima - JANELA_REINICIO_SEQUENCIA < sequencia <= ultima:
+        return True
+    ultima_sequencia[amostra.dispositivo] = sequencia
+    return False
+
+async def publicar_amostra(amostra):
+    """ Caminho único de saída: fila de gravação + envio para os dashboards. """
+    if sequencia_atrasada(amostra):
+        return
+    conhecer_dispositivo(amostra.dispositivo)
+    await publicar(amostra.para_json(), amostra.para_registro(), amostra.dispositivo, amostra.origem)
+    if canal_principal is None:
+        # Num shard, a amostra é avaliada no principal (receber_do_shard), que tem o estado
+        # das regras de todas as placas
+        await avaliar_regras(amostra.dispositivo, amostra.campos, amostra.recebido_em)
+
+async def avaliar_regras(dispositivo, campos, t):
+    for evento in motor_regras.avaliar(dispositivo, campos, t):
+        await publicar_evento(evento)
+
+async def publicar_evento(evento):
+    """ Eventos das regras vão para o log e para os dashboards (não para o arquivo de amostras).
+    O último evento de cada regra entra no estado da placa, para que um dashboard que
+    conecte depois saiba quais alertas estão ativos. """
+    log(f"[REGRA] {evento['regra']} {evento['estado']} em {evento['DISPOSITIVO']}: "
+        f"{evento['expressao']} (valor {evento['valor']})")
+    await publicar(json.dumps(evento), dispositivo=evento['DISPOSITIVO'], origem=f"regra:{evento['regra']}")
+
+async def vencer_prazos_regras_periodicamente():
+    while True:
+        await asyncio.sleep(PERIODO_PRAZOS_REGRAS_S)
+        for evento in motor_regras.vencer_prazos(time.time()):
+            await publicar_evento(evento)
+
+def iniciar_regras():
+    global motor_regras
+    motor_regras = MotorRegras(carregar_regras(ARQUIVO_REGRAS))
+
+async def registrar_conexao_placa(dispositivo, conectou):
+    """ Conta as conexões TCP de cada placa. Quando a última fecha, o estado das regras da
+    placa é descartado e os alertas ativos dela saem como "normalizado". Num shard, só
+    avisa o principal (a placa pode reconectar por outro shard antes da antiga fechar). """
+    if canal_principal is not None:
+        tipo = CONTROLE_CONECTOU if conectou else CONTROLE_DESCONECTOU
+        canal_principal.write(f"{dispositivo}\t{tipo}\t\t\n".encode())
+        await canal_principal.drain()
+        return
+    abertas = conexoes_por_placa.get(dispositivo, 0) + (1 if conectou else -1)
+    if abertas > 0:
+        conexoes_por_placa[dispositivo] = abertas
+        return
+    conexoes_por_placa.pop(dispositivo, None)
+    for evento in motor_regras.esquecer(dispositivo, time.time()):
+        await publicar_evento(evento)
+
+async def publicar(mensagem, registro="", dispositivo="", origem=""):
+    """ Envia 'mensagem' aos dashboards e grava 'registro' (se houver). Mensagens de uma
+    placa ('dispositivo' preenchido) também atualizam o estado enviado a novos dashboards.
+    Em um shard, repassa tudo, já serializado, ao processo principal. """
+    if canal_principal is not None:
+        # O json.dumps escapa tabulações e quebras de linha, então "\t" e "\n" delimitam
+        canal_principal.write(f"{dispositivo}\t{origem}\t{registro}\t{mensagem}\n".encode())
+        await canal_principal.drain()
+        return
+    if registro:
+        amostras_a_gravar.append(registro)
+    if dispositivo and atualizar_estado(dispositivo, origem, mensagem):
+        await broadcast_para_web(mensagem_dispositivos())
+    await broadcast_para_web(mensagem, dispositivo)
+
+# --- ESTADO PARA NOVOS DASHBOARDS ---
+# Última mensagem de cada canal de cada placa, já serializada: dispositivo -> {origem: json}.
+# Um dashboard assina uma placa (?dispositivo=<ip> na URL ou {"assinar": "<ip>"} depois;
+# null = todas) e recebe o estado dela em uma única mensagem {"snapshot": [...]} e, depois,
+# só o fluxo dela. A lista de placas vai em {"dispositivos": [...]} ao conectar e a cada
+# placa nova.
+# O snapshot de cada assinatura é montado (concatenando as strings, sem json.dumps) e
+# guardado pronto. Enquanto não houver mudança, todos os que assinarem recebem o mesmo
+# texto; com mudanças, ele é remontado no máximo uma vez por INTERVALO_SNAPSHOT_S, e quem
+# assinar nesse meio-tempo espera a próxima montagem e o recebe num único
+# websockets.broadcast (o quadro é codificado uma vez para todos). O broadcast escreve
+# sem 'await', e a entrada em 'assinaturas' acontece junto com ele: o que for publicado
+# depois chega depois do snapshot.
+estado_dispositivos = {}
+assinaturas = {}            # websocket -> placa assinada (None = todas)
+snapshots_prontos = {}      # placa (None = todas) -> texto do snapshot
+snapshots_desatualizados = set()
+aguardando_snapshot = {}    # placa (None = todas) -> [websocket] esperando a próxima montagem
+proxima_montagem = 0.0
+montagem_agendada = False
+mensagem_dispositivos_pronta = None
+
+def atualizar_estado(dispositivo, origem, mensagem):
+    """ Guarda a mensagem no estado da placa; retorna True se a placa é nova. """
+    global mensagem_dispositivos_pronta
+    canais = estado_dispositivos.get(dispositivo)
+    nova = canais is None
+    if nova:
+        canais = estado_dispositivos[dispositivo] = {}
+        mensagem_dispositivos_pronta = None
+    canais[origem] = mensagem
+    snapshots_desatualizados.add(dispositivo)
+    snapshots_desatualizados.add(None)
+    return nova
+
+def mensagem_dispositivos():
+    global mensagem_dispositivos_pronta
+    if mensagem_dispositivos_pronta is None:
+        mensagem_dispositivos_pronta = json.dumps({"dispositivos": sorted(estado_dispositivos)})
+    return mensagem_dispositivos_pronta
+
+def montar_snapshot(placa):
+    if placa is None:
+        mensagens = [mensagem for canais in estado_dispositivos.values() for mensagem in canais.values()]
+    else:
+        mensagens = list(estado_dispositivos.get(placa, {}).values())
+    snapshots_prontos[placa] = '{"snapshot": [' + ", ".join(mensagens) + ']}'
+    snapshots_desatualizados.discard(placa)
+
+def entregar_snapshot(destinos, placa):
+    """ Envia o snapshot já montado e passa os dashboards a receber o fluxo de 'placa'. """
+    abertos = [websocket for websocket in destinos if websocket.open]
+    websockets.broadcast(abertos, snapshots_prontos[placa])
+    for websocket in abertos:
+        assinaturas[websocket] = placa
+
+def assinar(websocket, placa):
+    global montagem_agendada
+    assinaturas.pop(websocket, None)
+    if placa is not None and placa not in estado_dispositivos:
+        # Placa ainda sem amostras: nada a guardar (nem a montar para nomes quaisquer)
+        if websocket.open:
+            websockets.broadcast([websocket], '{"snapshot": []}')
+            assinaturas[websocket] = placa
+        return
+    if placa not in snapshots_desatualizados:
+        if placa not in snapshots_prontos:
+            montar_snapshot(placa)
+        entregar_snapshot([websocket], placa)
+        return
+    aguardando_snapshot.setdefault(placa, []).append(websocket)
+    if not montagem_agendada:
+        montagem_agendada = True
+        loop = asyncio.get_running_loop()
+        loop.call_at(max(loop.time(), proxima_montagem), montar_snapshots_aguardados)
+
+def montar_snapshots_aguardados():
+    global montagem_agendada, proxima_montagem
+    montagem_agendada = False
+    loop = asyncio.get_running_loop()
+    proxima_montagem = loop.time() + INTERVALO_SNAPSHOT_S
+    for placa, websockets_aguardando in aguardando_snapshot.items():
+        montar_snapshot(placa)
+        entregar_snapshot(websockets_aguardando, placa)
+    aguardando_snapshot.clear()
+
+def cancelar_assinatura(websocket):
+    assinaturas.pop(websocket, None)
+    for websockets_aguardando in aguardando_snapshot.values():
+        if websocket in websockets_aguardando:
+            websockets_aguardando.remove(websocket)
+
+async def gravar_amostras_periodicamente():
+    """ Grava as amostras acumuladas uma vez por INTERVALO_GRAVACAO_S. """
+    while True:
+        await asyncio.sleep(INTERVALO_GRAVACAO_S)
+        if not amostras_a_gravar:
+            continue
+        linhas = "".join(registro + "\n" for registro in amostras_a_gravar)
+        amostras_a_gravar.clear()
+        with open(ARQUIVO_AMOSTRAS, "a") as f:
+            f.write(linhas)
+
 # --- FUNÇÃO CORRIGIDA ---
-async def broadcast_para_web(mensagem):
-    """ Envia a mensagem para todos os clientes web conectados usando asyncio.gather. """
-    if CLIENTES_WEB_CONECTADOS:
+async def broadcast_para_web(mensagem, dispositivo=""):
+    """ Envia a mensagem para os clientes web que assinam 'dispositivo' (ou todas as placas)
+    usando asyncio.gather. Sem 'dispositivo', vai para todos. """
+    if assinaturas:
+        destinos = [cliente for cliente, placa in assinaturas.items()
+                    if placa is None or not dispositivo or placa == dispositivo]
         # Cria uma tarefa para cada corotina de envio
-        tasks = [asyncio.create_task(cliente.send(mensagem)) for cliente in CLIENTES_WEB_CONECTADOS]
+        tasks = [asyncio.create_task(cliente.send(mensagem)) for cliente in destinos]
         # Executa todas as tarefas de envio em paralelo
         await asyncio.gather(*tasks, return_exceptions=True)
 
+async def admitir_dashboard(path, request_headers):
+    """ Chamado pelo websockets antes do handshake: recusa com 503 e Retry-After. """
+    if admissao_conexoes.admitir_dashboard():
+        return None
+    espera = round(admissao_conexoes.espera_sugerida_s())
+    return http.HTTPStatus.SERVICE_UNAVAILABLE, [("Retry-After", str(espera))], b"Servidor ocupado\n"
+
 async def manipulador_websocket(websocket, path):
+    registro = RegistroConexao("dashboard", websocket.remote_address, websocket.transport)
+    conexoes_ativas.add(registro)
     CLIENTES_WEB_CONECTADOS.add(websocket)
     log(f"Novo cliente web conectado. Total: {len(CLIENTES_WEB_CONECTADOS)}")
     try:
-        await websocket.wait_closed()
+        # Sem 'await' até o assinar(): nenhuma placa nova passa entre a lista e a assinatura
+        websockets.broadcast([websocket], mensagem_dispositivos())
+        assinar(websocket, parse_qs(urlparse(path).query).get('dispositivo', [None])[0])
+        # Mensagens do dashboard: {"assinar": "<ip da placa>" | null}
+        async for texto in websocket:
+            try:
+                pedido = json.loads(texto)
+                placa = pedido["assinar"]
+            except (ValueError, TypeError, KeyError):
+                continue
+            if placa is None or isinstance(placa, str):
+                assinar(websocket, placa)
+    except websockets.ConnectionClosed:
+        pass
     finally:
+        cancelar_assinatura(websocket)
         CLIENTES_WEB_CONECTADOS.remove(websocket)
+        conexoes_ativas.discard(registro)
         log(f"Cliente web desconectou. Total: {len(CLIENTES_WEB_CONECTADOS)}")
 
 async def manipulador_tcp(reader, writer):
     endereco_cliente = writer.get_extra_info('peername')
+    dispositivo = endereco_cliente[0]
+    conhecida = dispositivo in dispositivos_conhecidos
+    if not admissao_conexoes.admitir_placa(conhecida):
+        # Sem log por conexão recusada (numa tempestade seriam milhares): contam no [CONEXOES]
+        writer.write(f"RETRY={int(admissao_conexoes.espera_sugerida_s(conhecida) * 1000)}\n".encode())
+        writer.close()
+        return
     log(f"RP2040 conectado de: {endereco_cliente}")
+    registro = RegistroConexao("placa", endereco_cliente, writer.transport)
+    conexoes_ativas.add(registro)
+    pendente = b""
     try:
+        await registrar_conexao_placa(dispositivo, True)
         while True:
-            dados = await reader.readline()
+            # Lê o que houver (um lote da placa traz várias linhas) e interpreta tudo de uma vez
+            dados = await reader.read(TAMANHO_LEITURA_TCP)
             if not dados:
                 log("RP2040 desconectou.")
                 break
-            
-            mensagem = dados.decode('utf-8').strip()
-            if not mensagem: # Ignora linhas em branco
-                continue
-                
-            log(f"Recebido do RP2040: {mensagem}")
-            
-            try:
+
+            pendente += dados
+            registros, consumido = interpretar_bloco(pendente)
+            pendente = pendente[consumido:]
+            if len(pendente) > TAMANHO_MAXIMO_LINHA:
+                log(f"!! Linha longa demais sem fim de linha ({len(pendente)} bytes). Descartando.")
+                pendente = b""
+            registro.bytes_pendentes = len(pendente)
+
+            for campos, erro, mensagem in registros:
                 # Verifica se a mensagem é a de boas-vindas para não tentar analisar
                 if "Olá do RP2040!" in mensagem:
-                    await broadcast_para_web(json.dumps({"status": "RP2040 Conectado"}))
+                    log(f"Recebido do RP2040: {mensagem}")
+                    await publicar(json.dumps({"status": "RP2040 Conectado"}))
+                    continue
+
+                if erro:
+                    log(f"!! Erro ao analisar a mensagem: '{mensagem}', erro: {erro}")
+                    continue
+                if not campos:
+                    # Linha só com espaços: ignorada, sem virar amostra vazia nem marcar a placa como conhecida
                     continue
 
-                dados_dict = dict(item.split('=') for item in mensagem.split(' '))
-                dados_dict['VRX'] = int(dados_dict['VRX'])
-                dados_dict['VRY'] = int(dados_dict['VRY'])
-                await broadcast_para_web(json.dumps(dados_dict))
-            except (ValueError, IndexError) as e:
-                log(f"!! Erro ao analisar a mensagem: '{mensagem}', erro: {e}")
+                # Com o joystick no UDP, a linha TCP traz só botões e DHT11
+                await publicar_amostra(Amostra(dispositivo, "tcp", campos))
 
     except Exception as e:
         log(f"!! Erro na conexão TCP: {e}")
     finally:
+        conexoes_ativas.discard(registro)
         writer.close()
+        await registrar_conexao_placa(dispositivo, False)
         await writer.wait_closed()
         log("Conexão com RP2040 fechada.")
 
-async def main():
-    log("Iniciando servidores...")
+fila_amostras_udp = None    # asyncio.Queue criada em main(), consumida por publicar_amostras_udp()
+datagramas_descartados = 0
+
+async def publicar_amostras_udp():
+    """ Único consumidor da fila das duas portas UDP: publica na ordem de chegada, sem
+    uma tarefa por datagrama. """
+    while True:
+        amostra = await fila_amostras_udp.get()
+        try:
+            await publicar_amostra(amostra)
+        except Exception as e:
+            log(f"!! Erro ao publicar amostra UDP de {amostra.dispositivo}: {e}")
+
+class ProtocoloAmostrasUDP(asyncio.DatagramProtocol):
+    """ Recebe datagramas no formato CHAVE=valor e os enfileira como amostras.
+
+    Usado nas duas portas UDP: a do joystick do rosaDosVentosWEB.c (com SEQ, para
+    descartar datagramas atrasados) e a do rosaDosVentos.c do Enunciado 2.
+    A placa é identificada pelo IP de origem, o mesmo da conexão TCP, e todos os
+    canais chegam ao dashboard como um único fluxo por placa.
+    """
+
+    def __init__(self, origem, campos_obrigatorios, fila):
+        self.origem = origem
+        self.campos_obrigatorios = campos_obrigatorios
+        self.fila = fila
+
+    def datagram_received(self, dados, endereco):
+        global datagramas_descartados
+        try:
+            campos = interpretar_registro(dados.decode('utf-8'))
+            if not self.campos_obrigatorios <= campos.keys():
+                raise ValueError(f"faltam campos {self.campos_obrigatorios - campos.keys()}")
+        except (ValueError, UnicodeDecodeError) as e:
+            log(f"!! Datagrama inválido de {endereco[0]}: {dados!r}, erro: {e}")
+            return
+        try:
+            self.fila.put_nowait(Amostra(endereco[0], self.origem, campos))
+        except asyncio.QueueFull:
+            datagramas_descartados += 1
+
+# --- SHARDS TCP ---
+# A leitura e a interpretação das linhas das placas é o que mais consome CPU. Com mais de
+# um shard, cada um é um processo com seu próprio event loop, fixado em um núcleo, e todos
+# escutam a PORTA_TCP com SO_REUSEPORT: o kernel distribui as conexões entre eles.
+# Cada shard tem um socketpair só seu até o processo principal (um produtor e um
+# consumidor, sem trava compartilhada entre shards), por onde passam as amostras já
+# serializadas. O principal fica com o WebSocket, as portas UDP e o arquivo de amostras.
+# No sentido contrário, o principal avisa a todos os shards de cada placa nova
+# ("conhecido\t<ip>\n"), para que a admissão dê prioridade a ela em qualquer shard.
+# As regras rodam só no principal: ele avalia as amostras que chegam dos shards e recebe
+# deles a abertura e o fechamento de cada conexão de placa (CONTROLE_CONECTOU/DESCONECTOU
+# no lugar da origem), de modo que o estado de uma placa não se divide entre shards.
+# Os shards só tiram dele a leitura e a interpretação: o envio a cada dashboard continua
+# no principal, e cada amostra passa a pagar também o socketpair. Só compensa com núcleos
+# livres para os shards; medir com bancada/bancada_ingestao.py --shards 1,2,4,8 (com um
+# único núcleo, 2 a 8 shards gastam ~20% mais CPU por amostra e não entregam mais).
+
+def executar_shard(indice, canal, num_shards):
+    """ Ponto de entrada do processo de um shard. """
+    global PREFIXO_LOG, admissao_conexoes
+    PREFIXO_LOG = f"[shard {indice}] "
+    # Cada shard admite sua parte da taxa; o principal só admite dashboards
+    admissao_conexoes = criar_admissao(num_shards)
+    if hasattr(os, "sched_setaffinity"):
+        nucleos = sorted(os.sched_getaffinity(0))
+        os.sched_setaffinity(0, {nucleos[indice % len(nucleos)]})
+    try:
+        asyncio.run(main_shard(canal))
+    except KeyboardInterrupt:
+        pass
+
+async def main_shard(canal):
+    global canal_principal
+    leitor, canal_principal = await asyncio.open_connection(sock=canal)
     servidor_tcp = await asyncio.start_server(
-        manipulador_tcp, '0.0.0.0', PORTA_TCP)
+        manipulador_tcp, '0.0.0.0', PORTA_TCP, reuse_port=True, backlog=FILA_HANDSHAKES)
+    log(f"Servidor TCP rodando na porta {PORTA_TCP} (pid {os.getpid()})")
+    await asyncio.gather(servidor_tcp.serve_forever(), relatorio_conexoes_periodico(),
+                         receber_do_principal(leitor))
+
+async def receber_do_principal(leitor):
+    """ Em um shard: placas conhecidas pelo processo principal (de qualquer shard ou do UDP). """
+    while True:
+        linha = await leitor.readline()
+        if not linha:
+            return
+        tipo, _, valor = linha.decode().rstrip("\n").partition("\t")
+        if tipo == "conhecido":
+            dispositivos_conhecidos.add(valor)
+
+async def receber_do_shard(indice, canal):
+    """ No processo principal: consome as amostras enviadas por um shard e avalia as regras. """
+    reader, writer = await asyncio.open_connection(sock=canal)
+    canais_shards.append(writer)
+    # O shard pode ter começado depois de placas já conhecidas (UDP ou outro shard)
+    writer.write("".join(f"conhecido\t{dispositivo}\n" for dispositivo in dispositivos_conhecidos).encode())
+    pendente = b""
+    while True:
+        dados = await reader.read(TAMANHO_LEITURA_SHARD)
+        if not dados:
+            log(f"!! Shard {indice} encerrou.")
+            canais_shards.remove(writer)
+            writer.close()
+            return
+        pendente += dados
+        fim = pendente.rfind(b"\n") + 1
+        linhas, pendente = pendente[:fim], pendente[fim:]
+        for linha in linhas.decode().splitlines():
+            dispositivo, origem, registro, mensagem = linha.split("\t", 3)
+            if origem in (CONTROLE_CONECTOU, CONTROLE_DESCONECTOU):
+                await registrar_conexao_placa(dispositivo, origem == CONTROLE_CONECTOU)
+                continue
+            if registro:
+                amostras_a_gravar.append(registro)
+                conhecer_dispositivo(dispositivo)
+            if dispositivo and atualizar_estado(dispositivo, origem, mensagem):
+                await broadcast_para_web(mensagem_dispositivos())
+            await broadcast_para_web(mensagem, dispositivo)
+            if registro and motor_regras.regras:
+                # O registro traz os campos já convertidos e o instante da recepção no shard
+                campos = json.loads(registro)
+                t = campos.pop('t')
+                del campos['dispositivo'], campos['origem']
+                await avaliar_regras(dispositivo, campos, t)
+
+def iniciar_shards(num_shards):
+    """ Cria os processos dos shards; retorna a ponta principal de cada socketpair. """
+    canais = []
+    for indice in range(num_shards):
+        ponta_principal, ponta_shard = socket.socketpair()
+        processo = multiprocessing.Process(
+            target=executar_shard, args=(indice, ponta_shard, num_shards), daemon=True)
+        processo.start()
+        ponta_shard.close()
+        canais.append(ponta_principal)
+    return canais
+
+async def main(num_shards=1):
+    global fila_amostras_udp
+    log(f"Iniciando servidores... (interpretador de telemetria: {implementacao_telemetria()})")
+    iniciar_regras()
+    log(f"{len(motor_regras.regras)} regras carregadas de {ARQUIVO_REGRAS}")
+    tarefas = []
+    if num_shards > 1:
+        log(f"Atendendo as placas via TCP com {num_shards} shards")
+        for indice, canal in enumerate(iniciar_shards(num_shards)):
+            tarefas.append(receber_do_shard(indice, canal))
+    else:
+        servidor_tcp = await asyncio.start_server(
+            manipulador_tcp, '0.0.0.0', PORTA_TCP, backlog=FILA_HANDSHAKES)
+        tarefas.append(servidor_tcp.serve_forever())
+        log(f"Servidor TCP rodando na porta {PORTA_TCP}")
     servidor_websocket = await websockets.serve(
-        manipulador_websocket, "0.0.0.0", PORTA_WEBSOCKET)
-    log(f"Servidor TCP rodando na porta {PORTA_TCP}")
+        manipulador_websocket, "0.0.0.0", PORTA_WEBSOCKET,
+        process_request=admitir_dashboard, backlog=FILA_HANDSHAKES)
+    loop = asyncio.get_running_loop()
+    fila_amostras_udp = asyncio.Queue(TAMANHO_FILA_UDP)
+    await loop.create_datagram_endpoint(
+        lambda: ProtocoloAmostrasUDP("udp-joystick", {'SEQ', 'VRX', 'VRY'}, fila_amostras_udp),
+        local_addr=('0.0.0.0', PORTA_UDP_JOYSTICK))
+    await loop.create_datagram_endpoint(
+        lambda: ProtocoloAmostrasUDP("udp-enunciado2", {'VRX', 'VRY'}, fila_amostras_udp),
+        local_addr=('0.0.0.0', PORTA_UDP_ENUNCIADO_2))
+    log(f"Servidor UDP do joystick rodando na porta {PORTA_UDP_JOYSTICK}")
+    log(f"Servidor UDP do Enunciado 2 rodando na porta {PORTA_UDP_ENUNCIADO_2}")
     log(f"Servidor WebSocket rodando na porta {PORTA_WEBSOCKET}")
     await asyncio.gather(
-        servidor_tcp.serve_forever(),
+        *tarefas,
         servidor_websocket.serve_forever(),
+        publicar_amostras_udp(),
+        gravar_amostras_periodicamente(),
+        relatorio_conexoes_periodico(),
+        vencer_prazos_regras_periodicamente(),
     )
 
 if __name__ == "__main__":
+    num_shards = int(sys.argv[1]) if len(sys.argv) > 1 else NUM_SHARDS_TCP
+    if num_shards == 0:
+        num_shards = os.cpu_count() or 1
     try:
-        asyncio.run(main())
+        asyncio.run(main(num_shards))
     except KeyboardInterrupt:
         print("\nServidor encerrado manualmente.")
@@ -0,0 +1,145 @@
+"""
+Interpretação das linhas de telemetria "CHAVE=valor CHAVE=valor ..." das placas.
+
+Se a biblioteca em C (telemetria/libtelemetria.so, ver telemetria/CMakeLists.txt) estiver
+compilada, os blocos recebidos são interpretados nela em uma única passada, sem criar
+objetos Python por campo intermediário. Sem a biblioteca, usa a versão em Python puro,
+com o mesmo resultado (conferido por telemetria/teste_diferencial.py).
+A variável de ambiente TELEMETRIA_BIBLIOTECA troca o caminho da biblioteca.
+"""
+import ctypes
+import os
+import struct
+
+CAMPOS_INTEIROS = {'VRX', 'VRY', 'BTN', 'A', 'B', 'SEQ'}
+CAMPOS_REAIS = {'TEMP', 'UMI'}
+
+MAX_REGISTROS_POR_CHAMADA = 256
+
+
+def interpretar_registro(texto):
+    """ Converte "VRX=2048 VRY=2048 TEMP=25.0" em {'VRX': 2048, 'VRY': 2048, 'TEMP': 25.0}.
+    Lança ValueError se algum campo estiver malformado. """
+    campos = {}
+    for item in texto.split():
+        chave, separador, valor = item.partition('=')
+        if not separador:
+            raise ValueError(f"campo sem '=': {item}")
+        if chave in CAMPOS_INTEIROS:
+            campos[chave] = int(valor)
+        elif chave in CAMPOS_REAIS:
+            campos[chave] = float(valor)
+        else:
+            campos[chave] = valor
+    return campos
+
+
+def _interpretar_bloco_python(bloco):
+    registros = []
+    inicio = 0
+    while True:
+        fim_linha = bloco.find(b'\n', inicio)
+        if fim_linha < 0:
+            break
+        linha = bloco[inicio:fim_linha].rstrip(b'\r')
+        inicio = fim_linha + 1
+        if not linha:
+            continue
+        texto = linha.decode('utf-8', errors='replace')
+        try:
+            registros.append((interpretar_registro(texto), None, texto))
+        except ValueError as e:
+            registros.append((None, str(e), texto))
+    return registros, inicio
+
+
+# --- BIBLIOTECA EM C (opcional) ---
+class _RegistroTelemetria(ctypes.Structure):
+    # Mesmo layout de registro_telemetria_t (telemetria.h)
+    _fields_ = [
+        ('presentes', ctypes.c_uint32),
+        ('erro', ctypes.c_int32),
+        ('inicio', ctypes.c_uint32),
+        ('tamanho', ctypes.c_uint32),
+        ('seq', ctypes.c_uint32),
+        ('vrx', ctypes.c_int32), ('vry', ctypes.c_int32), ('btn', ctypes.c_int32),
+        ('a', ctypes.c_int32), ('b', ctypes.c_int32),
+        ('temp', ctypes.c_double), ('umi', ctypes.c_double),
+    ]
+
+# Leitura de todos os registros de uma vez (mais barato que acessar campo a campo pelo ctypes)
+_FORMATO_REGISTRO = struct.Struct('<IiIIIiiiiidd')
+
+# (bit de 'presentes', chave), na ordem dos inteiros da struct; a ordem segue a linha enviada pela placa
+_CAMPOS_C = [(1 << 7, 'SEQ'), (1 << 0, 'VRX'), (1 << 1, 'VRY'), (1 << 2, 'BTN'), (1 << 3, 'A'), (1 << 4, 'B')]
+_BIT_TEMP, _BIT_UMI, _BIT_DESCONHECIDO = 1 << 5, 1 << 6, 1 << 8
+_TODOS_OS_CAMPOS_E2 = 0x7F  # VRX, VRY, BTN, A, B, TEMP e UMI, sem SEQ
+_ERROS_C = {1: "campo sem '='", 2: "valor numérico inválido"}
+
+_biblioteca = None
+try:
+    _biblioteca = ctypes.CDLL(os.environ.get('TELEMETRIA_BIBLIOTECA') or os.path.join(
+        os.path.dirname(os.path.abspath(__file__)), 'telemetria', 'libtelemetria.so'))
+    _biblioteca.telemetria_interpretar_bloco.restype = ctypes.c_size_t
+    _biblioteca.telemetria_interpretar_bloco.argtypes = [
+        ctypes.c_void_p, ctypes.c_size_t, ctypes.POINTER(_RegistroTelemetria),
+        ctypes.c_size_t, ctypes.POINTER(ctypes.c_size_t)]
+    _biblioteca.telemetria_implementacao.restype = ctypes.c_char_p
+    _registros_c = (_RegistroTelemetria * MAX_REGISTROS_POR_CHAMADA)()
+except OSError:
+    _biblioteca = None
+
+
+def _interpretar_bloco_c(bloco):
+    registros = []
+    total_consumido = 0
+    consumido = ctypes.c_size_t()
+    # Aponta para dentro de 'bloco' a cada chamada, sem copiar o restante
+    endereco = ctypes.cast(ctypes.c_char_p(bloco), ctypes.c_void_p).value
+    memoria = memoryview(_registros_c).cast('B')
+    while True:
+        quantidade = _biblioteca.telemetria_interpretar_bloco(
+            endereco + total_consumido, len(bloco) - total_consumido,
+            _registros_c, MAX_REGISTROS_POR_CHAMADA, ctypes.byref(consumido))
+        valores = _FORMATO_REGISTRO.iter_unpack(memoria[:quantidade * _FORMATO_REGISTRO.size])
+        for presentes, erro, inicio, tamanho, seq, vrx, vry, btn, a, b, temp, umi in valores:
+            inicio += total_consumido
+            texto = bloco[inicio:inicio + tamanho].decode('utf-8', errors='replace')
+            if erro or presentes & _BIT_DESCONHECIDO:
+                # Erros e chaves fora da lista seguem pelo caminho em Python (mesma mensagem/resultado)
+                try:
+                    registros.append((interpretar_registro(texto), None, texto))
+                except ValueError as e:
+                    registros.append((None, str(e) or _ERROS_C.get(erro, "erro"), texto))
+                continue
+            if presentes == _TODOS_OS_CAMPOS_E2:
+                # Caso comum (linha completa do Enunciado 2/3): monta o dicionário direto
+                campos = {'VRX': vrx, 'VRY': vry, 'BTN': btn, 'A': a, 'B': b, 'TEMP': temp, 'UMI': umi}
+            else:
+                inteiros = (seq, vrx, vry, btn, a, b)
+                campos = {chave: inteiros[i] for i, (bit, chave) in enumerate(_CAMPOS_C) if presentes & bit}
+                if presentes & _BIT_TEMP:
+                    campos['TEMP'] = temp
+                if presentes & _BIT_UMI:
+                    campos['UMI'] = umi
+            registros.append((campos, None, texto))
+        total_consumido += consumido.value
+        if quantidade < MAX_REGISTROS_POR_CHAMADA:
+            return registros, total_consumido
+
+
+def interpretar_bloco(bloco):
+    """ Interpreta as linhas completas de um bloco de bytes.
+
+    Retorna (registros, consumido): cada registro é (campos, erro, texto_da_linha), com
+    campos=None quando a linha é inválida; 'consumido' é quantos bytes foram usados
+    (o restante é uma linha incompleta, a ser completada pela próxima leitura). """
+    if _biblioteca is not None:
+        return _interpretar_bloco_c(bloco)
+    return _interpretar_bloco_python(bloco)
+
+
+def implementacao():
+    if _biblioteca is None:
+        return "python"
+    return "c-" + _biblioteca.telemetria_implementacao().decode()
@@ -0,0 +1,82 @@
+// bancada_telemetria.c
+// Vazão do telemetria_interpretar_bloco em GB/s e linhas/s, sobre um bloco de 64 MB com a
+// mistura de linhas das placas (metade linhas TCP completas, metade datagramas do joystick
+// com SEQ), interpretado em pedaços de TAMANHO_LEITURA bytes como o servidor.py faz.
+//     ./bancada_telemetria [segundos]             (varredura SIMD)
+//     ./bancada_telemetria_escalar [segundos]     (-DTELEMETRIA_SEM_SIMD)
+#include "telemetria.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TAMANHO_BLOCO (64u * 1024 * 1024)
+#define TAMANHO_LEITURA 65536u        // TAMANHO_LEITURA_SHARD do servidor.py
+#define MAX_REGISTROS 256             // MAX_REGISTROS_POR_CHAMADA do telemetria.py
+
+static double agora_s(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static size_t gerar_bloco(char *bloco, size_t capacidade) {
+    size_t tamanho = 0;
+    uint32_t semente = 12345;
+    for (uint32_t seq = 1;; seq++) {
+        semente = semente * 1103515245u + 12345u;
+        char linha[128];
+        int n;
+        if (seq % 2) {
+            n = snprintf(linha, sizeof(linha), "SEQ=%u VRX=%u VRY=%u\n", seq, semente % 4096, (semente >> 12) % 4096);
+        } else {
+            n = snprintf(linha, sizeof(linha), "VRX=%u VRY=%u BTN=%u A=0 B=%u TEMP=%u.%u UMI=%u.%u\n",
+                         semente % 4096, (semente >> 12) % 4096, (semente >> 24) & 1, (semente >> 25) & 1,
+                         15 + (semente >> 8) % 20, semente % 10, 30 + (semente >> 16) % 60, (semente >> 4) % 10);
+        }
+        if (tamanho + (size_t)n > capacidade) return tamanho;
+        memcpy(bloco + tamanho, linha, (size_t)n);
+        tamanho += (size_t)n;
+    }
+}
+
+// Uma passada pelo bloco inteiro; retorna as linhas interpretadas
+static size_t passada(const char *bloco, size_t tamanho, registro_telemetria_t *registros, uint32_t *soma) {
+    size_t linhas = 0;
+    size_t posicao = 0;
+    while (posicao < tamanho) {
+        size_t pedaco = tamanho - posicao < TAMANHO_LEITURA ? tamanho - posicao : TAMANHO_LEITURA;
+        size_t consumido = 0;
+        size_t quantidade = telemetria_interpretar_bloco(bloco + posicao, pedaco, registros, MAX_REGISTROS, &consumido);
+        for (size_t i = 0; i < quantidade; i++) *soma += (uint32_t)registros[i].vrx + registros[i].presentes;
+        linhas += quantidade;
+        if (consumido == 0) break; // Linha incompleta no fim do bloco
+        posicao += consumido;
+    }
+    return linhas;
+}
+
+int main(int argc, char **argv) {
+    double segundos = argc > 1 ? atof(argv[1]) : 3.0;
+    char *bloco = malloc(TAMANHO_BLOCO);
+    registro_telemetria_t *registros = malloc(MAX_REGISTROS * sizeof(*registros));
+    size_t tamanho = gerar_bloco(bloco, TAMANHO_BLOCO);
+    uint32_t soma = 0;
+
+    passada(bloco, tamanho, registros, &soma); // Aquecimento (páginas e cache)
+    size_t passadas = 0, linhas = 0;
+    double inicio = agora_s(), decorrido;
+    do {
+        linhas += passada(bloco, tamanho, registros, &soma);
+        passadas++;
+        decorrido = agora_s() - inicio;
+    } while (decorrido < segundos);
+
+    printf("varredura %s: %.3f GB/s, %.1f M linhas/s (%zu passadas de %.1f MB, linha média de %.1f bytes) [%u]\n",
+           telemetria_implementacao(), passadas * (double)tamanho / decorrido / 1e9, linhas / decorrido / 1e6,
+           passadas, tamanho / 1e6, (double)tamanho * passadas / linhas, soma & 1);
+    free(registros);
+    free(bloco);
+    return 0;
+}
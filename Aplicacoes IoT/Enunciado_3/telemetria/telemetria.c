@@ -0,0 +1,276 @@
+// telemetria.c
+// Compilação da biblioteca usada pelo servidor.py (via ctypes), pelo CMakeLists.txt desta
+// pasta (cmake -S . -B build && cmake --build build) ou diretamente:
+//     gcc -O2 -shared -fPIC -o libtelemetria.so telemetria.c            (SSE2 em x86-64)
+//     gcc -O2 -mavx2 -shared -fPIC -o libtelemetria.so telemetria.c     (AVX2)
+// Em outras arquiteturas a varredura cai automaticamente para a versão escalar.
+#include "telemetria.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(TELEMETRIA_SEM_SIMD)
+#define TELEMETRIA_SIMD "escalar"
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define TELEMETRIA_AVX2
+#define TELEMETRIA_SIMD "avx2"
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define TELEMETRIA_SSE2
+#define TELEMETRIA_SIMD "sse2"
+#else
+#define TELEMETRIA_SIMD "escalar"
+#endif
+
+const char *telemetria_implementacao(void) {
+    return TELEMETRIA_SIMD;
+}
+
+// =================================================================================
+// ==== VARREDURA DE FIM DE LINHA ====
+// =================================================================================
+// Encontra o próximo '\n' comparando 32 (AVX2) ou 16 (SSE2) bytes por instrução.
+// Retorna 'fim' se não houver.
+static const char *procurar_fim_de_linha(const char *p, const char *fim) {
+#if defined(TELEMETRIA_AVX2)
+    const __m256i quebra = _mm256_set1_epi8('\n');
+    while (fim - p >= 32) {
+        __m256i bloco = _mm256_loadu_si256((const __m256i *)p);
+        uint32_t mascara = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bloco, quebra));
+        if (mascara) return p + __builtin_ctz(mascara);
+        p += 32;
+    }
+#elif defined(TELEMETRIA_SSE2)
+    const __m128i quebra = _mm_set1_epi8('\n');
+    while (fim - p >= 16) {
+        __m128i bloco = _mm_loadu_si128((const __m128i *)p);
+        uint32_t mascara = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bloco, quebra));
+        if (mascara) return p + __builtin_ctz(mascara);
+        p += 16;
+    }
+#endif
+    while (p < fim && *p != '\n') p++;
+    return p;
+}
+
+// =================================================================================
+// ==== VARREDURA DOS DELIMITADORES DE CAMPO ====
+// =================================================================================
+// Classifica até 64 bytes de uma linha de uma vez: bit i de '*separadores' = p[i] é ' ' ou
+// '\t'; bit i de '*iguais' = p[i] é '='. Os campos são percorridos depois pelas máscaras
+// (__builtin_ctzll), sem voltar a olhar byte a byte.
+#define TAMANHO_JANELA 64
+
+static void classificar_janela(const char *p, size_t tamanho, uint64_t *separadores, uint64_t *iguais) {
+    uint64_t sep = 0, igual = 0;
+    size_t i = 0;
+#if defined(TELEMETRIA_AVX2)
+    const __m256i espaco = _mm256_set1_epi8(' '), tab = _mm256_set1_epi8('\t'), sinal = _mm256_set1_epi8('=');
+    for (; i + 32 <= tamanho; i += 32) {
+        __m256i bloco = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i s = _mm256_or_si256(_mm256_cmpeq_epi8(bloco, espaco), _mm256_cmpeq_epi8(bloco, tab));
+        sep |= (uint64_t)(uint32_t)_mm256_movemask_epi8(s) << i;
+        igual |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bloco, sinal)) << i;
+    }
+#endif
+#if defined(TELEMETRIA_AVX2) || defined(TELEMETRIA_SSE2)
+    const __m128i espaco16 = _mm_set1_epi8(' '), tab16 = _mm_set1_epi8('\t'), sinal16 = _mm_set1_epi8('=');
+    for (; i + 16 <= tamanho; i += 16) {
+        __m128i bloco = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i s = _mm_or_si128(_mm_cmpeq_epi8(bloco, espaco16), _mm_cmpeq_epi8(bloco, tab16));
+        sep |= (uint64_t)(uint32_t)_mm_movemask_epi8(s) << i;
+        igual |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bloco, sinal16)) << i;
+    }
+#endif
+    for (; i < tamanho; i++) {
+        sep |= (uint64_t)(p[i] == ' ' || p[i] == '\t') << i;
+        igual |= (uint64_t)(p[i] == '=') << i;
+    }
+    *separadores = sep;
+    *iguais = igual;
+}
+
+// Bits de 'i' (inclusive) até 'j' (exclusive), 0 <= i <= j <= 64
+static inline uint64_t bits_entre(size_t i, size_t j) {
+    uint64_t ate_j = j == 64 ? ~0ull : (1ull << j) - 1;
+    return i == 64 ? 0 : ate_j & (~0ull << i);
+}
+
+// =================================================================================
+// ==== CONVERSÃO DE VALORES ====
+// =================================================================================
+// Conversões próprias: os valores não terminam em '\0' e strtol/strtod dependem do locale.
+
+static int ler_inteiro(const char *p, const char *fim, int64_t minimo, int64_t maximo, int64_t *valor) {
+    bool negativo = false;
+    if (p < fim && (*p == '-' || *p == '+')) {
+        negativo = (*p == '-');
+        p++;
+    }
+    if (p == fim || fim - p > 10) return TELEMETRIA_ERRO_NUMERO;
+    int64_t resultado = 0;
+    for (; p < fim; p++) {
+        unsigned digito = (unsigned)(*p - '0');
+        if (digito > 9) return TELEMETRIA_ERRO_NUMERO;
+        resultado = resultado * 10 + digito;
+    }
+    if (negativo) resultado = -resultado;
+    if (resultado < minimo || resultado > maximo) return TELEMETRIA_ERRO_NUMERO;
+    *valor = resultado;
+    return TELEMETRIA_OK;
+}
+
+// Potências de 10 exatas em double (até 10^22)
+static const double POTENCIAS_DE_10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+};
+
+// Com no máximo 15 dígitos a mantissa (< 2^53) e 10^casas são exatas em double, e uma
+// única divisão dá o valor arredondado corretamente: o mesmo que float() do Python.
+static int ler_decimal(const char *p, const char *fim, double *valor) {
+    bool negativo = false;
+    if (p < fim && (*p == '-' || *p == '+')) {
+        negativo = (*p == '-');
+        p++;
+    }
+    int64_t mantissa = 0;
+    int casas = -1;       // -1: ainda não viu o ponto
+    int digitos = 0;
+    for (; p < fim; p++) {
+        if (*p == '.' && casas < 0) {
+            casas = 0;
+            continue;
+        }
+        unsigned digito = (unsigned)(*p - '0');
+        if (digito > 9 || ++digitos > 15) return TELEMETRIA_ERRO_NUMERO;
+        mantissa = mantissa * 10 + digito;
+        if (casas >= 0) casas++;
+    }
+    if (digitos == 0) return TELEMETRIA_ERRO_NUMERO;
+    double resultado = casas > 0 ? (double)mantissa / POTENCIAS_DE_10[casas] : (double)mantissa;
+    *valor = negativo ? -resultado : resultado;
+    return TELEMETRIA_OK;
+}
+
+// =================================================================================
+// ==== INTERPRETAÇÃO DE UMA LINHA ====
+// =================================================================================
+
+static int interpretar_campo(registro_telemetria_t *r, const char *chave, size_t tamanho_chave,
+                             const char *valor, const char *fim_valor) {
+    int64_t inteiro = 0;
+    int erro;
+
+// Compara a chave sem depender de '\0'
+#define CHAVE_IGUAL(literal) (tamanho_chave == sizeof(literal) - 1 && memcmp(chave, literal, sizeof(literal) - 1) == 0)
+
+    if (CHAVE_IGUAL("VRX")) {
+        if ((erro = ler_inteiro(valor, fim_valor, INT32_MIN, INT32_MAX, &inteiro))) return erro;
+        r->vrx = (int32_t)inteiro; r->presentes |= TELEMETRIA_VRX;
+    } else if (CHAVE_IGUAL("VRY")) {
+        if ((erro = ler_inteiro(valor, fim_valor, INT32_MIN, INT32_MAX, &inteiro))) return erro;
+        r->vry = (int32_t)inteiro; r->presentes |= TELEMETRIA_VRY;
+    } else if (CHAVE_IGUAL("BTN")) {
+        if ((erro = ler_inteiro(valor, fim_valor, INT32_MIN, INT32_MAX, &inteiro))) return erro;
+        r->btn = (int32_t)inteiro; r->presentes |= TELEMETRIA_BTN;
+    } else if (CHAVE_IGUAL("A")) {
+        if ((erro = ler_inteiro(valor, fim_valor, INT32_MIN, INT32_MAX, &inteiro))) return erro;
+        r->a = (int32_t)inteiro; r->presentes |= TELEMETRIA_A;
+    } else if (CHAVE_IGUAL("B")) {
+        if ((erro = ler_inteiro(valor, fim_valor, INT32_MIN, INT32_MAX, &inteiro))) return erro;
+        r->b = (int32_t)inteiro; r->presentes |= TELEMETRIA_B;
+    } else if (CHAVE_IGUAL("SEQ")) {
+        if ((erro = ler_inteiro(valor, fim_valor, 0, UINT32_MAX, &inteiro))) return erro;
+        r->seq = (uint32_t)inteiro; r->presentes |= TELEMETRIA_SEQ;
+    } else if (CHAVE_IGUAL("TEMP")) {
+        if ((erro = ler_decimal(valor, fim_valor, &r->temp))) return erro;
+        r->presentes |= TELEMETRIA_TEMP;
+    } else if (CHAVE_IGUAL("UMI")) {
+        if ((erro = ler_decimal(valor, fim_valor, &r->umi))) return erro;
+        r->presentes |= TELEMETRIA_UMI;
+    } else {
+        r->presentes |= TELEMETRIA_DESCONHECIDO;
+    }
+#undef CHAVE_IGUAL
+    return TELEMETRIA_OK;
+}
+
+static int terminar_campo(registro_telemetria_t *r, const char *inicio_campo, const char *igual,
+                          const char *fim_campo) {
+    if (!igual) return TELEMETRIA_ERRO_SEM_IGUAL;
+    return interpretar_campo(r, inicio_campo, (size_t)(igual - inicio_campo), igual + 1, fim_campo);
+}
+
+// A linha é percorrida em janelas de 64 bytes; um campo pode atravessar janelas (só
+// acontece em linhas longas), então o início dele e o primeiro '=' ficam entre uma e outra.
+static void interpretar_linha(registro_telemetria_t *r, const char *p, const char *fim) {
+    const char *inicio_campo = NULL;
+    const char *igual = NULL;
+    for (const char *janela = p; janela < fim; janela += TAMANHO_JANELA) {
+        size_t tamanho = (size_t)(fim - janela) < TAMANHO_JANELA ? (size_t)(fim - janela) : TAMANHO_JANELA;
+        uint64_t separadores, iguais;
+        classificar_janela(janela, tamanho, &separadores, &iguais);
+        uint64_t conteudo = ~separadores & bits_entre(0, tamanho);
+
+        size_t i = 0;
+        while (i < tamanho) {
+            if (!inicio_campo) {
+                // Pula espaços entre os campos
+                uint64_t proximo = conteudo & bits_entre(i, tamanho);
+                if (!proximo) break;
+                i = (size_t)__builtin_ctzll(proximo);
+                inicio_campo = janela + i;
+            }
+            uint64_t depois = separadores & bits_entre(i, tamanho);
+            size_t fim_campo = depois ? (size_t)__builtin_ctzll(depois) : tamanho;
+            uint64_t iguais_no_campo = iguais & bits_entre(i, fim_campo);
+            if (!igual && iguais_no_campo) igual = janela + __builtin_ctzll(iguais_no_campo);
+            if (!depois) break; // O campo continua na próxima janela (ou termina com a linha)
+
+            int erro = terminar_campo(r, inicio_campo, igual, janela + fim_campo);
+            if (erro) {
+                r->erro = erro;
+                return;
+            }
+            inicio_campo = igual = NULL;
+            i = fim_campo;
+        }
+    }
+    if (inicio_campo) {
+        int erro = terminar_campo(r, inicio_campo, igual, fim);
+        if (erro) r->erro = erro;
+    }
+}
+
+// =================================================================================
+// ==== INTERPRETAÇÃO DO BLOCO ====
+// =================================================================================
+
+size_t telemetria_interpretar_bloco(const char *bloco, size_t tamanho,
+                                    registro_telemetria_t *registros, size_t max_registros,
+                                    size_t *consumido) {
+    const char *p = bloco;
+    const char *fim = bloco + tamanho;
+    size_t quantidade = 0;
+
+    while (p < fim && quantidade < max_registros) {
+        const char *fim_linha = procurar_fim_de_linha(p, fim);
+        if (fim_linha == fim) break; // Linha incompleta: fica para a próxima chamada
+
+        // Todos os '\r' do fim, como o rstrip(b'\r') da versão em Python
+        const char *fim_conteudo = fim_linha;
+        while (fim_conteudo > p && fim_conteudo[-1] == '\r') fim_conteudo--;
+        if (fim_conteudo > p) {
+            registro_telemetria_t *r = &registros[quantidade++];
+            memset(r, 0, sizeof(*r));
+            r->inicio = (uint32_t)(p - bloco);
+            r->tamanho = (uint32_t)(fim_conteudo - p);
+            interpretar_linha(r, p, fim_conteudo);
+        }
+        p = fim_linha + 1;
+    }
+
+    *consumido = (size_t)(p - bloco);
+    return quantidade;
+}
@@ -0,0 +1,51 @@
+// telemetria.h
+// Interpretador das linhas de telemetria "CHAVE=valor CHAVE=valor ...\n" enviadas pelas placas:
+//     VRX=2048 VRY=2048 BTN=0 A=0 B=0 TEMP=25.0 UMI=60.0
+//     SEQ=17 VRX=2048 VRY=2048
+// Um bloco com várias linhas é percorrido uma única vez, sem alocação: cada linha completa
+// vira um registro_telemetria_t em um vetor fornecido por quem chama.
+#ifndef TELEMETRIA_H
+#define TELEMETRIA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bits de 'presentes': quais campos apareceram na linha
+#define TELEMETRIA_VRX          (1u << 0)
+#define TELEMETRIA_VRY          (1u << 1)
+#define TELEMETRIA_BTN          (1u << 2)
+#define TELEMETRIA_A            (1u << 3)
+#define TELEMETRIA_B            (1u << 4)
+#define TELEMETRIA_TEMP         (1u << 5)
+#define TELEMETRIA_UMI          (1u << 6)
+#define TELEMETRIA_SEQ          (1u << 7)
+#define TELEMETRIA_DESCONHECIDO (1u << 8)   // Alguma chave fora da lista acima (ignorada)
+
+// Códigos de 'erro' (0 = linha válida)
+#define TELEMETRIA_OK              0
+#define TELEMETRIA_ERRO_SEM_IGUAL  1   // Campo sem '='
+#define TELEMETRIA_ERRO_NUMERO     2   // Valor numérico malformado ou fora da faixa
+
+typedef struct {
+    uint32_t presentes;
+    int32_t erro;
+    uint32_t inicio;        // Posição da linha no bloco (para mensagens de erro)
+    uint32_t tamanho;       // Tamanho da linha, sem o '\n' e os '\r' do fim
+    uint32_t seq;
+    int32_t vrx, vry, btn, a, b;
+    double temp, umi;       // double, como o float do Python: o mesmo valor nos dois caminhos
+} registro_telemetria_t;
+
+// Interpreta as linhas completas (terminadas em '\n') de 'bloco'. Linhas vazias são puladas.
+// Retorna quantos registros foram escritos em 'registros' (no máximo 'max_registros') e
+// coloca em '*consumido' quantos bytes do bloco foram processados; o restante (linha
+// incompleta ou falta de espaço no vetor) deve ser reenviado na próxima chamada.
+size_t telemetria_interpretar_bloco(const char *bloco, size_t tamanho,
+                                    registro_telemetria_t *registros, size_t max_registros,
+                                    size_t *consumido);
+
+// Nome da implementação de varredura compilada ("avx2", "sse2" ou "escalar";
+// -DTELEMETRIA_SEM_SIMD força a escalar)
+const char *telemetria_implementacao(void);
+
+#endif // TELEMETRIA_H
@@ -0,0 +1,112 @@
+"""
+teste_admissao.py
+Confere a admissão de conexões do servidor.py (admissao.py) com um relógio falso: a
+prioridade das placas conhecidas numa tempestade maior que os dois baldes juntos, a
+reserva dos dashboards, a reposição das fichas e a espera sugerida a quem é recusado.
+
+Uso: python teste_admissao.py
+"""
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from admissao import Admissao  # noqa: E402
+
+TAXA, RAJADA = 50, 100
+TAXA_CONHECIDAS, RAJADA_CONHECIDAS = 200, 200
+RESERVA = 20
+ESPERA_MAXIMA_S = 60
+
+
+class Relogio:
+    def __init__(self):
+        self.agora = 1000.0
+
+    def __call__(self):
+        return self.agora
+
+
+def nova_admissao():
+    relogio = Relogio()
+    return Admissao(TAXA, RAJADA, TAXA_CONHECIDAS, RAJADA_CONHECIDAS, RESERVA, ESPERA_MAXIMA_S, relogio), relogio
+
+
+def testar_tempestade_de_conhecidas():
+    """ Mais placas conhecidas que os dois baldes juntos: passam as duas rajadas, depois a
+    soma das taxas; as novas que chegam no meio não tiram fichas das conhecidas. """
+    admissao, relogio = nova_admissao()
+    aceitas = sum(admissao.admitir_placa(conhecida=True) for _ in range(10 * (RAJADA + RAJADA_CONHECIDAS)))
+    assert aceitas == RAJADA + RAJADA_CONHECIDAS, aceitas
+    assert not admissao.admitir_placa(conhecida=False)
+
+    relogio.agora += 1.0
+    assert sum(admissao.admitir_placa(conhecida=False) for _ in range(1000)) == TAXA
+    assert sum(admissao.admitir_placa(conhecida=True) for _ in range(1000)) == TAXA_CONHECIDAS
+
+
+def testar_tempestade_de_novas():
+    """ Placas novas esgotam o balde comum, mas as conhecidas ainda entram pelo delas. """
+    admissao, _ = nova_admissao()
+    assert sum(admissao.admitir_placa(conhecida=False) for _ in range(10 * RAJADA)) == RAJADA
+    assert sum(admissao.admitir_placa(conhecida=True) for _ in range(10 * RAJADA_CONHECIDAS)) == RAJADA_CONHECIDAS
+    assert admissao.aceitas == RAJADA + RAJADA_CONHECIDAS
+    assert admissao.aceitas_conhecidas == RAJADA_CONHECIDAS
+    assert admissao.recusadas == 9 * RAJADA + 9 * RAJADA_CONHECIDAS
+
+
+def testar_reserva_dos_dashboards():
+    admissao, _ = nova_admissao()
+    assert sum(admissao.admitir_dashboard() for _ in range(RAJADA)) == RAJADA - RESERVA
+    # A reserva continua para as placas
+    assert sum(admissao.admitir_placa(conhecida=False) for _ in range(RAJADA)) == RESERVA
+
+
+def testar_reposicao():
+    admissao, relogio = nova_admissao()
+    for _ in range(RAJADA):
+        admissao.admitir_placa(conhecida=False)
+    relogio.agora += 0.5
+    assert sum(admissao.admitir_placa(conhecida=False) for _ in range(RAJADA)) == TAXA // 2
+    # Parado por muito tempo, o balde volta só até a capacidade
+    relogio.agora += 3600
+    assert sum(admissao.admitir_placa(conhecida=False) for _ in range(10 * RAJADA)) == RAJADA
+
+
+def testar_espera_sugerida():
+    admissao, relogio = nova_admissao()
+    assert admissao.espera_sugerida_s() == 1.0
+    recusadas = 2 * TAXA
+    for _ in range(RAJADA + recusadas):
+        admissao.admitir_placa(conhecida=False)
+    assert admissao.espera_sugerida_s() == 1.0 + recusadas / TAXA
+    # As conhecidas recusadas esperam pela fila do balde delas, com a taxa maior
+    for _ in range(RAJADA_CONHECIDAS + recusadas):
+        admissao.admitir_placa(conhecida=True)
+    assert admissao.espera_sugerida_s(conhecida=True) == 1.0 + recusadas / TAXA_CONHECIDAS
+    # A fila virtual anda com a taxa, e a espera tem teto
+    relogio.agora += 1.0
+    assert admissao.espera_sugerida_s() == 1.0 + (recusadas - TAXA) / TAXA
+    for _ in range(100 * TAXA * ESPERA_MAXIMA_S):
+        admissao.admitir_dashboard()
+    assert admissao.espera_sugerida_s() == ESPERA_MAXIMA_S
+
+
+def main():
+    testes = [valor for nome, valor in globals().items() if nome.startswith("testar_")]
+    falhas = 0
+    for teste in testes:
+        try:
+            teste()
+        except AssertionError as e:
+            falhas += 1
+            print(f"{teste.__name__}: falhou {e}", file=sys.stderr)
+    if falhas:
+        print(f"{falhas} de {len(testes)} testes falharam", file=sys.stderr)
+        return 1
+    print(f"admissao: {len(testes)} testes ok")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
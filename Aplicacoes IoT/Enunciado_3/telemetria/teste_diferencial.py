@@ -0,0 +1,116 @@
+"""
+teste_diferencial.py
+Confere que o caminho em C do telemetria.py (libtelemetria.so) dá exatamente o mesmo
+resultado que a versão em Python puro: mesmos registros, mesmos campos, mesmos tipos e
+os mesmos valores (float comparado bit a bit), mesma mensagem de erro e mesmo número de
+bytes consumidos. Os blocos vêm de linhas das placas, de casos de borda conhecidos e de
+mutações aleatórias (bytes especiais, espaços Unicode, dígitos de outros alfabetos...).
+
+Uso: python teste_diferencial.py [caminho/libtelemetria.so] [--rodadas N]
+"""
+import os
+import random
+import struct
+import sys
+
+ARGUMENTOS = [a for a in sys.argv[1:] if not a.startswith('--')]
+if ARGUMENTOS:
+    os.environ['TELEMETRIA_BIBLIOTECA'] = os.path.abspath(ARGUMENTOS[0])
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+import telemetria  # noqa: E402
+
+RODADAS = int(sys.argv[sys.argv.index('--rodadas') + 1]) if '--rodadas' in sys.argv else 20000
+
+CASOS_DE_BORDA = [
+    b"UMI=0.0001", b"TEMP=4294967295", b"TEMP=-0.0", b"TEMP=0.1", b"TEMP=.5", b"TEMP=5.",
+    b"TEMP=999999999999999", b"TEMP=0.000000000000001", b"TEMP=1234567890123456",
+    b"TEMP=1e3", b"TEMP=inf", b"TEMP=nan", b"TEMP=1_0", b"VRX=1_000", b"VRX=+5", b"VRX=-0",
+    b"VRX=2147483648", b"VRX=-2147483649", b"SEQ=4294967296", b"SEQ=-1", b"SEQ=-0",
+    b"VRX=\xd9\xa3", b"VRX=1\xc2\xa0VRY=2", b"VRX=1\x1fVRY=2", b"VRX=1\x0bVRY=2", b"\x0cVRX=1",
+    b"VRX=1\rVRY=2", b"VRX=1 VRX=2", b"VRX=1 VRX=x", b"=5", b"VRX==5", b"VRX", b"VRX=1\xff",
+    b"LUZ=alta VRX=1", b"  \t ", b"VRX=1\t\tVRY=2 \r", b"\r\r", b"VRX=1\r\r", b"VRX=1 \r\r", b" \r\r",
+]
+
+ESPECIAIS = [b"\n", b"=", b" ", b"\t", b"\r", b"\x00", b"-", b"+", b".", b"9", b"_", b"e",
+             b"\xc2\xa0", b"\x1c", b"\x0b", b"\xd9\xa3", b"\xff"]
+
+
+def linha_da_placa(sorteio):
+    if sorteio.random() < 0.5:
+        return (f"SEQ={sorteio.randrange(2**32)} VRX={sorteio.randrange(4096)} "
+                f"VRY={sorteio.randrange(4096)}").encode()
+    return (f"VRX={sorteio.randrange(4096)} VRY={sorteio.randrange(4096)} BTN={sorteio.randrange(2)} "
+            f"A={sorteio.randrange(2)} B={sorteio.randrange(2)} "
+            f"TEMP={sorteio.uniform(-40, 80):.{sorteio.randrange(6)}f} "
+            f"UMI={sorteio.uniform(0, 100):.{sorteio.randrange(6)}f}").encode()
+
+
+def mutar(linha, sorteio):
+    linha = bytearray(linha)
+    for _ in range(sorteio.randrange(1, 4)):
+        posicao = sorteio.randrange(len(linha) + 1)
+        if sorteio.random() < 0.5:
+            linha[posicao:posicao] = sorteio.choice(ESPECIAIS)
+        elif posicao < len(linha):
+            linha[posicao] = sorteio.randrange(256)
+    return bytes(linha)
+
+
+def normalizar(registros):
+    """ Troca os float pelos bits, para comparar -0.0/0.0 e os tipos exatamente. """
+    normalizados = []
+    for campos, erro, texto in registros:
+        if campos is not None:
+            campos = {chave: (type(valor).__name__, struct.pack('<d', valor) if isinstance(valor, float) else valor)
+                      for chave, valor in campos.items()}
+        normalizados.append((campos, erro, texto))
+    return normalizados
+
+
+def comparar(bloco):
+    resultado_c = telemetria.interpretar_bloco(bloco)
+    resultado_python = telemetria._interpretar_bloco_python(bloco)
+    if (normalizar(resultado_c[0]), resultado_c[1]) != (normalizar(resultado_python[0]), resultado_python[1]):
+        for c, p in zip(resultado_c[0], resultado_python[0]):
+            if normalizar([c]) != normalizar([p]):
+                print(f"diferença na linha {p[2]!r}:\n  C:      {c}\n  Python: {p}", file=sys.stderr)
+                break
+        else:
+            print(f"diferença no bloco {bloco!r}: C consumiu {resultado_c[1]}, "
+                  f"Python {resultado_python[1]}", file=sys.stderr)
+        return False
+    return True
+
+
+def main():
+    if telemetria.implementacao() == "python":
+        print("libtelemetria.so não encontrada (compile com o CMakeLists.txt desta pasta)", file=sys.stderr)
+        return 1
+    falhas = sum(not comparar(caso + b"\n") for caso in CASOS_DE_BORDA)
+
+    sorteio = random.Random(20240611)
+    for _ in range(RODADAS):
+        linhas = [linha_da_placa(sorteio) for _ in range(sorteio.randrange(1, 20))]
+        linhas = [mutar(linha, sorteio) if sorteio.random() < 0.3 else linha for linha in linhas]
+        bloco = b"\n".join(linhas)
+        if sorteio.random() < 0.8:
+            bloco += b"\n"
+        if not comparar(bloco):
+            falhas += 1
+            if falhas > 10:
+                break
+
+    # Mais registros do que cabem em uma chamada (MAX_REGISTROS_POR_CHAMADA)
+    bloco = b"".join(linha_da_placa(sorteio) + b"\r\n" for _ in range(3 * telemetria.MAX_REGISTROS_POR_CHAMADA + 7))
+    falhas += not comparar(bloco)
+
+    if falhas:
+        print(f"{falhas} blocos com resultado diferente ({telemetria.implementacao()})", file=sys.stderr)
+        return 1
+    print(f"diferencial ({telemetria.implementacao()}): {RODADAS} blocos iguais ao Python")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
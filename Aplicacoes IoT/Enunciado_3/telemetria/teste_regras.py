@@ -0,0 +1,207 @@
+"""
+teste_regras.py
+Confere o motor de regras do servidor.py (regras.py): a leitura das expressões e do
+arquivo de regras, a taxa entre amostras seguidas, os disparos na borda, as regras com
+"por <N>s" (heap de prazos e o contador de geração que invalida prazos antigos) e o
+descarte do estado da placa com esquecer(), inclusive quando a última conexão TCP dela
+fecha no servidor.py (só se o websockets estiver instalado).
+
+Uso: python teste_regras.py
+"""
+import asyncio
+import os
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from regras import MotorRegras, Regra, carregar_regras  # noqa: E402
+
+
+def motor(*expressoes):
+    return MotorRegras([Regra(f"r{i}", expressao) for i, expressao in enumerate(expressoes)])
+
+
+def estados(eventos):
+    return [(evento['regra'], evento['DISPOSITIVO'], evento['estado']) for evento in eventos]
+
+
+def testar_leitura_das_expressoes():
+    regra = Regra("umidade", "  taxa( UMI )>=-0.5   por 2.5 s ")
+    assert regra.taxa and regra.campo == 'UMI', (regra.taxa, regra.campo)
+    assert regra.limite == -0.5 and regra.duracao == 2.5, (regra.limite, regra.duracao)
+    assert regra.expressao == "taxa( UMI )>=-0.5 por 2.5 s", regra.expressao
+
+    regra = Regra("temperatura", "TEMP != 30")
+    assert not regra.taxa and regra.campo == 'TEMP' and regra.duracao == 0
+    assert regra.comparar(31, regra.limite) and not regra.comparar(30, regra.limite)
+
+    for invalida in ("TEMP > ", "TEMP => 3", "taxa(TEMP > 3", "TEMP > 3 por s", "TEMP > 3 por 2m",
+                     "LUZ > 3", "SEQ > 3", "taxa(LUZ) > 3", "TEMP > 3 TEMP < 5"):
+        try:
+            Regra("r", invalida)
+        except ValueError:
+            continue
+        assert False, f"aceitou {invalida!r}"
+
+
+def testar_arquivo_de_regras():
+    with tempfile.TemporaryDirectory() as diretorio:
+        caminho = os.path.join(diretorio, "regras.txt")
+        assert carregar_regras(caminho) == []
+        with open(caminho, "w", encoding="utf-8") as f:
+            f.write("# comentário\n\nquente: TEMP > 30 por 60s   # fim de linha\nsubindo: taxa(UMI) > 1\n")
+        regras = carregar_regras(caminho)
+        assert [(r.nome, r.campo, r.taxa, r.duracao) for r in regras] == \
+            [("quente", 'TEMP', False, 60.0), ("subindo", 'UMI', True, 0.0)]
+        with open(caminho, "a", encoding="utf-8") as f:
+            f.write("TEMP > 3\n")
+        try:
+            carregar_regras(caminho)
+        except ValueError as e:
+            assert f"{caminho}:5:" in str(e), e
+        else:
+            assert False, "aceitou linha sem nome"
+
+
+def testar_borda_sem_duracao():
+    m = motor("BTN == 1")
+    assert m.avaliar("a", {'BTN': 0}, 1.0) == []
+    assert estados(m.avaliar("a", {'BTN': 1}, 2.0)) == [("r0", "a", "ativado")]
+    # Continua valendo: nenhum evento novo
+    assert m.avaliar("a", {'BTN': 1}, 3.0) == []
+    # Campos sem regra e outras placas não interferem
+    assert m.avaliar("a", {'VRX': 7}, 3.5) == []
+    assert m.avaliar("b", {'BTN': 0}, 3.5) == []
+    eventos = m.avaliar("a", {'BTN': 0, 'TEMP': 20.0}, 4.0)
+    assert estados(eventos) == [("r0", "a", "normalizado")]
+    assert eventos[0]['valor'] == 0 and eventos[0]['t'] == 4.0, eventos[0]
+
+
+def testar_janela_da_taxa():
+    m = motor("taxa(UMI) > 1")
+    # A primeira amostra só abre a janela
+    assert m.avaliar("a", {'UMI': 50.0}, 10.0) == []
+    # (52 - 50) / 4s = 0.5 %/s
+    assert m.avaliar("a", {'UMI': 52.0}, 14.0) == []
+    # (55 - 52) / 2s = 1.5 %/s: a janela é sempre a das duas últimas amostras
+    eventos = m.avaliar("a", {'UMI': 55.0}, 16.0)
+    assert estados(eventos) == [("r0", "a", "ativado")] and eventos[0]['valor'] == 1.5, eventos
+    # Instante repetido não dá taxa (nem divide por zero), mas avança a janela
+    assert m.avaliar("a", {'UMI': 90.0}, 16.0) == []
+    eventos = m.avaliar("a", {'UMI': 90.5}, 17.0)
+    assert estados(eventos) == [("r0", "a", "normalizado")] and eventos[0]['valor'] == 0.5, eventos
+    # Cada placa tem a sua janela
+    assert m.avaliar("b", {'UMI': 0.0}, 17.0) == []
+    assert estados(m.avaliar("b", {'UMI': 10.0}, 18.0)) == [("r0", "b", "ativado")]
+
+
+def testar_duracao_sustentada():
+    m = motor("TEMP > 30 por 60s")
+    assert m.avaliar("a", {'TEMP': 31.0}, 100.0) == []
+    assert len(m.prazos) == 1
+    assert m.vencer_prazos(159.9) == []
+    # Amostras que continuam acima não criam outro prazo
+    assert m.avaliar("a", {'TEMP': 35.0}, 150.0) == []
+    assert len(m.prazos) == 1
+    # O alerta sai no prazo, mesmo sem amostra nova, com o último valor visto
+    eventos = m.vencer_prazos(161.0)
+    assert estados(eventos) == [("r0", "a", "ativado")], eventos
+    assert eventos[0]['t'] == 160.0 and eventos[0]['valor'] == 35.0, eventos[0]
+    assert m.vencer_prazos(1000.0) == [] and not m.prazos
+    assert estados(m.avaliar("a", {'TEMP': 20.0}, 170.0)) == [("r0", "a", "normalizado")]
+
+
+def testar_geracao_invalida_prazo_antigo():
+    m = motor("TEMP > 30 por 60s")
+    m.avaliar("a", {'TEMP': 31.0}, 0.0)
+    # A condição cai e volta: o prazo de t=60 é da geração anterior
+    m.avaliar("a", {'TEMP': 29.0}, 30.0)
+    m.avaliar("a", {'TEMP': 31.0}, 40.0)
+    assert len(m.prazos) == 2
+    assert m.vencer_prazos(99.0) == []
+    assert len(m.prazos) == 1
+    eventos = m.vencer_prazos(100.0)
+    assert estados(eventos) == [("r0", "a", "ativado")] and eventos[0]['t'] == 100.0, eventos
+    # Caiu antes do prazo e não voltou: nada sai, nem "normalizado" (nunca foi ativado)
+    m = motor("TEMP > 30 por 60s")
+    m.avaliar("a", {'TEMP': 31.0}, 0.0)
+    assert m.avaliar("a", {'TEMP': 20.0}, 59.0) == []
+    assert m.vencer_prazos(1000.0) == []
+
+
+def testar_heap_de_prazos_em_ordem():
+    m = motor("TEMP > 30 por 60s", "BTN == 1 por 2s")
+    m.avaliar("a", {'TEMP': 31.0}, 0.0)
+    m.avaliar("b", {'TEMP': 31.0}, 10.0)
+    m.avaliar("c", {'BTN': 1}, 20.0)
+    m.avaliar("d", {'BTN': 1}, 20.0)     # Mesmo instante: o desempate evita comparar as regras
+    eventos = m.vencer_prazos(100.0)
+    assert [(e['DISPOSITIVO'], e['t']) for e in eventos] == \
+        [("c", 22.0), ("d", 22.0), ("a", 60.0), ("b", 70.0)], eventos
+
+
+def testar_esquecer():
+    m = motor("BTN == 1", "TEMP > 30 por 60s", "taxa(UMI) > 1")
+    m.avaliar("a", {'BTN': 1, 'TEMP': 31.0, 'UMI': 50.0}, 0.0)
+    m.avaliar("b", {'BTN': 1}, 0.0)
+    eventos = m.esquecer("a", 10.0)
+    # Só o alerta ativo sai, como "normalizado" e com o motivo
+    assert estados(eventos) == [("r0", "a", "normalizado")], eventos
+    assert eventos[0]['motivo'] == 'placa desconectada' and eventos[0]['t'] == 10.0, eventos[0]
+    assert all("a" not in regra.estados for regra in m.regras)
+    assert "b" in m.regras[0].estados
+    # O prazo pendente da placa que saiu fica sem efeito...
+    assert m.vencer_prazos(100.0) == []
+    # ... e na volta ela começa do zero: a taxa precisa de duas amostras novas
+    assert m.avaliar("a", {'UMI': 90.0}, 200.0) == []
+    assert m.esquecer("desconhecida", 200.0) == []
+
+
+def testar_esquecer_na_ultima_conexao():
+    """ No servidor.py, só a última conexão TCP da placa a fechar descarta o estado. """
+    try:
+        import servidor
+    except ImportError as e:
+        print(f"registrar_conexao_placa não testado: {e}")
+        return
+    publicados = []
+
+    async def publicar_evento(evento):
+        publicados.append(evento)
+
+    servidor.publicar_evento = publicar_evento
+    servidor.motor_regras = m = motor("BTN == 1")
+
+    async def sequencia():
+        # A placa reconecta antes da conexão antiga fechar
+        await servidor.registrar_conexao_placa("a", True)
+        await servidor.registrar_conexao_placa("a", True)
+        m.avaliar("a", {'BTN': 1}, 1.0)
+        await servidor.registrar_conexao_placa("a", False)
+        assert publicados == [] and "a" in m.regras[0].estados
+        await servidor.registrar_conexao_placa("a", False)
+        assert estados(publicados) == [("r0", "a", "normalizado")], publicados
+        assert "a" not in m.regras[0].estados and "a" not in servidor.conexoes_por_placa
+
+    asyncio.run(sequencia())
+
+
+def main():
+    testes = [valor for nome, valor in globals().items() if nome.startswith("testar_")]
+    falhas = 0
+    for teste in testes:
+        try:
+            teste()
+        except AssertionError as e:
+            falhas += 1
+            print(f"{teste.__name__}: falhou {e}", file=sys.stderr)
+    if falhas:
+        print(f"{falhas} de {len(testes)} testes falharam", file=sys.stderr)
+        return 1
+    print(f"regras: {len(testes)} testes ok")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
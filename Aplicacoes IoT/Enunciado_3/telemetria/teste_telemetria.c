@@ -0,0 +1,282 @@
+// teste_telemetria.c
+// Testes do interpretador de telemetria:
+// 1. Casos fixos: linhas das placas, erros, blocos com linha incompleta e vetor cheio.
+// 2. Valores decimais comparados bit a bit com o strtod (arredondamento correto, o mesmo
+//    do float() do Python).
+// 3. Fuzz: linhas válidas geradas com valores conhecidos, mutadas byte a byte, e blocos de
+//    bytes aleatórios; confere os invariantes de cada chamada (compilado com
+//    AddressSanitizer/UBSan pelo CMakeLists.txt, para pegar leituras fora do bloco).
+// A comparação com a versão em Python fica em teste_diferencial.py.
+#include "telemetria.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int g_falhas;
+
+#define VERIFICAR(condicao) do { \
+        if (!(condicao)) { \
+            fprintf(stderr, "%s:%d: falhou: %s\n", __FILE__, __LINE__, #condicao); \
+            g_falhas++; \
+        } \
+    } while (0)
+
+#define MAX_REGISTROS 64
+
+static uint64_t g_semente = 0x9E3779B97F4A7C15ull;
+
+static uint32_t sortear(void) {
+    g_semente ^= g_semente << 13;
+    g_semente ^= g_semente >> 7;
+    g_semente ^= g_semente << 17;
+    return (uint32_t)(g_semente >> 16);
+}
+
+// Interpreta uma única linha (com '\n' acrescentado), em um bloco alocado no tamanho exato
+static registro_telemetria_t interpretar_uma(const char *linha) {
+    size_t tamanho = strlen(linha);
+    char *bloco = malloc(tamanho + 1);
+    memcpy(bloco, linha, tamanho);
+    bloco[tamanho] = '\n';
+    registro_telemetria_t registros[1];
+    size_t consumido = 0;
+    size_t quantidade = telemetria_interpretar_bloco(bloco, tamanho + 1, registros, 1, &consumido);
+    free(bloco);
+    VERIFICAR(quantidade == 1);
+    VERIFICAR(consumido == tamanho + 1);
+    return registros[0];
+}
+
+// Mesmo valor, bit a bit (distingue -0.0 de 0.0)
+static int mesmo_double(double a, double b) {
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+// =================================================================================
+// ==== CASOS FIXOS ====
+// =================================================================================
+
+static void testar_linhas_das_placas(void) {
+    registro_telemetria_t r = interpretar_uma("VRX=2048 VRY=17 BTN=1 A=0 B=1 TEMP=25.3 UMI=60.1");
+    VERIFICAR(r.erro == TELEMETRIA_OK);
+    VERIFICAR(r.presentes == 0x7F);
+    VERIFICAR(r.vrx == 2048 && r.vry == 17 && r.btn == 1 && r.a == 0 && r.b == 1);
+    VERIFICAR(r.temp == 25.3 && r.umi == 60.1);
+
+    r = interpretar_uma("SEQ=4294967295 VRX=-5 VRY=+7");
+    VERIFICAR(r.erro == TELEMETRIA_OK);
+    VERIFICAR(r.presentes == (TELEMETRIA_SEQ | TELEMETRIA_VRX | TELEMETRIA_VRY));
+    VERIFICAR(r.seq == 4294967295u && r.vrx == -5 && r.vry == 7);
+
+    // Separadores repetidos, tabulações e '\r' no fim
+    r = interpretar_uma("  VRX=1\t\tVRY=2 \r");
+    VERIFICAR(r.erro == TELEMETRIA_OK && r.vrx == 1 && r.vry == 2);
+    VERIFICAR(r.tamanho == strlen("  VRX=1\t\tVRY=2 "));
+
+    // Chave desconhecida: marcada, não é erro
+    r = interpretar_uma("VRX=1 LUZ=alta");
+    VERIFICAR(r.erro == TELEMETRIA_OK && (r.presentes & TELEMETRIA_DESCONHECIDO));
+}
+
+static void testar_erros(void) {
+    VERIFICAR(interpretar_uma("VRX=1 VRY").erro == TELEMETRIA_ERRO_SEM_IGUAL);
+    VERIFICAR(interpretar_uma("VRX=").erro == TELEMETRIA_ERRO_NUMERO);
+    VERIFICAR(interpretar_uma("VRX=12a").erro == TELEMETRIA_ERRO_NUMERO);
+    VERIFICAR(interpretar_uma("VRX=2147483648").erro == TELEMETRIA_ERRO_NUMERO);
+    VERIFICAR(interpretar_uma("SEQ=-1").erro == TELEMETRIA_ERRO_NUMERO);
+    VERIFICAR(interpretar_uma("TEMP=.").erro == TELEMETRIA_ERRO_NUMERO);
+    VERIFICAR(interpretar_uma("TEMP=1.2.3").erro == TELEMETRIA_ERRO_NUMERO);
+    VERIFICAR(interpretar_uma("TEMP=1234567890123456").erro == TELEMETRIA_ERRO_NUMERO);
+}
+
+static void testar_blocos(void) {
+    const char *bloco = "VRX=1\n\n\r\nVRX=2\r\nVRX=3";
+    registro_telemetria_t registros[MAX_REGISTROS];
+    size_t consumido = 0;
+    size_t quantidade = telemetria_interpretar_bloco(bloco, strlen(bloco), registros, MAX_REGISTROS, &consumido);
+    // Linhas vazias puladas; "VRX=3" sem '\n' fica para a próxima chamada
+    VERIFICAR(quantidade == 2);
+    VERIFICAR(registros[0].vrx == 1 && registros[1].vrx == 2);
+    VERIFICAR(registros[1].inicio == 9);
+    VERIFICAR(consumido == strlen(bloco) - strlen("VRX=3"));
+
+    // Vetor cheio: para depois do primeiro registro
+    quantidade = telemetria_interpretar_bloco(bloco, strlen(bloco), registros, 1, &consumido);
+    VERIFICAR(quantidade == 1 && consumido == 6);
+
+    // Vários '\r' no fim: todos fora da linha, e a linha só com eles é vazia
+    bloco = "\r\r\nVRX=4\r\r\n";
+    quantidade = telemetria_interpretar_bloco(bloco, strlen(bloco), registros, MAX_REGISTROS, &consumido);
+    VERIFICAR(quantidade == 1 && registros[0].vrx == 4);
+    VERIFICAR(registros[0].inicio == 3 && registros[0].tamanho == strlen("VRX=4"));
+
+    // Campo que atravessa a janela de 64 bytes da varredura
+    char longa[256];
+    int n = snprintf(longa, sizeof(longa), "%*sVRX=%d %*sTEMP=%s", 60, "", 123, 50, "", "0.000000000001");
+    VERIFICAR(n > 128);
+    registro_telemetria_t r = interpretar_uma(longa);
+    VERIFICAR(r.erro == TELEMETRIA_OK && r.vrx == 123 && mesmo_double(r.temp, 1e-12));
+}
+
+// =================================================================================
+// ==== DECIMAIS: MESMO VALOR QUE O strtod ====
+// =================================================================================
+
+static void testar_decimais(void) {
+    // Os dois casos em que o float de 32 bits divergia do Python
+    VERIFICAR(mesmo_double(interpretar_uma("UMI=0.0001").umi, 0.0001));
+    VERIFICAR(mesmo_double(interpretar_uma("TEMP=4294967295").temp, 4294967295.0));
+    VERIFICAR(mesmo_double(interpretar_uma("TEMP=-0.0").temp, -0.0));
+
+    char texto[64], linha[80];
+    for (int i = 0; i < 200000; i++) {
+        // Até 15 dígitos, com o ponto em qualquer posição (ou sem ponto)
+        int digitos = 1 + (int)(sortear() % 15);
+        int ponto = (int)(sortear() % (digitos + 2)) - 1;   // -1 = sem ponto
+        int k = 0;
+        if (sortear() % 4 == 0) texto[k++] = '-';
+        for (int d = 0; d < digitos; d++) {
+            if (d == ponto) texto[k++] = '.';
+            texto[k++] = (char)('0' + sortear() % 10);
+        }
+        if (ponto == digitos) texto[k++] = '.';
+        texto[k] = '\0';
+
+        snprintf(linha, sizeof(linha), "TEMP=%s", texto);
+        registro_telemetria_t r = interpretar_uma(linha);
+        double esperado = strtod(texto, NULL);
+        if (r.erro != TELEMETRIA_OK || !mesmo_double(r.temp, esperado)) {
+            fprintf(stderr, "TEMP=%s: %.17g, esperado %.17g\n", texto, r.temp, esperado);
+            g_falhas++;
+            return;
+        }
+    }
+}
+
+// =================================================================================
+// ==== FUZZ ====
+// =================================================================================
+
+// Confere os invariantes de uma chamada sobre um bloco qualquer
+static void verificar_invariantes(const char *bloco, size_t tamanho, size_t max_registros) {
+    registro_telemetria_t registros[MAX_REGISTROS];
+    size_t consumido = (size_t)-1;
+    size_t quantidade = telemetria_interpretar_bloco(bloco, tamanho, registros, max_registros, &consumido);
+    VERIFICAR(quantidade <= max_registros);
+    VERIFICAR(consumido <= tamanho);
+    VERIFICAR(consumido == 0 || bloco[consumido - 1] == '\n');
+    size_t anterior = 0;
+    for (size_t i = 0; i < quantidade; i++) {
+        const registro_telemetria_t *r = &registros[i];
+        VERIFICAR(r->inicio >= anterior);
+        VERIFICAR(r->inicio + r->tamanho < consumido);
+        VERIFICAR(r->tamanho > 0);
+        VERIFICAR(memchr(bloco + r->inicio, '\n', r->tamanho) == NULL);
+        VERIFICAR(r->erro == TELEMETRIA_OK || r->erro == TELEMETRIA_ERRO_SEM_IGUAL ||
+                  r->erro == TELEMETRIA_ERRO_NUMERO);
+        anterior = r->inicio + r->tamanho;
+    }
+    // Sem espaço no vetor, nada depois do último registro pode ter sido consumido
+    if (quantidade < max_registros) {
+        const char *resto = memchr(bloco + consumido, '\n', tamanho - consumido);
+        VERIFICAR(resto == NULL);
+    }
+}
+
+// Linha válida com valores conhecidos; devolve o registro esperado
+static size_t gerar_linha_valida(char *linha, size_t capacidade, registro_telemetria_t *esperado) {
+    memset(esperado, 0, sizeof(*esperado));
+    esperado->vrx = (int32_t)(sortear() % 4096);
+    esperado->vry = (int32_t)(sortear() % 4096) - 100;
+    int k;
+    if (sortear() % 2) {
+        esperado->seq = sortear();
+        esperado->presentes = TELEMETRIA_SEQ | TELEMETRIA_VRX | TELEMETRIA_VRY;
+        k = snprintf(linha, capacidade, "SEQ=%u VRX=%d VRY=%d", esperado->seq, esperado->vrx, esperado->vry);
+    } else {
+        int temp = (int)(sortear() % 1000) - 200;
+        int umi = (int)(sortear() % 1001);
+        esperado->btn = (int32_t)(sortear() % 2);
+        char texto_temp[16], texto_umi[16];
+        snprintf(texto_temp, sizeof(texto_temp), "%s%d.%d", temp < 0 ? "-" : "", abs(temp) / 10, abs(temp) % 10);
+        snprintf(texto_umi, sizeof(texto_umi), "%d.%d", umi / 10, umi % 10);
+        esperado->temp = strtod(texto_temp, NULL);
+        esperado->umi = strtod(texto_umi, NULL);
+        esperado->presentes = 0x7F;
+        k = snprintf(linha, capacidade, "VRX=%d VRY=%d BTN=%d A=0 B=0 TEMP=%s UMI=%s",
+                     esperado->vrx, esperado->vry, esperado->btn, texto_temp, texto_umi);
+    }
+    return (size_t)k;
+}
+
+static void testar_fuzz(void) {
+    enum { CAPACIDADE = 4096 };
+    char *bloco = malloc(CAPACIDADE);
+
+    for (int rodada = 0; rodada < 20000; rodada++) {
+        // Várias linhas válidas em um bloco, conferidas campo a campo
+        registro_telemetria_t esperados[MAX_REGISTROS];
+        size_t tamanho = 0;
+        size_t linhas = 1 + sortear() % 40;
+        for (size_t i = 0; i < linhas; i++) {
+            tamanho += gerar_linha_valida(bloco + tamanho, CAPACIDADE - tamanho - 2, &esperados[i]);
+            bloco[tamanho++] = '\n';
+        }
+        registro_telemetria_t registros[MAX_REGISTROS];
+        size_t consumido = 0;
+        size_t quantidade = telemetria_interpretar_bloco(bloco, tamanho, registros, MAX_REGISTROS, &consumido);
+        VERIFICAR(quantidade == linhas && consumido == tamanho);
+        for (size_t i = 0; i < quantidade && i < linhas; i++) {
+            const registro_telemetria_t *r = &registros[i], *e = &esperados[i];
+            if (r->erro || r->presentes != e->presentes || r->seq != e->seq || r->vrx != e->vrx ||
+                r->vry != e->vry || r->btn != e->btn || !mesmo_double(r->temp, e->temp) ||
+                !mesmo_double(r->umi, e->umi)) {
+                fprintf(stderr, "linha %zu do bloco %d interpretada errado: %.*s\n", i, rodada,
+                        (int)r->tamanho, bloco + r->inicio);
+                g_falhas++;
+                break;
+            }
+        }
+
+        // O mesmo bloco com alguns bytes trocados (inclusive por '\n', '=', ' ' e '\0'),
+        // cortado em um ponto qualquer e copiado para uma alocação do tamanho exato
+        static const char especiais[] = "\n= \t\r\0-+.9";
+        size_t mutacoes = 1 + sortear() % 8;
+        for (size_t m = 0; m < mutacoes; m++) {
+            size_t posicao = sortear() % tamanho;
+            bloco[posicao] = sortear() % 2 ? especiais[sortear() % (sizeof(especiais) - 1)] : (char)sortear();
+        }
+        size_t corte = sortear() % (tamanho + 1);
+        char *exato = malloc(corte ? corte : 1);
+        memcpy(exato, bloco, corte);
+        verificar_invariantes(exato, corte, 1 + sortear() % MAX_REGISTROS);
+        free(exato);
+
+        // Bytes aleatórios com muitas quebras de linha
+        size_t aleatorio = sortear() % 512;
+        char *ruido = malloc(aleatorio ? aleatorio : 1);
+        for (size_t i = 0; i < aleatorio; i++) {
+            ruido[i] = sortear() % 8 ? (char)sortear() : '\n';
+        }
+        verificar_invariantes(ruido, aleatorio, MAX_REGISTROS);
+        free(ruido);
+
+        if (g_falhas) break;
+    }
+    free(bloco);
+}
+
+int main(void) {
+    testar_linhas_das_placas();
+    testar_erros();
+    testar_blocos();
+    testar_decimais();
+    testar_fuzz();
+    if (g_falhas) {
+        fprintf(stderr, "%d verificações falharam (%s)\n", g_falhas, telemetria_implementacao());
+        return 1;
+    }
+    printf("telemetria (%s): ok\n", telemetria_implementacao());
+    return 0;
+}